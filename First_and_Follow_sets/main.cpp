@@ -3,1181 +3,612 @@
 #endif
 
 #include <iostream>
-#include <vector>
 #include <fstream>
 #include <string>
+#include <vector>
+#include <stdlib.h>
 #include <ctype.h>
-#include <unordered_set>
-#include <signal.h>
 
-#define MAX_LINE_LENGTH 512
+#include "grammar_analyzer.h"
+#include "thread_pool.h"
+#include "ll1_table.h"
+#include "analysis_cache.h"
+#include "output_writer.h"
+#include "lookahead_analysis.h"
+#include "lr_table.h"
+#include "lalr_lookahead.h"
+#include "batch_analysis.h"
+
 
 using namespace std;
 
 //Program to be able to output the FIRST and FOLLOW sets of a given grammar
 //#Acceptted format: "A ::= B | C D | E !" where ! denotes end of productions for the LHS symbol
-//Sequential elements in a sentential form are represented as "<rule> ::= <form1> <form2> " - trailing space followed by '|' or '!'
-
-
-/*
-	FOLLOW SET ALGORITHM
-
-	Loop through every existing production
-	If there is a NT A followed by a symbol b, then everything in FIRST(b) except epsilon,
-	is placed in FOLLOW(A).
-
-	If there is a NT A followed by a symbol b, and FIRST(b) contains epsilon,
-	then everything in the LHS of the production in which A is contained (we'll name that NT X),
-	is in FOLLOW(A). aka X -> Ab && b -> epsilon, then everything in FOLLOW(X) is in FOLLOW(A).
-
-	Same as above if the NT A is the last element in the production.
-	aka X -> bA, then everything in FOLLOW(X) is in FOLLOW(A).
-
-	NOTE: If X -> aAbc where there is an NT A followed by element b (FIRST(b) has epsilon)
-	& element c (FIRST(c) does not have epsilon) then FIRST(b) is placed in FOLLOW(A)
-	& FIRST(c) is placed in FOLLOW(A)
-
-	NOTE 2: in the above example, in the case FIRST(c) also contains epsilon, everything in
-	FOLLOW(X) is in FOLLOW(A).
-*/
-
-//Debug values
-int exec_state = 0;
-int method_state = 0;
-int loop_state = 0;
-bool still_updating = false;
-
-class statement;							//Forward declaration
-class grammar_element;
-class firstSet;
-class followSet;
-class followDataContainer;
-
-/*
-extern "C" void my_function_to_handle_aborts(int signal_number) 
-{
-	cerr << "\n\nProgram execution state: " << exec_state << 
-		" \n| add_symbol method state: "<< method_state << " \n| loop_state: " << loop_state << endl;
-
-	//keep console open
-	cerr << "\n\nAny character key to continue.";
-	char c;
-	cin >> c;
-
-}*/
-
-class grammar_element
-{
-public:
-	grammar_element() {}
-	grammar_element(int i, int t, string v) 
-	{
-		id = i;
-		type = t;
-		value = v;
-	}
-	int id;									//Unique ID
-	int type;								//0 - T, 1 - NT, 2- Unknown
-	string value = "";						//For both, value for T, representation for NT
-	vector<statement> productionList;			//Only for Non-Terminals
-
-	bool operator==(const grammar_element &other) const
-	{
-		return (value == other.value);
-	}
-};
-
-namespace std {
-	template<>
-	struct hash<grammar_element>
-	{
-		size_t operator()(grammar_element const& k) const
-		{
-			return hash<string>()(k.value);
-		}
-	};
-}
+//All of the analysis lives in the GrammarAnalyzer library (grammar_analyzer.h), this is only the command line.
 
-class statement
+struct options
 {
-public:
-	statement() {}
-	statement(grammar_element& s, vector<grammar_element>& v) 
-	{
-		source = s;
-		rhs = v;
-	}
-	grammar_element source;					//The LHS of the production
-	vector<grammar_element> rhs;			//The RHS of the production
-};
-
-class firstSet 
-{
-	public:
-	firstSet() {}
-	firstSet(grammar_element& s, unordered_set<grammar_element>& ss) 
-	{
-		source = s;
-		set_elements = ss;
-	}
-	grammar_element source;
-	unordered_set<grammar_element> set_elements = {};
-	bool operator==(const firstSet &other) const
-	{
-		return (source == other.source);
-	}
+	size_t threads = 1;
+	string terminals = "terminals_input.txt";
+	string grammar = "language_input.txt";
+	string output = "FnF_Sets_Output.txt";	//- means standard output
+	output_format format = OUTPUT_TEXT;
+	output_order order = ORDER_BY_ID;
+	string stats;		//empty means no stats file
+	trace_level trace = TRACE_OFF;
+	string traceOutput;	//empty means std::clog
+	string ll1Header;	//empty means no LL(1) table is generated
+	string ll1Binary;
+	string cache;		//directory of the result cache, empty means no cache
+	size_t lookahead = 0;	//k of FIRST_k and FOLLOW_k, 0 means they aren't computed
+	string lookaheadOutput = "FnF_Lookahead_Output.txt";
+	string slr;			//empty means no SLR(1) table is built
+	string lalr;		//empty means no LALR(1) table is built
+	bool removeUseless = false;	//drop unproductive and unreachable symbols before the analysis
+	string transform;	//empty means the grammar is analysed as loaded
+	string batch;		//directory or manifest of grammars, empty means the single grammar above
+	batch_options batchOptions;
 };
 
-namespace std {
-	template<>
-	struct hash<firstSet>
-	{
-		size_t operator()(firstSet const& k) const
-		{
-			return hash<grammar_element>()(k.source);
-		}
-	};
-}
-class followSet
+//One line with every name, nothing if there are none.
+void print_names(const char* label, const vector<string>& names)
 {
-public:
-	followSet() {}
-	followSet(grammar_element& s,  unordered_set<grammar_element>& ss)
-	{
-		source = s;
-		defined_elements = ss;
-	}
-	grammar_element source;
-	unordered_set<grammar_element> defined_elements = {};
-	unordered_set<grammar_element> undefined_elements = {};
-	bool isDefined() 
+	if (names.empty())
 	{
-		return (undefined_elements.size() == 0 && defined_elements.size() > 0);
+		return;
 	}
-	bool operator==(const followSet &other) const
+	cout << label << ":";
+	for (const string& name : names)
 	{
-		return (source == other.source);
+		cout << " " << name;
 	}
-};
-
-namespace std {
-	template<>
-	struct hash<followSet>
-	{
-		size_t operator()(followSet const& k) const
-		{
-			return hash<grammar_element>()(k.source);
-		}
-	};
+	cout << "\n";
 }
 
-//class content is identical to firstSet, but defining a new class for code readibility.
-class first_plus 
+void print_all_symbol_data(const grammar_analyzer& analyzer)
 {
-public:
-	first_plus() {}
-	first_plus(grammar_element l, unordered_set<grammar_element>& r)
-	{
-		lhs = l;
-		rhs = r;
-	}
-	grammar_element lhs;
-	unordered_set<grammar_element> rhs;
-	bool operator==(const first_plus &other) const
+	const symbol_table& symbols = analyzer.symbols();
+	for (symbol_id id = 0; id < symbols.size(); id++)
 	{
-		return (lhs == other.lhs);
+		string type = "";
+		symbols.type(id) == NONTERMINAL ? type = "NT" : type = "T";
+		cout << "Token ID: " << id << " | type: " << type << " | value: " << symbols.name(id) << endl;
 	}
-};
-
-namespace std {
-	template<>
-	struct hash<first_plus>
-	{
-		size_t operator()(first_plus const& k) const
-		{
-			return hash<grammar_element>()(k.lhs);
-		}
-	};
 }
 
-class followDataContainer
+void print_all_productions(const grammar_analyzer& analyzer)
 {
-public:
-	unordered_set<followSet> undefinedSymbols;
-	unordered_set<followSet> definedSymbols;
-
-	//0 means undef, 1 means def - the return only indicates a set with the same ID(!) is present.
-	bool setContainsElem(int flag, followSet& set);
-
-	//If elems are already in the set, hey are deleted first to update content.
-	void add_symbol_to_symbolsets(followSet& elemRef);
-
-	//Returns true if all symbols are defined.
-	bool updateDefinitions();
-};
-
-bool followDataContainer::setContainsElem(int flag, followSet& set)
-{
-	if (flag == 0)
+	const symbol_table& symbols = analyzer.symbols();
+	const grammar& productions = analyzer.productions();
+	for (symbol_id lhs : symbols.nonterminals())
 	{
-		for (auto& elem : undefinedSymbols)
+		production_range alternatives = productions.productions_of(symbols.index(lhs));
+		size_t production_itr = 0;
+		cout << symbols.name(lhs) << " ::= ";
+		for (production_id p : alternatives)
 		{
-			if (set == elem)
+			for (symbol_id symbol : productions.production(p))
 			{
-				return true;
+				cout << symbols.name(symbol) << " ";
 			}
-		}
-	}
-
-	if (flag == 1)
-	{
-		for (auto& elem : definedSymbols)
-		{
-			if (set == elem)
+			if (production_itr < alternatives.size() - 1)
 			{
-				return true;
+				cout << "\n\t| ";
 			}
+			else
+			{
+				cout << "\n";
+			}
+			production_itr++;
 		}
 	}
-
-	return false;
 }
 
-void followDataContainer::add_symbol_to_symbolsets(followSet& elemRef)
+//The generated header's namespace: the file name without directory and extension, made into an identifier.
+string header_namespace(const string& path)
 {
-	cout << "\n\t\tSymbol to add to followSetData: " << elemRef.source.value << endl;
-	//remove all instances of this element already present.
-	if (setContainsElem(0, elemRef))
-	{
-		undefinedSymbols.erase(undefinedSymbols.find(elemRef));
-		cout << "\t\t" << elemRef.source.value << " erased from undefined." << endl;
-	}
-
-	if (setContainsElem(1, elemRef))
-	{
-		definedSymbols.erase(undefinedSymbols.find(elemRef));
-		cout << "\t\t" << elemRef.source.value << " erased from undefined." << endl;
-	}
-
-	//IF elem is defined
-	if (elemRef.isDefined())
+	size_t from = path.find_last_of("/\\");
+	from = from == string::npos ? 0 : from + 1;
+	size_t to = path.find('.', from);
+	string name = path.substr(from, to == string::npos ? string::npos : to - from);
+	for (char& c : name)
 	{
-		definedSymbols.insert(elemRef);
-		cout << "\t\t" << elemRef.source.value << " inserted in defined." << endl;
-	}
-	//If elem is not defined
-	else
-	{
-		undefinedSymbols.insert(elemRef);
-		cout << "\t\t" << elemRef.source.value << " inserted in undefined." << endl;
-	}
-
-	cout << "\t\t" << "Set status: defined = { ";
-	for (auto& def_elem : elemRef.defined_elements)
-	{
-		cout << def_elem.value << " ";
+		if (!isalnum((unsigned char)c))
+		{
+			c = '_';
+		}
 	}
-	cout << "} | Set status: undefined = { ";
-	for (auto& undef_elem : elemRef.undefined_elements)
+	if (name.empty() || isdigit((unsigned char)name[0]))
 	{
-		cout << undef_elem.value << " ";
+		name = "ll1_" + name;
 	}
-	cout << "}\n";
+	return name;
 }
 
-bool followDataContainer::updateDefinitions()
+//--threads N (0 means one per hardware thread), --terminals, --grammar and --output file names,
+//--format text|json|csv and --order id|name for the output file (see output_writer.h),
+//--stats FILE to also write the timings and counters of the run as JSON, --trace off|summary|updates
+//and --trace-output FILE for the trace of the analysis (see trace_log.h), --ll1-header FILE and
+//--ll1-table FILE to write the LL(1) prediction table as a C++ header or a binary table (see ll1_table.h),
+//--cache DIR to reuse the results of an earlier run on the same grammar (see analysis_cache.h),
+//--lookahead K and --lookahead-output FILE for FIRST_k, FOLLOW_k and the LL(k) conflicts (see lookahead_analysis.h),
+//--slr FILE and --lalr FILE to build the LR(0) automaton and write the SLR(1) or LALR(1) conflicts (see lr_table.h
+//and lalr_lookahead.h), --transform FILE to remove left recursion and left factor the grammar before the analysis
+//and write the result to FILE, --useless keep|remove to drop the unproductive and unreachable symbols first
+//(see grammar_transform.h), --batch DIR|MANIFEST to analyse many grammars at once instead, with --in-flight N
+//of them at a time (0 means one per hardware thread) and their results in --batch-output DIR (see batch_analysis.h).
+//Returns false on anything it doesn't understand.
+bool parse_arguments(int argc, char* argv[], options& opts)
 {
-	followSet currentSet;
-	bool stillUndefined = true;
-	bool update = false;
-	bool debug_out = false;
-	if (exec_state == 4)
+	for (int i = 1; i < argc; i++)
 	{
-		debug_out = true;
-	}
-
-	//For each undefined followSet,
-	for (auto& symbol : undefinedSymbols)
-	{
-		update = false;
-		currentSet = symbol;
-
-		if (debug_out)
+		string arg = argv[i];
+		if (i + 1 >= argc)
+		{
+			return false;
+		}
+		if (arg == "--threads")
 		{
-			cout << "\nFOLLOW(" << symbol.source.value << "):" << endl;
-			cout << "\tUndefined elements: ";
-			loop_state = 1;
-			for (auto& elem : symbol.undefined_elements)
+			char* end;
+			unsigned long value = strtoul(argv[++i], &end, 10);
+			if (*end != '\0' || argv[i][0] == '-')
 			{
-				cout << elem.value << " ";
+				return false;
 			}
+			opts.threads = (size_t)value;
 		}
-
-		//Check each of the undefined elements of that followSet
-		for (auto& elem : symbol.undefined_elements)
+		else if (arg == "--terminals")
 		{
-
-			//check all defined followSets
-			for (auto& defined : definedSymbols)
+			opts.terminals = argv[++i];
+		}
+		else if (arg == "--grammar")
+		{
+			opts.grammar = argv[++i];
+		}
+		else if (arg == "--output")
+		{
+			opts.output = argv[++i];
+		}
+		else if (arg == "--format")
+		{
+			string format = argv[++i];
+			if (format == "text")
 			{
-				//If there is a defined followSet for that undefined element,
-				if (elem == defined.source || elem.value == symbol.source.value)
-				{
-					if (debug_out)
-					{
-						cout << "\n\t" << elem.value << " - DEFINED!\n";
-						loop_state = 3;
-					}
-
-					currentSet.undefined_elements.erase(currentSet.undefined_elements.find(elem));
-					if (elem.value != symbol.source.value)
-					{
-						cout << "\n\tUpdating " << symbol.source.value << "'s defined elements. Adding: \n";
-						//Copy FOLLOW set contents
-						for (auto& def_elem : defined.defined_elements)
-						{
-							cout << "\n\t\t" << def_elem.value << "\n";
-							currentSet.defined_elements.insert(def_elem);
-						}
-					}
-					stillUndefined = currentSet.isDefined();
-					update = true;
-					break;
-				}
+				opts.format = OUTPUT_TEXT;
 			}
-
-
-			if (update)
+			else if (format == "json")
+			{
+				opts.format = OUTPUT_JSON;
+			}
+			else if (format == "csv")
 			{
-				break;
+				opts.format = OUTPUT_CSV;
+			}
+			else
+			{
+				return false;
 			}
 		}
-
-		if (update)
+		else if (arg == "--order")
+		{
+			string order = argv[++i];
+			if (order == "id")
+			{
+				opts.order = ORDER_BY_ID;
+			}
+			else if (order == "name")
+			{
+				opts.order = ORDER_BY_NAME;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		else if (arg == "--stats")
 		{
-			break;
+			opts.stats = argv[++i];
 		}
-
-		//For each undefined element, undef in elem, if undef contains elem in its undefined elements (Confirm circular def)
-		//elem has to change its definition of FOLLOW(undef) in its undefined elements to 
-		//	all the defined elements in FOLLOW(undef) to elem's defined & all its undefined elements to elem's undefined
-		followSet undef_fs = followSet();
-		for (auto& undef_elem : symbol.undefined_elements)
+		else if (arg == "--trace")
 		{
-			for (auto& undef_sym : undefinedSymbols)
+			string level = argv[++i];
+			if (level == "off")
 			{
-				if (undef_elem.value == undef_sym.source.value)
-				{
-					undef_fs = undef_sym;
-					break;
-				}
+				opts.trace = TRACE_OFF;
 			}
-
-			//There was no transitive followset for that undefined element. (aka default constructor value)
-			if (undef_fs.undefined_elements.size() == 0)
+			else if (level == "summary")
 			{
-				//Ignore. Move on.
+				opts.trace = TRACE_SUMMARY;
+			}
+			else if (level == "updates")
+			{
+				opts.trace = TRACE_UPDATES;
 			}
 			else
 			{
-				for (auto& nested : undef_fs.undefined_elements)
-				{
-					if (nested.value == symbol.source.value)
-					{
-						cout << "\n\tUpdating " << symbol.source.value
-							<< "'s elements. Resolving Cyclic defintion on " << undef_elem.value << endl;
-						currentSet.undefined_elements.erase(currentSet.undefined_elements.find(undef_elem));
-						for (auto& undef_fs_def : undef_fs.defined_elements)
-						{
-							currentSet.defined_elements.insert(undef_fs_def);
-						}
-						for (auto& undef_fs_undef : undef_fs.undefined_elements)
-						{
-							//exclude undef_elem if it is here
-							if (undef_fs_undef.value == undef_fs.source.value)
-							{
-								//Exclude
-							}
-							else
-							{
-								currentSet.undefined_elements.insert(undef_fs_undef);
-							}
-						}
-						update = true;
-						break;
-					}
-				}
-				if (update)
-				{
-					break;
-				}
+				return false;
 			}
 		}
-		if (update)
+		else if (arg == "--trace-output")
 		{
-			break;
+			opts.traceOutput = argv[++i];
 		}
-	}
-
-
-	if (update)
-	{
-		if (debug_out)
+		else if (arg == "--ll1-header")
 		{
-			loop_state = 4;
+			opts.ll1Header = argv[++i];
 		}
-		//Old symbol removed, new symbol inserted.
-		add_symbol_to_symbolsets(currentSet);
-		cout << "\n" << currentSet.source.value << " Updated!" << endl;
-		if (debug_out)
+		else if (arg == "--ll1-table")
 		{
-			loop_state = 5;
+			opts.ll1Binary = argv[++i];
 		}
-	}
-	else
-	{
-		cout << "\n\tNo defined element found." << endl;
-	}
-	still_updating = update;
-	return (undefinedSymbols.size() > 0);
-}
-
-
-/*
-	Global Variables - I know its bad practice, but I don't want to add complexity with GCC and creating a makefile
-	===============================================================================================================
-*/
-vector<grammar_element> symbolList;
-unordered_set<firstSet> firstSetData;
-unordered_set<followSet> followSetData;
-//The firstset of the next element in the production, see ruling method.
-firstSet next_element_fsData;
-//The updating set of followData
-followDataContainer dataContainer;
-
-
-
-
-void print_all_symbol_data(vector<grammar_element>& symbolList)
-{
-	for (auto& elem : symbolList)
-	{
-		string type = "";
-		elem.type == 1 ? type = "NT" : type = "T";
-		cout << "Token ID: " << elem.id << " | type: " << type << " | value: " << elem.value << endl;
-	}
-}
-
-void print_all_productions(vector<grammar_element>& symbolList)
-{
-	int itr = 0;
-	int production_itr = 0;
-	int list_length = 0;
-	for (auto& elem : symbolList)
-	{
-		if (elem.id >= 100) 
+		else if (arg == "--cache")
 		{
-			continue;
+			opts.cache = argv[++i];
 		}
-
-		list_length = elem.productionList.size();
-		cout << elem.value << " ::= ";
-		for (auto& production : elem.productionList) 
+		else if (arg == "--lookahead")
 		{
-			for (auto& symbol : production.rhs) 
-			{
-				cout << symbol.value << " ";
-			}
-			if (production_itr < list_length - 1)
-			{
-				cout << "\n\t| ";
-			}
-			else
+			char* end;
+			unsigned long value = strtoul(argv[++i], &end, 10);
+			if (*end != '\0' || argv[i][0] == '-' || value == 0)
 			{
-				cout << "\n";
+				return false;
 			}
-			production_itr++;
+			opts.lookahead = (size_t)value;
 		}
-		production_itr = 0;
-		list_length = 0;
-		itr++;
-	}
-}
-
-//Print followset data to console (intermediate step)
-void print_all_followset_data(unordered_set<followSet>& setData) 
-{
-	for (auto& fset : setData) 
-	{
-		cout << "\nFOLLOW(" << fset.source.value << "):" << endl
-			<< "\n\tUndefined: { ";
-		for (auto& g_elem : fset.undefined_elements) 
+		else if (arg == "--lookahead-output")
 		{
-			cout << g_elem.value << " ";
+			opts.lookaheadOutput = argv[++i];
 		}
-		cout << "}\n\tDefined: { ";
-		for (auto& g_elem : fset.defined_elements) 
+		else if (arg == "--slr")
 		{
-			cout << g_elem.value << " ";
+			opts.slr = argv[++i];
 		}
-		cout << "}\n";
-	}
-}
-
-//Print firstset data to console & output.
-void print_firstSets(unordered_set<firstSet>& setList, ofstream& out)
-{
-	int itr;
-	for (auto& elem : setList)
-	{
-		itr = 0;
-		cout << "Token value: " << elem.source.value << " | FIRST =  { ";
-		out << "Token value: " << elem.source.value << " | FIRST =  { ";
-		for (auto& g_elem : elem.set_elements)
+		else if (arg == "--lalr")
 		{
-			cout << g_elem.value;
-			out << g_elem.value;
-			if (itr != elem.set_elements.size() - 1)
+			opts.lalr = argv[++i];
+		}
+		else if (arg == "--useless")
+		{
+			string useless = argv[++i];
+			if (useless != "keep" && useless != "remove")
 			{
-				cout << ", ";
-				out << ", ";
+				return false;
 			}
-			itr++;
+			opts.removeUseless = useless == "remove";
 		}
-		cout << " }\n";
-		out << " }\n";
-	}
-}
-
-//Print followset data to console & output.
-void print_followSets(unordered_set<followSet>& fData, followDataContainer& dataContainer, ofstream& out)
-{
-	for (auto& fset : fData)
-	{
-		cout << "Token value: " << fset.source.value << " | FOLLOW = { ";
-		out << "Token value: " << fset.source.value << " | FOLLOW = { ";
-		for (auto& elem : fset.defined_elements)
+		else if (arg == "--batch")
 		{
-			cout << elem.value << " ";
-			out << elem.value << " ";
+			opts.batch = argv[++i];
 		}
-		cout << "}" << endl;
-		out << "}" << endl;
-	}
-
-	if (dataContainer.undefinedSymbols.size() != 0)
-	{
-		cout << "\n\n======================= UNRESOLVED ELEMENTS (looping) ========================\n\n";
-		out << "\n\n======================= UNRESOLVED ELEMENTS (looping) ========================\n\n";
-		for (auto& undef_elem : dataContainer.undefinedSymbols)
+		else if (arg == "--batch-output")
+		{
+			opts.batchOptions.outputDirectory = argv[++i];
+		}
+		else if (arg == "--in-flight")
 		{
-			cout << "Undefined symbol: " << undef_elem.source.value << endl;
-			out << "Undefined symbol: " << undef_elem.source.value << endl;
-			for (auto& unresolved : undef_elem.undefined_elements)
+			char* end;
+			unsigned long value = strtoul(argv[++i], &end, 10);
+			if (*end != '\0' || argv[i][0] == '-')
 			{
-				cout << "\tUnresolved element: " << unresolved.value << "\n";
-				out << "\tUnresolved element: " << unresolved.value << "\n";
+				return false;
 			}
-			cout << endl;
-			out << endl;
+			opts.batchOptions.inFlight = (size_t)value;
 		}
-		cout << "\n\n==============================================================================\n\n";
-		out << "\n\n==============================================================================\n\n";
-	}
-}
-
-grammar_element get_elem_by_value(string value, vector<grammar_element>& symbolList)
-{
-	for (grammar_element& elem : symbolList)
-	{
-		if (elem.value == value)
+		else if (arg == "--transform")
 		{
-			return elem;
+			opts.transform = argv[++i];
 		}
-	}
-	return grammar_element(0, 2, "");
-}
-
-grammar_element get_elem_by_ID(int id)
-{
-	for (grammar_element& elem : symbolList)
-	{
-		if (elem.id == id)
+		else
 		{
-			return elem;
+			return false;
 		}
 	}
-	return grammar_element(0, 2, "");
+	return true;
 }
 
-void update_all_grammar(vector<grammar_element>& symbolList) 
+//--batch: only --format, --order and --useless carry over to the grammars of the batch. The summary goes
+//to batch_summary.json next to their results.
+int run_batch_mode(options& opts)
 {
-	//For each element in the list of symbol Data
-	for (auto& elem : symbolList)
+	batch_options& batch = opts.batchOptions;
+	batch.format = opts.format;
+	batch.order = opts.order;
+	batch.removeUseless = opts.removeUseless;
+
+	vector<batch_entry> entries;
+	string error;
+	if (!find_batch_entries(opts.batch, batch, entries, error))
 	{
-		for (auto& production : elem.productionList)
+		cerr << error << "\n";
+		return 1;
+	}
+	vector<batch_result> results;
+	batch_stats stats;
+	run_batch(entries, batch, results, stats);
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		if (!results[i].error.empty())
 		{
-			for (auto& symbol : production.rhs)
-			{
-				symbol = get_elem_by_value(symbol.value, symbolList);
-			}
+			cerr << results[i].error << "\n";
 		}
 	}
-}
-
 
-vector<grammar_element> add_all_terminals(ifstream& in) 
-{
-	vector<grammar_element> elementList = {};
-	char line[30];		//Smaller line limit for terminal representations.
-	string str;
-	int id = 100;
-
-	while (in.getline(line, 30)) 
+	string summaryPath = batch.outputDirectory + "/batch_summary.json";
+	output_writer summary;
+	if (!summary.open(summaryPath.c_str(), error))
 	{
-		str = string(line);
-		elementList.push_back(grammar_element(id, 0, str));
+		cerr << error << "\n";
+		return 1;
 	}
-
-	return elementList;
+	write_batch_summary(summary, entries, results, stats);
+	if (!summary.close())
+	{
+		cerr << summaryPath << ": write failed\n";
+		return 1;
+	}
+	cout << "Batch: " << entries.size() << " grammars, " << stats.failed << " failed, " << stats.inFlight << " at a time, "
+		<< stats.seconds << "s, peak " << (stats.peakMemory >> 20) << " MiB\n";
+	return stats.failed == 0 ? 0 : 1;
 }
 
-//Compute all first sets for list of symbols, uses recursive call.
-firstSet compute_first_sets(grammar_element& param)
+int main(int argc, char* argv[])
 {
-	firstSet fst = firstSet(param, unordered_set<grammar_element>());
-	bool epsilonEncountered = false;
-	grammar_element updated_elem;
-	firstSet elementFirstSet;
-
-	if (param.type == 0) 
-	{
-		fst.set_elements.insert(param);
+	options opts;
+	if (!parse_arguments(argc, argv, opts))
+	{
+		cerr << "usage: " << argv[0] << " [--threads N] [--terminals FILE] [--grammar FILE] [--output FILE|-] [--stats FILE]\n"
+			<< "       [--format text|json|csv] [--order id|name]\n"
+			<< "       [--trace off|summary|updates] [--trace-output FILE] [--ll1-header FILE] [--ll1-table FILE]\n"
+			<< "       [--cache DIR] [--lookahead K] [--lookahead-output FILE] [--slr FILE] [--lalr FILE]\n"
+			<< "       [--useless keep|remove] [--transform FILE]\n"
+			<< "       [--batch DIR|MANIFEST] [--batch-output DIR] [--in-flight N]\n";
+		return 1;
 	}
-	else 
+	if (!opts.batch.empty())
 	{
-		//For each production in the selected element. - note elements need to be updated before use.
-		for (auto& production : param.productionList) 
-		{
-			epsilonEncountered = false;
-			//For each element in the production
-			for (auto& elem : production.rhs) 
-			{
-				unordered_set<firstSet>::iterator ptr;
-				updated_elem = get_elem_by_value(elem.value, symbolList);
-				//Get the FIRST of the current element.
-				//check if its present in firstSetData first - 'first'... haha
-
-				ptr = firstSetData.find(firstSet(updated_elem,unordered_set<grammar_element>()));
-				//If the element was not found/defined already.
-				if (ptr == firstSetData.end()) 
-				{
-					elementFirstSet = compute_first_sets(updated_elem);
-				}
-				else 
-				{
-					elementFirstSet = *ptr;
-				}
-				//Determine if this FIRST contains epsilon,
-				if (elementFirstSet.set_elements.count(get_elem_by_value("epsilon", symbolList)))
-				{
-					epsilonEncountered = true;
-				}
-				else 
-				{
-					epsilonEncountered = false;
-				}
-				//Add FIRST(elem) to FIRST(param) excluding epsilon.
-				for (auto& fst_elem : elementFirstSet.set_elements) 
-				{
-					if (fst_elem.value != "epsilon") 
-					{
-						fst.set_elements.insert(fst_elem);
-					}
-				}
-				//If epsilon was encountered, proceed to the next loop iteration
-				if (epsilonEncountered == false) 
-				{
-					break;
-				}
-			}
-			//If epsilon was encountered until the end, add epsilon to firstSet(param).
-			if (epsilonEncountered) 
-			{
-				fst.set_elements.insert(get_elem_by_value("epsilon", symbolList));
-			}
-		}	
+		return run_batch_mode(opts);
 	}
-	firstSetData.insert(fst);
-	cout << "\n\tfirstSetData.insert(" << fst.source.value << ")";
-	return fst;
-}
+	//Declared before the analyzer so it outlives the analyzer's trace buffer.
+	ofstream traceFile;
+	thread_pool pool(opts.threads);
+	grammar_analyzer analyzer(&pool);
 
-
-//pos represents what position currentElem is within the RHS of the production, zero-based
-/*
-	Rules:
-	 - 0 current is a T
-	 - 1 current is a NT and is the last element.
-	 - 2 current is a NT and is followed by a element with epsilon in its FIRST.
-	 - 3 current is a NT and is followed by a element without epsilon in its FIRST
-
-*/
-int get_algorithm_ruling(statement& production, grammar_element& currentElem, int pos) 
-{
-	int result = 0;
-	bool lastElement = (production.rhs.size() - 1 == pos);
-	grammar_element next;
-	bool hasEpsilon = false;
-	cout << "\n\t\tRHS size = " << production.rhs.size() << " | pos = " << pos << endl;
-
-	if (currentElem.type == 0) 
+	string error;
+	if (!analyzer.load(opts.terminals.c_str(), opts.grammar.c_str(), error))
 	{
-		return 0;
+		cerr << error << "\n";
+		return 1;
 	}
+	cout << "Parsing complete!\n";
 
-	cout << "\n\t\tlastElement: " << (bool)lastElement;
-
-	if (lastElement) 
+	for (symbol_id id : analyzer.undeclared())
 	{
-		return 1;
+		cout << "\nWarning: '" << analyzer.symbols().name(id) << "' is not a declared terminal or nonterminal, treating it as a terminal.";
 	}
-	else 
+	cout << "\nUpdating complete!\n";
+
+	if (opts.removeUseless)
 	{
-		next = production.rhs[pos + 1];
+		const useless_stats& stats = analyzer.remove_useless();
+		cout << "\nRemoved useless symbols: " << stats.productionsBefore << " -> " << stats.productionsAfter << " productions, "
+			<< stats.unproductive.size() << " unproductive and " << stats.unreachable.size() << " unreachable nonterminals, "
+			<< stats.unusedTerminals.size() << " unused terminals kept\n";
+		print_names("Unproductive", stats.unproductive);
+		print_names("Unreachable", stats.unreachable);
+		print_names("Unused terminals (kept)", stats.unusedTerminals);
+		if (stats.emptyLanguage)
+		{
+			cout << "Warning: the start symbol is unproductive, the grammar derives no sentence at all\n";
+		}
 	}
 
-	//Check if next's FIRST contains epsilon
-	for (auto& fset : firstSetData) {
-		if (fset.source == next)
+	if (!opts.transform.empty())
+	{
+		const transform_stats& stats = analyzer.transform();
+		cout << "\nTransformed grammar: " << stats.productionsBefore << " -> " << stats.productionsAfter << " productions, "
+			<< stats.directRecursive + stats.indirectCycles << " left recursive cycles removed (" << stats.unresolvedCycles << " left alone), "
+			<< stats.factoredPrefixes << " common prefixes factored, " << stats.newNonterminals << " new nonterminals\n";
+		output_writer grammarFile;
+		if (!grammarFile.open(opts.transform.c_str(), error))
+		{
+			cerr << error << "\n";
+			return 1;
+		}
+		write_grammar(grammarFile, analyzer);
+		if (!grammarFile.close())
 		{
-			next_element_fsData = fset;
-			cout << " | next = " << next.value;
-			break;
+			cerr << opts.transform << ": write failed\n";
+			return 1;
 		}
 	}
 
-	hasEpsilon = next_element_fsData.set_elements.count(get_elem_by_value("epsilon", symbolList));
-	if (hasEpsilon)
+	output_writer ofile;
+	if (opts.output == "-")
 	{
-		result = 2;
+		ofile.attach(1);
 	}
-	else
+	else if (!ofile.open(opts.output.c_str(), error))
 	{
-		result = 3;
+		cerr << error << "\n";
+		return 1;
 	}
-	cout << " | next contains epsilon? : " << hasEpsilon << endl;
-	
-	return result;
-}
-
 
-//Compute all follow sets for list of symbols, uses recursive call.
-unordered_set<followSet> compute_follow_sets()
-{
-	exec_state = 1;
-	//Data is ordered in symbol id-1
-	vector<followSet> data = {};
-	unordered_set<grammar_element> temp_set;
-	
-	//Initialise all symbol followSets
-	for (auto& symbol : symbolList) 
+	if (opts.trace != TRACE_OFF)
 	{
-		if (symbol.type == 1) 
+		if (!opts.traceOutput.empty())
 		{
-			if (symbol.value == "goal") 
-			{
-				temp_set.insert(grammar_element(get_elem_by_value("$", symbolList)));
-				data.push_back(followSet(symbol, temp_set));
-			}
-			else 
+			traceFile.open(opts.traceOutput, ios::trunc);
+			if (!traceFile)
 			{
-				data.push_back(followSet(symbol, unordered_set<grammar_element>()));
+				cerr << opts.traceOutput << ": can't open for writing\n";
+				return 1;
 			}
 		}
+		analyzer.set_trace(traceFile.is_open() ? (ostream*)&traceFile : &clog, opts.trace);
 	}
-
-
-	int itr = 0;
-	int offset = 0;
-	int rule = 0;
-	method_state = 0;
-
-	for (auto& symbol : symbolList)
+	//The cache file is named after the grammar's content hash, so a file that is there is either the
+	//right one or damaged, and read_cache tells which. A damaged one is said so, then recomputed and rewritten.
+	string cachePath = opts.cache.empty() ? string() : analysis_cache_path(opts.cache, analyzer.content_hash());
+	bool cached = !cachePath.empty() && ifstream(cachePath).good();
+	if (cached && analyzer.read_cache(cachePath.c_str(), error))
 	{
-		for (auto& production : symbol.productionList) 
+		cout << "\nLoaded FIRST and FOLLOW data from " << cachePath << "!";
+	}
+	else
+	{
+		if (cached)
 		{
-			cout << "\n\n" << symbol.value << " ::= ";
-			//Printing Loop
-			for (auto& elem : production.rhs)
-			{
-				cout << elem.value << " ";
-			}
-
-			itr = 0;
-			for (auto& g_elem : production.rhs) 
-			{
-				cout << "\n\tChecking: " << g_elem.value << endl;
-
-				offset = 0;
-				//Get ruling for current iterator value of production.
-				rule = get_algorithm_ruling(production, g_elem, itr);
-				cout << "\n\t\tRule: " << rule << " applied." << endl;
-				switch (rule)
-				{
-				case 0: //T
-					break;
-				case 1: //NT & last
-					cout << "\n\t\t\tEverything in FOLLOW(" << production.source.value
-						<< "), is placed in FOLLOW(" << data[g_elem.id - 1].source.value << ")" << endl;
-					data[g_elem.id - 1].undefined_elements.insert(production.source);
-					break;
-				case 2: //NT followed by epsilon
-					//Done the first time at least
-					while (rule == 2) 
-					{
-						cout << "\n\t\t\tAll in FIRST(" << next_element_fsData.source.value
-							<< "), except epsilon, placed in FOLLOW(" << data[g_elem.id - 1].source.value << ")" << endl;
-						for (auto& next_elements : next_element_fsData.set_elements)
-						{
-							if (next_elements.value == "epsilon")
-							{
-								//Ignore.
-							}
-							else
-							{
-								data[g_elem.id - 1].defined_elements.insert(next_elements);
-							}
-						}
-						offset++;
-						//Get the ruling of current iterator + offset elements ahead, current position in production is iterator + offset.
-						//We set the next firstSet data of the offset element to be added to the current iterator element.
-						rule = get_algorithm_ruling(production, production.rhs[itr + offset], itr + offset);
-					}
-					//Check other rule values resulting and apply appropriate behaviour
-					if (rule == 1) 
-					{
-						cout << "\n\t\t\tEverything in FOLLOW(" << production.source.value
-							<< "), is placed in FOLLOW(" << data[g_elem.id - 1].source.value << ")" << endl;
-						data[g_elem.id - 1].undefined_elements.insert(production.source);
-					}
-					else if (rule == 0 ||rule == 3) 
-					{
-						cout << "\n\t\t\tAll in FIRST(" << next_element_fsData.source.value
-							<< ") placed in FOLLOW(" << data[g_elem.id - 1].source.value << ")" << endl;
-						for (auto& next_elements : next_element_fsData.set_elements)
-						{
-							data[g_elem.id - 1].defined_elements.insert(next_elements);
-						}
-					}
-					else 
-					{
-						//ignore terminal as current element.
-					}
-					break;
-				case 3: //NT not followed by epsilon.
-					cout << "\n\t\t\tAll in FIRST(" << next_element_fsData.source.value
-						<< ") placed in FOLLOW(" << data[g_elem.id - 1].source.value << ")" << endl;
-					for (auto& next_elements : next_element_fsData.set_elements)
-					{
-						data[g_elem.id - 1].defined_elements.insert(next_elements);
-					}
-					break;
-				}
-
-				//Only print contents on productions.
-				if (g_elem.type == 1)
-				{
-					//print the set contents after each loop
-					cout << "\n\t\t\tElement: " << g_elem.value << "= defSet: { ";
-					for (auto& dset_elem : data[g_elem.id - 1].defined_elements)
-					{
-						cout << dset_elem.value << " ";
-					}
-					cout << "} | undefSet: { ";
-					for (auto& udset_elem : data[g_elem.id - 1].undefined_elements)
-					{
-						cout << udset_elem.value << " ";
-					}
-					cout << "}" << endl;
-				}
-				itr++;
-			}
+			cerr << error << ", recomputing\n";
+		}
+		analyzer.compute();
+		cout << "\nComputing FIRST and FOLLOW data complete!";
+		if (!cachePath.empty() && !analyzer.write_cache(cachePath.c_str(), error))
+		{
+			cerr << error << "\n";
 		}
 	}
 
+	//print_all_productions(analyzer);
 
-	exec_state = 2;
-	cout << "\n\nAll symbols processed, adding to data container." << endl;
-	//We add all the symbols follow data to dataContainer for refinement / definition resolution.
-	for (auto& elem : data) 
+	//The report goes to the console too, unless the output file already is the console.
+	cout.flush();
+	if (opts.output != "-")
 	{
-		dataContainer.add_symbol_to_symbolsets(elem);
-		exec_state = 3;
+		output_writer console;
+		console.attach(1);
+		write_results(console, analyzer, OUTPUT_TEXT, opts.order);
 	}
-
-	exec_state = 4;
-	cout << "\n\n================== UNDEFINED FOLLOWSETS ===================\n\n";
-	print_all_followset_data(dataContainer.undefinedSymbols);
-	cout << "\n\n=================== DEFINED FOLLOWSETS ====================\n\n";
-	print_all_followset_data(dataContainer.definedSymbols);
-
-	/*
-	//keep console open
-	cout << "\n\nAny character key to continue.";
-	char c;
-	cin >> c;
-	*/
-
-	while (dataContainer.updateDefinitions()) 
+	write_results(ofile, analyzer, opts.format, opts.order);
+	if (!ofile.close())
 	{
-		//Break if there is no update in data (a cycle occurs)
-		if (still_updating == false)
-		{
-			break;
-		}
+		cerr << opts.output << ": write failed\n";
+		return 1;
 	}
 
-	/*
-	//keep console open
-	cout << "\n\nComplete! Any character key to continue.";
-	cin >> c;
-	*/
-
-	return dataContainer.definedSymbols;
-}
-
-//We assume all LHS's FOLLOW and FIRSTS are defined. -  we dont check for disjointness (we know its not LL(1))
-unordered_set<first_plus> compute_firstPlusSets(unordered_set<firstSet>& first_data, unordered_set<followSet>& follow_data) 
-{
-	first_plus fp_elem;
-	unordered_set<grammar_element> productionFirstPlusSet;
-	unordered_set<first_plus> result;
-
-	for (auto& symbol : symbolList) 
+	if (!opts.ll1Header.empty() || !opts.ll1Binary.empty())
 	{
-		//If terminal skip
-		if (symbol.type == 0) 
+		ll1_table table;
+		table.build(analyzer);
+		cout << "\nLL(1) table: " << table.view().entryCount << " cells for " << table.view().nonterminalCount << " x "
+			<< table.view().terminalCount << ", " << table.distinct_rows() << " distinct rows\n";
+		if (!opts.ll1Header.empty())
 		{
-			continue;
+			ofstream header(opts.ll1Header, ios::trunc);
+			if (!header)
+			{
+				cerr << opts.ll1Header << ": can't open for writing\n";
+				return 1;
+			}
+			table.write_header(header, header_namespace(opts.ll1Header));
+			header.close();
+			if (!header)
+			{
+				cerr << opts.ll1Header << ": write failed\n";
+				return 1;
+			}
 		}
-
-		bool productionIsNullable = true;
-		firstSet temp = firstSet();
-		followSet tempFollow = followSet();
-		fp_elem = first_plus();
-		fp_elem.lhs = symbol;
-		productionFirstPlusSet = unordered_set<grammar_element>();
-
-		//Check all productions of this NT
-		for (auto& production : symbol.productionList) 
+		if (!opts.ll1Binary.empty())
 		{
-			productionIsNullable = true;
-
-			//For each symbol in this production
-			for (auto& elem : production.rhs) 
+			ofstream binary(opts.ll1Binary, ios::trunc | ios::binary);
+			if (!binary)
 			{
-				//We can search using a firstSet with only the source defined as only source is matched in Hash
-				temp = *first_data.find(firstSet(elem, unordered_set<grammar_element>()));
-
-				//Hash for grammar_element also matches by string value, count returns 0 or 1 (not present/present)
-				//If Nullable and no epsilon is in temp's FIRST, set nullable to False.
-				if (productionIsNullable && temp.set_elements.count(grammar_element(0, 0, "epsilon")) == 0)
-				{
-					productionIsNullable = false;
-				}
-				
-				//Add all elements that are not epsilon from this elem's (temp) FIRST into our FirstPlus (fp_elem)
-				for (auto& f_elem : temp.set_elements) 
-				{
-					if (f_elem.value != "epsilon") 
-					{
-						productionFirstPlusSet.insert(f_elem);
-					}
-				}
-
-				//If the production is no longer Nullable, we don't keep reading in FIRST sets for this production.
-				if (productionIsNullable == false) 
-				{	
-					break;
-				}
+				cerr << opts.ll1Binary << ": can't open for writing\n";
+				return 1;
 			}
-
-			//At the end of adding all the FIRSTs, if the production is nullable then we add the LHS's FOLLOW
-			if (productionIsNullable)
+			table.write_binary(binary);
+			binary.close();
+			if (!binary)
 			{
-				//We can search using a followSet with only the source defined as only source is matched in Hash
-				tempFollow = *follow_data.find(followSet(symbol, unordered_set<grammar_element>()));
-				//We assume all symbols are in defined.
-				for (auto& f_elem : tempFollow.defined_elements)
-				{
-					productionFirstPlusSet.insert(f_elem);
-				}
+				cerr << opts.ll1Binary << ": write failed\n";
+				return 1;
 			}
 		}
-		//At the end of the all productions for a symbol, we save the set of elements in First+(LHS) to a set of First+ to return.
-		fp_elem.rhs = productionFirstPlusSet;
-		result.insert(fp_elem);
 	}
-	return result;
-}
 
-void print_all_firstPlus(unordered_set<first_plus> data, ofstream& out)
-{
-	for (auto& fp_elem : data) 
+	if (opts.lookahead != 0)
 	{
-		cout << "\nFIRST_PLUS(" << fp_elem.lhs.value << ") = { ";
-		out << "\nFIRST_PLUS(" << fp_elem.lhs.value << ") = { ";
-		for (auto& elem : fp_elem.rhs) 
+		lookahead_analysis lookahead(opts.lookahead);
+		lookahead.compute(analyzer.symbols(), analyzer.productions());
+		const lookahead_stats& stats = lookahead.stats();
+		cout << "\nFIRST_" << opts.lookahead << " and FOLLOW_" << opts.lookahead << ": " << stats.sequences << " sequences, "
+			<< stats.setEntries << " set entries, " << stats.llkConflicts << " LL(" << opts.lookahead << ") conflicts left of "
+			<< analyzer.ll1_conflicts().size() << " LL(1)\n";
+		output_writer lookaheadFile;
+		if (!lookaheadFile.open(opts.lookaheadOutput.c_str(), error))
+		{
+			cerr << error << "\n";
+			return 1;
+		}
+		write_lookahead(lookaheadFile, analyzer, lookahead, opts.order);
+		if (!lookaheadFile.close())
 		{
-			cout << elem.value << " ";
-			out << elem.value << " ";
+			cerr << opts.lookaheadOutput << ": write failed\n";
+			return 1;
 		}
-		cout << "}";
-		out << "}";
 	}
-	cout << endl;
-}
-
-
-int main() 
-{
-	//Debugging message for Abort()
-	//signal(SIGABRT, &my_function_to_handle_aborts);
-
-	int id_itr = 1;		//Value of 0 will be an identifier for unset.
-
-	ofstream ofile;
-	ofile.open("FnF_Sets_Output.txt", ios::trunc);
-
-	ifstream ifile;
-	ifile.open("language_input.txt");
-	char line[MAX_LINE_LENGTH];
-	string str;
-
-	ifstream terminalsIn;
-	terminalsIn.open("terminals_input.txt");
-
-	//SymbolList becomes populated with filled symboldata and productions whos rhs' are grammar_element(0,2, buffer).
-	symbolList = add_all_terminals(terminalsIn);
 
-	bool lhs_symbol_found = false;
-	bool production_arrow_found = false;
-	string buffer = "";
-	string value = "";
-	grammar_element current_element;
-	int p_itr = 0;
-
-	/*
-		After all grammar_symbols & productions are made, must loop over all
-		grammar_symbols' productions and set the correct grammar_symbol ID's & type
-		in the productions.
-	*/
-	while (ifile.getline(line, MAX_LINE_LENGTH))
+	if (!opts.slr.empty() || !opts.lalr.empty())
 	{
-		str = string(line);
-
-		for (char c : str)
+		lr0_automaton automaton;
+		automaton.build(analyzer.symbols(), analyzer.productions());
+		if (!opts.slr.empty())
 		{
-			//If character is ws, discard. (should incl. \n, & \t)
-			if (iswspace(c) != 0 && !lhs_symbol_found && !production_arrow_found)
+			lr_table slr;
+			slr.build_slr(automaton, analyzer);
+			cout << "\nSLR(1): " << automaton.state_count() << " states, " << automaton.transition_count() << " transitions, "
+				<< slr.stats().shiftReduce << " shift/reduce and " << slr.stats().reduceReduce << " reduce/reduce conflicts\n";
+			output_writer slrFile;
+			if (!slrFile.open(opts.slr.c_str(), error))
 			{
-				//Consume
-				continue;
+				cerr << error << "\n";
+				return 1;
 			}
-			else if (c == '!')
+			write_lr_report(slrFile, analyzer, automaton, slr, "SLR(1)");
+			if (!slrFile.close())
 			{
-				symbolList.push_back(current_element);
-				lhs_symbol_found = false;
-				buffer.clear();
-				value.clear();
-				current_element = grammar_element();
-				p_itr = 0;
-				continue;
+				cerr << opts.slr << ": write failed\n";
+				return 1;
 			}
-			else
+		}
+		if (!opts.lalr.empty())
+		{
+			lalr_lookahead lookaheads;
+			lookaheads.compute(automaton, analyzer, &pool);
+			lr_table lalr;
+			lalr.build(automaton, analyzer.symbols(), lookaheads.views());
+			cout << "\nLALR(1): " << automaton.state_count() << " states, " << lookaheads.stats().nodes - 1 << " nonterminal transitions, "
+				<< lalr.stats().shiftReduce << " shift/reduce and " << lalr.stats().reduceReduce << " reduce/reduce conflicts\n";
+			output_writer lalrFile;
+			if (!lalrFile.open(opts.lalr.c_str(), error))
+			{
+				cerr << error << "\n";
+				return 1;
+			}
+			write_lr_report(lalrFile, analyzer, automaton, lalr, "LALR(1)");
+			if (!lalrFile.close())
 			{
-				//If we already have the LHS of the production...
-				if (lhs_symbol_found)
-				{
-					if (c == '|')
-					{
-						current_element.productionList.push_back(statement(current_element, vector<grammar_element>()));
-						buffer.clear();
-						p_itr++;
-					}
-					else if (iswspace(c) != 0 && buffer.length() > 0) 
-					{
-						current_element.productionList[p_itr].rhs.push_back(grammar_element(0,2, buffer));
-						buffer.clear();
-					}
-					else if (iswspace(c) != 0 && buffer.length() == 0) 
-					{
-						//Consume ws
-					}
-					else
-					{
-						buffer.push_back(c);
-					}
-				}
-				else
-				{
-					if (isalpha(c) || c == '_')
-					{
-						value.push_back(c);
-					}
-					else if (c == '=' && value.length() != 0)
-					{
-						lhs_symbol_found = true;
-						current_element = grammar_element(id_itr, 1, value);
-						current_element.productionList.push_back(statement(current_element, vector<grammar_element>()));
-						id_itr++;
-					}
-					else
-					{
-						//Do nothing.
-					}
-				}
+				cerr << opts.lalr << ": write failed\n";
+				return 1;
 			}
 		}
 	}
-	cout << "Parsing complete!\n";
 
-	update_all_grammar(symbolList);
-	cout << "\nUpdating complete!\n";
-	for (auto& symbol : symbolList) 
+	if (!opts.stats.empty())
 	{
-		compute_first_sets(symbol);
+		ofstream statsFile(opts.stats, ios::trunc);
+		if (!statsFile)
+		{
+			cerr << opts.stats << ": can't open for writing\n";
+			return 1;
+		}
+		write_stats_json(statsFile, analyzer.stats());
+		statsFile << "\n";
+		statsFile.close();
+		if (!statsFile)
+		{
+			cerr << opts.stats << ": write failed\n";
+			return 1;
+		}
 	}
-	cout << "\nComputing FIRST data complete!";
-
-	
-	followSetData = compute_follow_sets();
-	cout << "\nComputing FOLLOW data complete!";
-	
-	//print_all_productions(symbolList);
-
-	cout << "\n\n ============= FIRST SETS ==============\n\n";
-	ofile << "\n\n ============= FIRST SETS ==============\n\n";
-	print_firstSets(firstSetData, ofile);
-	cout << "\n\n =======================================\n\n";
-	ofile << "\n\n =======================================\n\n";
-
-	
-	cout << "\n\n ============= FOLLOW SETS ==============\n\n";
-	ofile << "\n\n ============= FOLLOW SETS ==============\n\n";
-	print_followSets(followSetData, dataContainer, ofile);
-
-	cout << "\n\n ============= FIRSTPLUS SETS ==============\n\n";
-	ofile << "\n\n ============= FIRSTPLUS SETS ==============\n\n";
-	print_all_firstPlus(compute_firstPlusSets(firstSetData, followSetData), ofile);
-
-	//keep console open
-	cout << "\n\nEnd Of Program! Any character key to continue.";
-	char c;
-	cin >> c;
-
-	ifile.close();
-	ofile.close();
 	return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,252 @@
+#include "analysis_cache.h"
+#include "grammar_analyzer.h"
+#include "mapped_file.h"
+#include "stopwatch.h"
+
+#include <fstream>
+#include <cstring>
+
+using namespace std;
+
+namespace
+{
+	const uint64_t FNV_OFFSET = 14695981039346656037ull;
+	const uint64_t FNV_PRIME = 1099511628211ull;
+
+	uint64_t hash_bytes(uint64_t hash, const void* data, size_t size)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash = (hash ^ bytes[i]) * FNV_PRIME;
+		}
+		return hash;
+	}
+
+	//FNV-1a a word at a time rather than a byte at a time, the payload can be hundreds of MB.
+	uint64_t checksum(const uint64_t* words, size_t count)
+	{
+		uint64_t hash = FNV_OFFSET;
+		for (size_t i = 0; i < count; i++)
+		{
+			hash = (hash ^ words[i]) * FNV_PRIME;
+			hash ^= hash >> 32;
+		}
+		return hash;
+	}
+
+	size_t byte_words(size_t bytes)
+	{
+		return (bytes + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+	}
+
+	//Appends count bytes to the word buffer, zero padded to a whole word.
+	void append_bytes(vector<uint64_t>& out, const void* data, size_t count)
+	{
+		size_t at = out.size();
+		out.resize(at + byte_words(count), 0);
+		if (count != 0)
+		{
+			memcpy(&out[at], data, count);
+		}
+	}
+
+	void append_words(vector<uint64_t>& out, const uint64_t* words, size_t count)
+	{
+		out.insert(out.end(), words, words + count);
+	}
+}
+
+uint64_t grammar_content_hash(const symbol_table& symbols, const grammar& productions)
+{
+	uint64_t hash = FNV_OFFSET;
+	for (symbol_id id = 0; id < symbols.size(); id++)
+	{
+		const string& name = symbols.name(id);
+		unsigned char type = (unsigned char)symbols.type(id);
+		hash = hash_bytes(hash, name.data(), name.size() + 1);
+		hash = hash_bytes(hash, &type, 1);
+	}
+	for (production_id p : productions.all_productions())
+	{
+		production_view production = productions.production(p);
+		hash = hash_bytes(hash, &production.lhs, sizeof(symbol_id));
+		for (symbol_id symbol : production)
+		{
+			hash = hash_bytes(hash, &symbol, sizeof(symbol_id));
+		}
+		hash = hash_bytes(hash, &NO_SYMBOL, sizeof(symbol_id));
+	}
+	return hash;
+}
+
+string analysis_cache_path(const string& directory, uint64_t hash)
+{
+	static const char digits[] = "0123456789abcdef";
+	string name(16, '0');
+	for (size_t i = 0; i < 16; i++)
+	{
+		name[15 - i] = digits[(hash >> (4 * i)) & 15];
+	}
+	name += ".fnfcache";
+	if (directory.empty())
+	{
+		return name;
+	}
+	char last = directory.back();
+	return last == '/' || last == '\\' ? directory + name : directory + "/" + name;
+}
+
+uint64_t grammar_analyzer::content_hash() const
+{
+	return grammar_content_hash(table, rules);
+}
+
+bool grammar_analyzer::write_cache(const char* path, string& error) const
+{
+	if (firstData.size() != table.size())
+	{
+		error = "nothing to cache, the grammar has not been computed";
+		return false;
+	}
+	size_t symbolCount = table.size();
+	size_t nonterminalCount = table.nonterminals().size();
+	size_t productionCount = rules.production_count();
+	size_t stride = terminal_set_words(table.terminals().size());
+
+	vector<uint64_t> file(ANALYSIS_CACHE_HEADER_WORDS, 0);
+	file.reserve(ANALYSIS_CACHE_HEADER_WORDS + (symbolCount + 2 * nonterminalCount + productionCount + suffixFirst.size()) * stride
+		+ byte_words(symbolCount) + byte_words(suffixNullable.size()) + byte_words(3 * sizeof(uint32_t) * conflicts.size()));
+	append_bytes(file, nullableData.data(), nullableData.size());
+	for (const vector<terminal_set>* sets : { &firstData, &followData, &firstPlusData })
+	{
+		for (const terminal_set& set : *sets)
+		{
+			append_words(file, set.data(), stride);
+		}
+	}
+	append_words(file, productionFirstPlus.data(), productionCount * stride);
+	append_words(file, suffixFirst.data(), suffixFirst.size() * stride);
+	append_bytes(file, suffixNullable.data(), suffixNullable.size());
+	vector<uint32_t> triples;
+	for (const ll1_conflict& conflict : conflicts)
+	{
+		triples.push_back(conflict.nonterminal);
+		triples.push_back(conflict.first);
+		triples.push_back(conflict.second);
+	}
+	append_bytes(file, triples.data(), triples.size() * sizeof(uint32_t));
+
+	uint64_t header[ANALYSIS_CACHE_HEADER_WORDS] = { ANALYSIS_CACHE_MAGIC | ((uint64_t)ANALYSIS_CACHE_VERSION << 32), content_hash(),
+		checksum(file.data() + ANALYSIS_CACHE_HEADER_WORDS, file.size() - ANALYSIS_CACHE_HEADER_WORDS),
+		symbolCount, table.terminals().size(), nonterminalCount, productionCount, suffixFirst.size(), conflicts.size(), stride };
+	memcpy(file.data(), header, sizeof(header));
+
+	ofstream out(path, ios::trunc | ios::binary);
+	out.write((const char*)file.data(), (streamsize)(file.size() * sizeof(uint64_t)));
+	out.close();
+	if (!out)
+	{
+		error = string(path) + ": can't write the cache";
+		return false;
+	}
+	return true;
+}
+
+bool grammar_analyzer::read_cache(const char* path, string& error)
+{
+	stopwatch timer;
+	mapped_file file;
+	if (!file.open(path, error))
+	{
+		return false;
+	}
+	string_view contents = file.contents();
+	const uint64_t* words = (const uint64_t*)contents.data();
+	size_t wordCount = contents.size() / sizeof(uint64_t);
+	if (wordCount < ANALYSIS_CACHE_HEADER_WORDS || (uint32_t)words[0] != ANALYSIS_CACHE_MAGIC)
+	{
+		error = string(path) + ": not a cache file";
+		return false;
+	}
+	if ((uint32_t)(words[0] >> 32) != ANALYSIS_CACHE_VERSION)
+	{
+		error = string(path) + ": cache version " + to_string(words[0] >> 32) + ", expected " + to_string(ANALYSIS_CACHE_VERSION);
+		return false;
+	}
+
+	//Everything but the conflict count follows from the loaded grammar, so the counts are compared
+	//rather than trusted.
+	size_t symbolCount = table.size();
+	size_t terminalCount = table.terminals().size();
+	size_t nonterminalCount = table.nonterminals().size();
+	size_t productionCount = rules.production_count();
+	size_t suffixRows = rules.symbol_count() + productionCount;
+	size_t stride = terminal_set_words(terminalCount);
+	uint64_t expectedHeader[] = { symbolCount, terminalCount, nonterminalCount, productionCount, suffixRows };
+	if (words[1] != content_hash() || memcmp(words + 3, expectedHeader, sizeof(expectedHeader)) != 0 || words[9] != stride)
+	{
+		error = string(path) + ": cache is for another grammar";
+		return false;
+	}
+	uint64_t conflictCount = words[8];
+	uint64_t expected = ANALYSIS_CACHE_HEADER_WORDS + byte_words(symbolCount)
+		+ (uint64_t)(symbolCount + 2 * nonterminalCount + productionCount + suffixRows) * stride + byte_words(suffixRows);
+	//A corrupt conflict count must not wrap around, there can't be more conflicts than words anyway.
+	if (conflictCount > wordCount || expected + byte_words(3 * sizeof(uint32_t) * (size_t)conflictCount) != wordCount
+		|| contents.size() % sizeof(uint64_t) != 0)
+	{
+		error = string(path) + ": cache is truncated or has trailing data";
+		return false;
+	}
+	if (checksum(words + ANALYSIS_CACHE_HEADER_WORDS, wordCount - ANALYSIS_CACHE_HEADER_WORDS) != words[2])
+	{
+		error = string(path) + ": cache checksum mismatch";
+		return false;
+	}
+
+	const uint32_t* triples = (const uint32_t*)(words + expected);
+	for (size_t i = 0; i < 3 * conflictCount; i += 3)
+	{
+		if (triples[i] >= symbolCount || !table.isNonterminal(triples[i]) || triples[i + 1] >= productionCount || triples[i + 2] >= productionCount)
+		{
+			error = string(path) + ": cache has a conflict outside the grammar";
+			return false;
+		}
+	}
+
+	const uint64_t* next = words + ANALYSIS_CACHE_HEADER_WORDS;
+	const char* bytes = (const char*)next;
+	nullableData.assign(bytes, bytes + symbolCount);
+	next += byte_words(symbolCount);
+	for (vector<terminal_set>* sets : { &firstData, &followData, &firstPlusData })
+	{
+		size_t count = sets == &firstData ? symbolCount : nonterminalCount;
+		sets->clear();
+		sets->reserve(count);
+		for (size_t i = 0; i < count; i++, next += stride)
+		{
+			sets->emplace_back(terminal_set_view(next, terminalCount));
+		}
+	}
+	productionFirstPlus = terminal_set_array(terminalCount, productionCount, next);
+	next += productionCount * stride;
+	suffixFirst = terminal_set_array(terminalCount, suffixRows, next);
+	next += suffixRows * stride;
+	bytes = (const char*)next;
+	suffixNullable.assign(bytes, bytes + suffixRows);
+	conflicts.clear();
+	for (size_t i = 0; i < conflictCount; i++, triples += 3)
+	{
+		ll1_conflict conflict = { triples[0], triples[1], triples[2], terminal_set(productionFirstPlus[triples[1]]) };
+		conflict.overlap.intersect(productionFirstPlus[triples[2]]);
+		conflicts.push_back(conflict);
+	}
+
+	reset_epsilon_mask();
+	statsData.ll1Conflicts = conflicts.size();
+	count_set_bytes();
+	statsData.cache = timer.lap();
+	statsData.cacheHit = true;
+	return true;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+#include "symbol_table.h"
+#include "grammar.h"
+
+/*
+	Binary cache of everything grammar_analyzer::compute() produces, see grammar_analyzer::read_cache and
+	write_cache. A cache file is keyed by the content hash of the grammar it was computed for, so the
+	caller can name it after the hash and find it again without looking at the old results.
+
+	Layout, all 64 bit words in the native byte order, so a cache is only read back on the kind of machine
+	that wrote it:
+		header		magic | version << 32, content hash, payload checksum, then the counts: symbols,
+					terminals, nonterminals, productions, suffix rows, conflicts, words per set
+		payload		nullable (1 byte per symbol), FIRST by symbol ID, FOLLOW and FIRST+ by nonterminal index,
+					FIRST+ by production, FIRST of every suffix, suffix nullable (1 byte per row), and the
+					conflicts as (nonterminal, first, second) 32 bit triples; byte arrays are padded to whole words
+	The checksum covers the payload, so a truncated or half written file is never taken for a valid one.
+*/
+const uint32_t ANALYSIS_CACHE_MAGIC = 0x43464E46;		//"FNFC"
+const uint32_t ANALYSIS_CACHE_VERSION = 1;
+const size_t ANALYSIS_CACHE_HEADER_WORDS = 10;
+
+//Hash of the grammar as it was parsed: symbol names and types in ID order and the productions as IDs.
+//Layout, comments and whitespace of the input files don't change it, anything that changes a set or
+//the numbering of the symbols does.
+uint64_t grammar_content_hash(const symbol_table& symbols, const grammar& productions);
+
+//"<16 hex digits of hash>.fnfcache" inside directory, which may be empty for the current directory.
+std::string analysis_cache_path(const std::string& directory, uint64_t hash);
@@ -0,0 +1,60 @@
+#include "analysis_stats.h"
+
+using namespace std;
+
+phase_time analysis_stats::total() const
+{
+	phase_time sum;
+	for (const phase_time* phase : { &load, &resolve, &nullable, &first, &suffix, &follow, &firstPlus, &conflicts, &cache })
+	{
+		sum.wall += phase->wall;
+		sum.cpu += phase->cpu;
+	}
+	return sum;
+}
+
+namespace
+{
+	void write_phase(ostream& out, const char* name, const phase_time& phase, bool last = false)
+	{
+		out << "\"" << name << "\": { \"wall\": " << phase.wall << ", \"cpu\": " << phase.cpu << " }" << (last ? "" : ", ");
+	}
+
+	void write_graph(ostream& out, const graph_stats& graph)
+	{
+		out << "{ \"nodes\": " << graph.nodes << ", \"edges\": " << graph.edges << ", \"sccs\": " << graph.sccs
+			<< ", \"largest_scc\": " << graph.largestScc << ", \"levels\": " << graph.levels
+			<< ", \"unions\": " << graph.unions << " }";
+	}
+}
+
+void write_stats_json(ostream& out, const analysis_stats& stats, const char* indent)
+{
+	streamsize precision = out.precision(9);
+	out << "{\n" << indent << "  \"seconds\": { ";
+	write_phase(out, "load", stats.load);
+	write_phase(out, "resolve", stats.resolve);
+	write_phase(out, "nullable", stats.nullable);
+	write_phase(out, "first", stats.first);
+	write_phase(out, "suffix", stats.suffix);
+	write_phase(out, "follow", stats.follow);
+	write_phase(out, "first_plus", stats.firstPlus);
+	write_phase(out, "conflicts", stats.conflicts);
+	write_phase(out, "cache", stats.cache);
+	write_phase(out, "total", stats.total(), true);
+	out << " },\n"
+		<< indent << "  \"grammar\": { \"symbols\": " << stats.symbols << ", \"terminals\": " << stats.terminals
+		<< ", \"nonterminals\": " << stats.nonterminals << ", \"productions\": " << stats.productions
+		<< ", \"rhs_symbols\": " << stats.rhsSymbols << ", \"ll1_conflicts\": " << stats.ll1Conflicts << " },\n"
+		<< indent << "  \"cache_hit\": " << (stats.cacheHit ? "true" : "false") << ",\n"
+		<< indent << "  \"counters\": { \"symbol_lookups\": " << stats.symbolLookups
+		<< ", \"nullable_steps\": " << stats.nullableSteps << ", \"set_unions\": " << stats.setUnions << " },\n"
+		<< indent << "  \"first_graph\": ";
+	write_graph(out, stats.firstGraph);
+	out << ",\n" << indent << "  \"follow_graph\": ";
+	write_graph(out, stats.followGraph);
+	out << ",\n" << indent << "  \"memory\": { \"set_bytes\": " << stats.setBytes
+		<< ", \"peak_bytes\": " << stats.peakMemory << " }\n"
+		<< indent << "}";
+	out.precision(precision);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+
+//Seconds spent in one phase. cpu is the time of the whole process, so with a thread pool it can be
+//several times wall; cpu well below wall means the phase was waiting (I/O, page faults).
+struct phase_time
+{
+	double wall = 0;
+	double cpu = 0;
+};
+
+//What digraph_solve saw and did for one relation.
+struct graph_stats
+{
+	size_t nodes = 0;
+	size_t edges = 0;
+	size_t sccs = 0;
+	size_t largestScc = 0;
+	size_t levels = 0;			//rounds of the level by level schedule, the longest dependency chain
+	uint64_t unions = 0;		//terminal set unions, the copies to the other members of an SCC included
+};
+
+/*
+	Instrumentation of one load + compute of grammar_analyzer. Nothing here changes the results, the
+	counters are plain sums gathered along the way and cost next to nothing.
+*/
+struct analysis_stats
+{
+	phase_time load;			//reading and tokenizing both inputs
+	phase_time resolve;			//undeclared symbols to terminals, grouping productions by LHS
+	phase_time nullable;
+	phase_time first;
+	phase_time suffix;			//FIRST and nullable of every RHS suffix
+	phase_time follow;
+	phase_time firstPlus;
+	phase_time conflicts;		//the LL(1) disjointness check
+	phase_time cache;			//reading the result cache, which replaces all of the phases above but load and resolve
+	bool cacheHit = false;
+
+	size_t symbols = 0;
+	size_t terminals = 0;
+	size_t nonterminals = 0;
+	size_t productions = 0;
+	size_t rhsSymbols = 0;
+	size_t ll1Conflicts = 0;
+
+	uint64_t symbolLookups = 0;		//hash lookups in the symbol table, one per token loaded
+	uint64_t nullableSteps = 0;		//worklist pops plus production occurrences visited
+	graph_stats firstGraph;
+	graph_stats followGraph;
+	uint64_t setUnions = 0;			//every terminal set union, the two graphs' included
+	size_t setBytes = 0;			//memory held by the terminal sets and suffix tables once compute is done
+	size_t peakMemory = 0;			//the process' high water mark after compute
+
+	phase_time total() const;
+};
+
+//One JSON object, members in the order above. indent is put in front of every line but the first.
+void write_stats_json(std::ostream& out, const analysis_stats& stats, const char* indent = "");
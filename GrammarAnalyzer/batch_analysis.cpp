@@ -0,0 +1,193 @@
+#include "batch_analysis.h"
+#include "grammar_analyzer.h"
+#include "thread_pool.h"
+#include "stopwatch.h"
+#include "process_stats.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <unordered_set>
+#include <atomic>
+
+using namespace std;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	const char* extension(output_format format)
+	{
+		switch (format)
+		{
+		case OUTPUT_JSON:
+			return ".json";
+		case OUTPUT_CSV:
+			return ".csv";
+		default:
+			return ".txt";
+		}
+	}
+
+	bool list_directory(const fs::path& directory, vector<batch_entry>& entries, string& error)
+	{
+		error_code failure;
+		vector<fs::path> grammars;
+		for (fs::directory_iterator it(directory, failure), end; !failure && it != end; it.increment(failure))
+		{
+			string name = it->path().filename().string();
+			if (name.find("language") != string::npos && it->is_regular_file(failure))
+			{
+				grammars.push_back(it->path());
+			}
+		}
+		if (failure)
+		{
+			error = directory.string() + ": " + failure.message();
+			return false;
+		}
+		sort(grammars.begin(), grammars.end());
+		for (const fs::path& grammar : grammars)
+		{
+			string name = grammar.filename().string();
+			name.replace(name.find("language"), 8, "terminals");
+			fs::path terminals = grammar.parent_path() / name;
+			entries.push_back({ grammar.string(), terminals.string(), string(), string() });
+			//Still an entry, so the summary accounts for every grammar found.
+			if (!fs::is_regular_file(terminals, failure))
+			{
+				entries.back().error = grammar.string() + ": no terminals file, expected " + terminals.string();
+			}
+		}
+		return true;
+	}
+
+	bool read_manifest(const fs::path& manifest, vector<batch_entry>& entries, string& error)
+	{
+		ifstream in(manifest);
+		if (!in)
+		{
+			error = manifest.string() + ": can't read";
+			return false;
+		}
+		fs::path base = manifest.parent_path();
+		string line;
+		for (size_t number = 1; getline(in, line); number++)
+		{
+			stringstream fields(line);
+			string grammar;
+			string terminals;
+			string extra;
+			if (!(fields >> grammar) || grammar[0] == '#')
+			{
+				continue;
+			}
+			if (!(fields >> terminals) || fields >> extra)
+			{
+				error = manifest.string() + ":" + to_string(number) + ": expected a grammar and a terminals path";
+				return false;
+			}
+			entries.push_back({ (base / grammar).string(), (base / terminals).string(), string(), string() });
+		}
+		return true;
+	}
+}
+
+bool find_batch_entries(const string& source, const batch_options& options, vector<batch_entry>& entries, string& error)
+{
+	entries.clear();
+	error_code failure;
+	bool found = fs::is_directory(source, failure) ? list_directory(source, entries, error) : read_manifest(source, entries, error);
+	if (!found)
+	{
+		return false;
+	}
+
+	//Output names are taken in entry order, so the same batch always writes the same files.
+	unordered_set<string> taken;
+	for (batch_entry& entry : entries)
+	{
+		string stem = fs::path(entry.grammar).stem().string();
+		string name = stem;
+		for (size_t n = 2; !taken.insert(name).second; n++)
+		{
+			name = stem + "_" + to_string(n);
+		}
+		entry.output = (fs::path(options.outputDirectory) / (name + extension(options.format))).string();
+	}
+	return true;
+}
+
+void run_batch(const vector<batch_entry>& entries, const batch_options& options, vector<batch_result>& results, batch_stats& stats)
+{
+	stopwatch timer;
+	stats = batch_stats();
+	results.assign(entries.size(), batch_result());
+
+	error_code failure;
+	fs::create_directories(options.outputDirectory, failure);
+	if (failure)
+	{
+		for (batch_result& result : results)
+		{
+			result.error = options.outputDirectory + ": " + failure.message();
+		}
+		stats.failed = results.size();
+		return;
+	}
+
+	thread_pool pool(options.inFlight);
+	stats.inFlight = pool.size();
+	atomic<size_t> next{ 0 };
+	//One range per thread, whatever it says: the entries are handed out one at a time through next, so a
+	//thread that drew small grammars goes on to the next one instead of idling at the end of a fixed range.
+	pool.parallel_for(pool.size(), [&](size_t, size_t)
+	{
+		grammar_analyzer analyzer;
+		for (size_t i = next++; i < entries.size(); i = next++)
+		{
+			const batch_entry& entry = entries[i];
+			batch_result& result = results[i];
+			stopwatch grammarTimer;
+			if (!entry.error.empty())
+			{
+				result.error = entry.error;
+				continue;
+			}
+			if (!analyzer.load(entry.terminals.c_str(), entry.grammar.c_str(), result.error))
+			{
+				continue;
+			}
+			if (options.removeUseless)
+			{
+				const useless_stats& useless = analyzer.remove_useless();
+				result.removedProductions = useless.productionsBefore - useless.productionsAfter;
+			}
+			analyzer.compute();
+			output_writer out;
+			if (!out.open(entry.output.c_str(), result.error))
+			{
+				continue;
+			}
+			write_results(out, analyzer, options.format, options.order);
+			if (!out.close())
+			{
+				result.error = entry.output + ": write failed";
+				continue;
+			}
+			result.productions = analyzer.productions().production_count();
+			result.terminals = analyzer.symbols().terminals().size();
+			result.nonterminals = analyzer.symbols().nonterminals().size();
+			result.ll1Conflicts = analyzer.ll1_conflicts().size();
+			result.seconds = grammarTimer.seconds();
+		}
+	}, 1);
+
+	for (const batch_result& result : results)
+	{
+		stats.failed += !result.error.empty();
+	}
+	stats.seconds = timer.seconds();
+	stats.peakMemory = peak_memory_bytes();
+}
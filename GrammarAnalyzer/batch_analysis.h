@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include "output_writer.h"
+
+//One grammar of a batch and where its results go.
+struct batch_entry
+{
+	std::string grammar;
+	std::string terminals;
+	std::string output;
+	std::string error;		//set if the entry fails before it is loaded, e.g. it has no terminals file
+};
+
+struct batch_options
+{
+	size_t inFlight = 0;			//grammars analysed at the same time, 0 means one per hardware thread
+	std::string outputDirectory = "batch_output";
+	output_format format = OUTPUT_TEXT;
+	output_order order = ORDER_BY_ID;
+	bool removeUseless = false;		//see grammar_analyzer::remove_useless
+};
+
+//What came of one entry. error is empty if it was analysed and its output written.
+struct batch_result
+{
+	std::string error;
+	size_t productions = 0;
+	size_t terminals = 0;
+	size_t nonterminals = 0;
+	size_t ll1Conflicts = 0;
+	size_t removedProductions = 0;	//by remove_useless
+	double seconds = 0;				//wall clock, load to output written
+};
+
+struct batch_stats
+{
+	double seconds = 0;
+	size_t inFlight = 0;			//what batch_options::inFlight came to
+	size_t failed = 0;
+	size_t peakMemory = 0;
+};
+
+/*
+	Finds the grammars of a batch in source, which is either
+		a directory		every file whose name has "language" in it and a file next to it with "terminals"
+						in its place, e.g. bench_100_language.txt and bench_100_terminals.txt, or
+						language_input.txt and terminals_input.txt. A grammar without its terminals file
+						is an entry all the same, with error set
+		a manifest		one "grammar terminals" pair of paths per line, relative to the manifest's own
+						directory. Blank lines and lines starting with # are skipped
+	Entries come out sorted by grammar path for a directory and in file order for a manifest. The output of
+	each is the grammar's file name without its extension in options.outputDirectory, followed by the
+	extension of options.format, with _2, _3, ... added where two grammars have the same name. Returns
+	false with error set if source can't be read.
+*/
+bool find_batch_entries(const std::string& source, const batch_options& options, std::vector<batch_entry>& entries, std::string& error);
+
+/*
+	Analyses every entry and writes its results with write_results, results[i] says how entry i went. A
+	grammar that doesn't load or can't be written only fails its own entry.
+
+	The work runs on a thread_pool of options.inFlight threads, which is also the cap on memory: every
+	thread takes the next entry off a shared counter and has one grammar_analyzer that it reuses, so at
+	most inFlight grammars are loaded at any time and no thread waits on another while there is work left.
+	The analyzers themselves run single threaded. Nothing reads from the console. write_batch_summary
+	(output_writer.h) writes what came of the batch.
+*/
+void run_batch(const std::vector<batch_entry>& entries, const batch_options& options, std::vector<batch_result>& results, batch_stats& stats);
@@ -0,0 +1,220 @@
+#include "digraph.h"
+
+using namespace std;
+
+size_t digraph_components(const vector<vector<uint32_t>>& relation, vector<uint32_t>& component)
+{
+	const uint32_t DONE = 0xFFFFFFFF;
+	size_t node_count = relation.size();
+	uint32_t scc_count = 0;
+
+	//depth[x] == 0 : not visited yet, DONE : x's SCC is complete, otherwise the lowest stack depth reachable.
+	vector<uint32_t> depth(node_count, 0);
+	vector<uint32_t> stack;
+	component.assign(node_count, 0);
+
+	//One frame per node being traversed, replaces the recursive call of the textbook version.
+	struct frame
+	{
+		uint32_t node;
+		uint32_t d;			//depth of node when it was pushed
+		uint32_t edge;		//next edge of relation[node] to follow
+	};
+	vector<frame> calls;
+
+	for (uint32_t start = 0; start < node_count; start++)
+	{
+		if (depth[start] != 0)
+		{
+			continue;
+		}
+
+		stack.push_back(start);
+		depth[start] = (uint32_t)stack.size();
+		calls.push_back({ start, depth[start], 0 });
+
+		while (!calls.empty())
+		{
+			uint32_t x = calls.back().node;
+			const vector<uint32_t>& edges = relation[x];
+
+			if (calls.back().edge < edges.size())
+			{
+				uint32_t y = edges[calls.back().edge++];
+				if (depth[y] == 0)
+				{
+					//'Recurse' into y, x is finished off once y's frame is popped.
+					stack.push_back(y);
+					depth[y] = (uint32_t)stack.size();
+					calls.push_back({ y, depth[y], 0 });
+					continue;
+				}
+				if (depth[y] < depth[x])
+				{
+					depth[x] = depth[y];
+				}
+				continue;
+			}
+
+			//All edges of x followed. If x is the root of its SCC, every node above it on the stack
+			//belongs to the same component.
+			if (depth[x] == calls.back().d)
+			{
+				uint32_t top;
+				do
+				{
+					top = stack.back();
+					stack.pop_back();
+					depth[top] = DONE;
+					component[top] = scc_count;
+				} while (top != x);
+				scc_count++;
+			}
+			calls.pop_back();
+
+			//Return to the caller, which takes x's depth the same way as an already visited edge.
+			if (!calls.empty())
+			{
+				uint32_t parent = calls.back().node;
+				if (depth[x] < depth[parent])
+				{
+					depth[parent] = depth[x];
+				}
+			}
+		}
+	}
+	return scc_count;
+}
+
+size_t digraph_solve(const vector<vector<uint32_t>>& relation, vector<terminal_set>& sets, thread_pool* pool, graph_stats* stats)
+{
+	size_t node_count = relation.size();
+	vector<uint32_t> component;
+	size_t scc_count = digraph_components(relation, component);
+
+	//Members of each component, CSR style: component c owns members[memberStart[c], memberStart[c + 1]).
+	//The first member is the one whose set is built up, the others copy it when the component is done.
+	vector<uint32_t> memberStart(scc_count + 1, 0);
+	vector<uint32_t> members(node_count);
+	for (size_t x = 0; x < node_count; x++)
+	{
+		memberStart[component[x] + 1]++;
+	}
+	for (size_t c = 0; c < scc_count; c++)
+	{
+		memberStart[c + 1] += memberStart[c];
+	}
+	vector<uint32_t> fill(memberStart.begin(), memberStart.end() - 1);
+	for (uint32_t x = 0; x < node_count; x++)
+	{
+		members[fill[component[x]]++] = x;
+	}
+
+	//Components only point at lower numbers, so one pass in numbering order settles every level.
+	//The same pass counts what solve() is going to do: one union per edge leaving the component,
+	//and per extra member one union into the first member plus one copy back out.
+	vector<uint32_t> level(scc_count, 0);
+	uint32_t level_count = 0;
+	size_t edge_count = 0;
+	size_t largest = 0;
+	uint64_t unions = 0;
+	for (size_t c = 0; c < scc_count; c++)
+	{
+		uint32_t member_count = memberStart[c + 1] - memberStart[c];
+		largest = member_count > largest ? member_count : largest;
+		unions += 2 * (uint64_t)(member_count - 1);
+		for (uint32_t m = memberStart[c]; m < memberStart[c + 1]; m++)
+		{
+			edge_count += relation[members[m]].size();
+			for (uint32_t y : relation[members[m]])
+			{
+				if (component[y] == c)
+				{
+					continue;
+				}
+				unions++;
+				if (level[component[y]] + 1 > level[c])
+				{
+					level[c] = level[component[y]] + 1;
+				}
+			}
+		}
+		if (level[c] + 1 > level_count)
+		{
+			level_count = level[c] + 1;
+		}
+	}
+	if (stats != nullptr)
+	{
+		stats->nodes = node_count;
+		stats->edges = edge_count;
+		stats->sccs = scc_count;
+		stats->largestScc = largest;
+		stats->levels = level_count;
+		stats->unions = unions;
+	}
+
+	vector<uint32_t> levelStart(level_count + 1, 0);
+	vector<uint32_t> byLevel(scc_count);
+	for (size_t c = 0; c < scc_count; c++)
+	{
+		levelStart[level[c] + 1]++;
+	}
+	for (size_t l = 0; l < level_count; l++)
+	{
+		levelStart[l + 1] += levelStart[l];
+	}
+	fill.assign(levelStart.begin(), levelStart.end() - 1);
+	for (uint32_t c = 0; c < scc_count; c++)
+	{
+		byLevel[fill[level[c]]++] = c;
+	}
+
+	auto solve = [&](uint32_t c)
+	{
+		uint32_t first = memberStart[c];
+		uint32_t last = memberStart[c + 1];
+		terminal_set& result = sets[members[first]];
+		for (uint32_t m = first; m < last; m++)
+		{
+			uint32_t x = members[m];
+			if (m != first)
+			{
+				result.unite(sets[x]);
+			}
+			for (uint32_t y : relation[x])
+			{
+				if (component[y] != c)
+				{
+					result.unite(sets[y]);
+				}
+			}
+		}
+		for (uint32_t m = first + 1; m < last; m++)
+		{
+			sets[members[m]] = result;
+		}
+	};
+
+	for (uint32_t l = 0; l < level_count; l++)
+	{
+		uint32_t begin = levelStart[l];
+		uint32_t count = levelStart[l + 1] - begin;
+		if (pool == nullptr)
+		{
+			for (uint32_t i = 0; i < count; i++)
+			{
+				solve(byLevel[begin + i]);
+			}
+			continue;
+		}
+		pool->parallel_for(count, [&](size_t from, size_t to)
+		{
+			for (size_t i = from; i < to; i++)
+			{
+				solve(byLevel[begin + i]);
+			}
+		});
+	}
+	return scc_count;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "terminal_set.h"
+#include "thread_pool.h"
+#include "analysis_stats.h"
+
+/*
+	DeRemer & Pennello's digraph algorithm.
+
+	Given a relation R over the nodes 0..n-1 (relation[x] lists every y with x R y) and an initial
+	set F'(x) per node in sets[x], replaces each set with
+		F(x) = F'(x) U { F(y) | x R y }
+	i.e. the union over everything reachable from x. All nodes of one strongly connected component end
+	up with the same set, so cycles such as FOLLOW(exp) <-> FOLLOW(exp_prime) need no special handling.
+
+	The relation is condensed into its SCCs with a single Tarjan walk, then the components are resolved
+	level by level: a component's level is one more than the highest level it points at, so every
+	component of a level only reads sets that are already final and the whole level can run on the pool
+	at once. Unions are order independent, so the result is the same whatever the thread count.
+	Returns the number of strongly connected components found, the rest of the figures go to stats if it is given.
+*/
+size_t digraph_solve(const std::vector<std::vector<uint32_t>>& relation, std::vector<terminal_set>& sets,
+	thread_pool* pool = nullptr, graph_stats* stats = nullptr);
+
+//Tarjan's SCC walk on its own. Components are numbered in the order they are completed, so for every
+//x R y, component[y] <= component[x]. Uses an explicit stack, so arbitrarily deep relations cannot
+//overflow the call stack. Returns the number of components.
+size_t digraph_components(const std::vector<std::vector<uint32_t>>& relation, std::vector<uint32_t>& component);
@@ -0,0 +1,65 @@
+#include "grammar.h"
+
+using namespace std;
+
+void grammar::add_production(symbol_id lhs, const vector<symbol_id>& rhs)
+{
+	productionLhs.push_back(lhs);
+	rhsSymbols.insert(rhsSymbols.end(), rhs.begin(), rhs.end());
+	productionStart.push_back((uint32_t)rhsSymbols.size());
+}
+
+void grammar::finalize(const symbol_table& symbols)
+{
+	size_t nonterminal_count = symbols.nonterminals().size();
+	size_t count = production_count();
+
+	//Counting sort on the LHS' nonterminal index.
+	lhsStart.assign(nonterminal_count + 1, 0);
+	for (symbol_id lhs : productionLhs)
+	{
+		lhsStart[symbols.index(lhs) + 1]++;
+	}
+	for (size_t nt = 0; nt < nonterminal_count; nt++)
+	{
+		lhsStart[nt + 1] += lhsStart[nt];
+	}
+
+	vector<production_id> order(count);
+	vector<production_id> next(lhsStart.begin(), lhsStart.end() - 1);
+	bool sorted = true;
+	for (production_id p = 0; p < count; p++)
+	{
+		production_id to = next[symbols.index(productionLhs[p])]++;
+		order[to] = p;
+		sorted = sorted && (to == p);
+	}
+	if (sorted)
+	{
+		return;
+	}
+
+	vector<symbol_id> newSymbols;
+	vector<uint32_t> newStart = { 0 };
+	vector<symbol_id> newLhs;
+	newSymbols.reserve(rhsSymbols.size());
+	newStart.reserve(count + 1);
+	newLhs.reserve(count);
+	for (production_id p : order)
+	{
+		newLhs.push_back(productionLhs[p]);
+		newSymbols.insert(newSymbols.end(), rhsSymbols.begin() + productionStart[p], rhsSymbols.begin() + productionStart[p + 1]);
+		newStart.push_back((uint32_t)newSymbols.size());
+	}
+	rhsSymbols.swap(newSymbols);
+	productionStart.swap(newStart);
+	productionLhs.swap(newLhs);
+}
+
+void grammar::clear()
+{
+	rhsSymbols.clear();
+	productionStart.assign(1, 0);
+	productionLhs.clear();
+	lhsStart.clear();
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "symbol_table.h"
+
+typedef uint32_t production_id;
+
+//A production's RHS, pointing straight into the grammar's symbol array. Valid until the grammar is modified.
+class production_view
+{
+public:
+	production_view(production_id i, symbol_id l, const symbol_id* b, const symbol_id* e) : id(i), lhs(l), first(b), last(e) {}
+
+	size_t size() const { return last - first; }
+	bool empty() const { return first == last; }
+	symbol_id operator[](size_t pos) const { return first[pos]; }
+	const symbol_id* begin() const { return first; }
+	const symbol_id* end() const { return last; }
+
+	production_id id;
+	symbol_id lhs;
+
+private:
+	const symbol_id* first;
+	const symbol_id* last;
+};
+
+//Half open range of production IDs, iterates as production_id.
+class production_range
+{
+public:
+	class iterator
+	{
+	public:
+		iterator(production_id p) : id(p) {}
+		production_id operator*() const { return id; }
+		iterator& operator++() { id++; return *this; }
+		bool operator!=(const iterator& other) const { return id != other.id; }
+	private:
+		production_id id;
+	};
+
+	production_range(production_id b, production_id e) : first(b), last(e) {}
+	iterator begin() const { return iterator(first); }
+	iterator end() const { return iterator(last); }
+	size_t size() const { return last - first; }
+
+private:
+	production_id first;
+	production_id last;
+};
+
+/*
+	Compressed sparse row store for the productions of a grammar.
+		rhsSymbols			every RHS symbol ID, one production after the other
+		productionStart		production p's RHS is rhsSymbols[productionStart[p], productionStart[p + 1])
+		productionLhs		LHS of each production
+		lhsStart			nonterminal n (symbol_table::index) owns productions [lhsStart[n], lhsStart[n + 1])
+
+	Productions are appended with add_production while loading, in any order. finalize() groups them
+	by LHS (stable, so alternatives keep their order) and builds lhsStart. After that the store is
+	read through views and nothing is copied.
+*/
+class grammar
+{
+public:
+	void add_production(symbol_id lhs, const std::vector<symbol_id>& rhs);
+	void finalize(const symbol_table& symbols);
+	void clear();
+
+	size_t production_count() const { return productionLhs.size(); }
+	size_t symbol_count() const { return rhsSymbols.size(); }
+
+	production_view production(production_id p) const
+	{
+		const symbol_id* base = rhsSymbols.data();
+		return production_view(p, productionLhs[p], base + productionStart[p], base + productionStart[p + 1]);
+	}
+
+	//All productions whose LHS has the given nonterminal index.
+	production_range productions_of(uint32_t nonterminal) const
+	{
+		return production_range(lhsStart[nonterminal], lhsStart[nonterminal + 1]);
+	}
+	production_range all_productions() const { return production_range(0, (production_id)production_count()); }
+
+	//Offset of a production's first symbol in rhsSymbols. Tables with one entry per RHS position
+	//(plus one for the end of each production) can use rhs_offset(p) + p + pos as their index.
+	uint32_t rhs_offset(production_id p) const { return productionStart[p]; }
+
+private:
+	std::vector<symbol_id> rhsSymbols;
+	std::vector<uint32_t> productionStart = { 0 };
+	std::vector<symbol_id> productionLhs;
+	std::vector<production_id> lhsStart;
+};
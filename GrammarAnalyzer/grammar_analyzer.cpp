@@ -0,0 +1,551 @@
+#include "grammar_analyzer.h"
+#include "grammar_loader.h"
+#include "digraph.h"
+#include "stopwatch.h"
+#include "process_stats.h"
+
+using namespace std;
+
+/*
+	FOLLOW SET ALGORITHM
+
+	Loop through every existing production
+	If there is a NT A followed by a symbol b, then everything in FIRST(b) except epsilon,
+	is placed in FOLLOW(A).
+
+	If there is a NT A followed by a symbol b, and FIRST(b) contains epsilon,
+	then everything in the LHS of the production in which A is contained (we'll name that NT X),
+	is in FOLLOW(A). aka X -> Ab && b -> epsilon, then everything in FOLLOW(X) is in FOLLOW(A).
+
+	Same as above if the NT A is the last element in the production.
+	aka X -> bA, then everything in FOLLOW(X) is in FOLLOW(A).
+
+	NOTE: If X -> aAbc where there is an NT A followed by element b (FIRST(b) has epsilon)
+	& element c (FIRST(c) does not have epsilon) then FIRST(b) is placed in FOLLOW(A)
+	& FIRST(c) is placed in FOLLOW(A)
+
+	NOTE 2: in the above example, in the case FIRST(c) also contains epsilon, everything in
+	FOLLOW(X) is in FOLLOW(A).
+
+	The "everything in FOLLOW(X) is in FOLLOW(A)" rules form an inclusion graph between nonterminals.
+	It is resolved once all productions have been read, see digraph.h.
+*/
+
+
+bool grammar_analyzer::load(const char* terminals_path, const char* grammar_path, string& error)
+{
+	clear();
+	//Terminals are loaded first. The productions' RHS symbols not declared yet stay UNKNOWN until resolve_symbols.
+	stopwatch timer;
+	if (!load_terminals(terminals_path, table, error) || !load_grammar(grammar_path, table, rules, error))
+	{
+		return false;
+	}
+	statsData.load = timer.lap();
+	resolve_symbols();
+	statsData.resolve = timer.lap();
+	return true;
+}
+
+bool grammar_analyzer::parse(string_view terminals, string_view text, string& error)
+{
+	clear();
+	stopwatch timer;
+	if (!parse_terminals(terminals, "<terminals>", table, error) || !parse_grammar(text, "<grammar>", table, rules, error))
+	{
+		return false;
+	}
+	statsData.load = timer.lap();
+	resolve_symbols();
+	statsData.resolve = timer.lap();
+	return true;
+}
+
+void grammar_analyzer::clear()
+{
+	table.clear();
+	rules.clear();
+	undeclaredSymbols.clear();
+	statsData = analysis_stats();
+	transformStats = transform_stats();
+	uselessStats = useless_stats();
+	epsilonMask = terminal_set();
+	nullableData.clear();
+	firstData.clear();
+	followData.clear();
+	firstPlusData.clear();
+	suffixFirst = terminal_set_array();
+	suffixNullable.clear();
+	productionFirstPlus = terminal_set_array();
+	conflicts.clear();
+}
+
+const transform_stats& grammar_analyzer::transform(const transform_options& options)
+{
+	transform_grammar(table, rules, options, transformStats);
+	count_symbols();
+	return transformStats;
+}
+
+const useless_stats& grammar_analyzer::remove_useless()
+{
+	vector<symbol_id> renumbered;
+	remove_useless_symbols(table, rules, renumbered, uselessStats);
+	size_t kept = 0;
+	for (symbol_id id : undeclaredSymbols)
+	{
+		if (renumbered[id] != NO_SYMBOL)
+		{
+			undeclaredSymbols[kept++] = renumbered[id];
+		}
+	}
+	undeclaredSymbols.resize(kept);
+	count_symbols();
+	return uselessStats;
+}
+
+void grammar_analyzer::compute()
+{
+	reset_epsilon_mask();
+	statsData.nullableSteps = 0;
+	statsData.setUnions = 0;
+	if (trace.enabled<TRACE_SUMMARY>())
+	{
+		trace.out() << "grammar: " << table.terminals().size() << " terminals, " << table.nonterminals().size() << " nonterminals, "
+			<< rules.production_count() << " productions, " << rules.symbol_count() << " RHS symbols\n";
+	}
+	stopwatch timer;
+	compute_nullable();
+	statsData.nullable = timer.lap();
+	trace_summary("nullable", statsData.nullable);
+	compute_first_sets();
+	statsData.first = timer.lap();
+	trace_summary("FIRST", statsData.first);
+	trace_graph("FIRST", statsData.firstGraph);
+	compute_suffix_tables();
+	statsData.suffix = timer.lap();
+	statsData.setUnions += rules.symbol_count();
+	trace_summary("suffix tables", statsData.suffix);
+	compute_follow_sets();
+	statsData.follow = timer.lap();
+	trace_summary("FOLLOW", statsData.follow);
+	trace_graph("FOLLOW", statsData.followGraph);
+	compute_first_plus_sets();
+	statsData.firstPlus = timer.lap();
+	trace_summary("FIRST+", statsData.firstPlus);
+	compute_ll1_conflicts();
+	statsData.conflicts = timer.lap();
+	statsData.ll1Conflicts = conflicts.size();
+	trace_summary("LL(1) conflicts", statsData.conflicts);
+
+	statsData.setUnions += statsData.firstGraph.unions + statsData.followGraph.unions;
+	count_set_bytes();
+	statsData.peakMemory = peak_memory_bytes();
+	trace.flush();
+}
+
+void grammar_analyzer::reset_epsilon_mask()
+{
+	epsilonMask = empty_terminal_set();
+	if (table.epsilon != NO_SYMBOL)
+	{
+		epsilonMask.set(table.index(table.epsilon));
+	}
+}
+
+void grammar_analyzer::count_set_bytes()
+{
+	statsData.setBytes = epsilonMask.byte_size() + suffixFirst.byte_size() + productionFirstPlus.byte_size();
+	for (const vector<terminal_set>* sets : { &firstData, &followData, &firstPlusData })
+	{
+		for (const terminal_set& set : *sets)
+		{
+			statsData.setBytes += set.byte_size();
+		}
+	}
+}
+
+//Every RHS symbol was interned while parsing. Any symbol that never appeared as a LHS and is not
+//listed in the terminals file is still UNKNOWN here, it is treated as a terminal from now on.
+//Once every symbol has its final type the production store is grouped by LHS.
+void grammar_analyzer::resolve_symbols()
+{
+	for (symbol_id id = 0; id < table.size(); id++)
+	{
+		if (table.type(id) == UNKNOWN)
+		{
+			undeclaredSymbols.push_back(id);
+			table.intern(table.name(id), TERMINAL);
+		}
+	}
+	rules.finalize(table);
+	count_symbols();
+}
+
+void grammar_analyzer::count_symbols()
+{
+	statsData.symbols = table.size();
+	statsData.terminals = table.terminals().size();
+	statsData.nonterminals = table.nonterminals().size();
+	statsData.productions = rules.production_count();
+	statsData.rhsSymbols = rules.symbol_count();
+	statsData.symbolLookups = table.lookups();
+}
+
+//One line per phase at TRACE_SUMMARY.
+void grammar_analyzer::trace_summary(const char* phase, const phase_time& time)
+{
+	if (trace.enabled<TRACE_SUMMARY>())
+	{
+		trace.out() << phase << ": " << time.wall << "s wall, " << time.cpu << "s cpu\n";
+	}
+}
+
+void grammar_analyzer::trace_graph(const char* name, const graph_stats& graph)
+{
+	if (trace.enabled<TRACE_SUMMARY>())
+	{
+		trace.out() << "\t" << name << " graph: " << graph.nodes << " nodes, " << graph.edges << " edges, " << graph.sccs
+			<< " SCCs (largest " << graph.largestScc << "), " << graph.levels << " levels, " << graph.unions << " unions\n";
+	}
+}
+
+//Followset data before the inclusions are resolved (intermediate step), only called at TRACE_UPDATES.
+void grammar_analyzer::trace_follow_inclusions(const vector<terminal_set>& follow, const vector<vector<uint32_t>>& includes)
+{
+	ostream& out = trace.out();
+	out << "\n\n=============== FOLLOWSETS BEFORE RESOLUTION ===============\n\n";
+	for (size_t nt = 0; nt < follow.size(); nt++)
+	{
+		out << "\nFOLLOW(" << table.name(table.nonterminals()[nt]) << "):\n"
+			<< "\n\tIncludes FOLLOW of: { ";
+		for (uint32_t g_elem : includes[nt])
+		{
+			out << table.name(table.nonterminals()[g_elem]) << " ";
+		}
+		out << "}\n\tDefined: { ";
+		for (size_t g_elem : follow[nt])
+		{
+			out << terminal_name(g_elem) << " ";
+		}
+		out << "}\n";
+	}
+}
+
+//A symbol is nullable if it can derive epsilon. Counter based worklist: every production keeps the number
+//of RHS symbols not yet known to be nullable, its LHS becomes nullable when that count reaches zero.
+//Each RHS occurrence is visited once, so this is linear in the size of the grammar.
+void grammar_analyzer::compute_nullable()
+{
+	nullableData.assign(table.size(), 0);
+
+	size_t production_count = rules.production_count();
+	vector<uint32_t> remaining(production_count);
+	vector<symbol_id> worklist;
+
+	//For each symbol, the productions it occurs in (once per occurrence), in the same CSR layout as the grammar:
+	//symbol s occurs in occurrences[occurrenceStart[s], occurrenceStart[s + 1]).
+	vector<uint32_t> occurrenceStart(table.size() + 1, 0);
+	vector<production_id> occurrences(rules.symbol_count());
+	for (production_id p : rules.all_productions())
+	{
+		for (symbol_id elem : rules.production(p))
+		{
+			occurrenceStart[elem + 1]++;
+		}
+	}
+	for (size_t id = 0; id < table.size(); id++)
+	{
+		occurrenceStart[id + 1] += occurrenceStart[id];
+	}
+	vector<uint32_t> fill(occurrenceStart.begin(), occurrenceStart.end() - 1);
+	for (production_id p : rules.all_productions())
+	{
+		production_view production = rules.production(p);
+		remaining[p] = (uint32_t)production.size();
+		for (symbol_id elem : production)
+		{
+			occurrences[fill[elem]++] = p;
+		}
+	}
+
+	if (table.epsilon != NO_SYMBOL)
+	{
+		nullableData[table.epsilon] = 1;
+		worklist.push_back(table.epsilon);
+	}
+	//Productions with an empty RHS derive epsilon directly.
+	for (production_id p = 0; p < production_count; p++)
+	{
+		symbol_id lhs = rules.production(p).lhs;
+		if (remaining[p] == 0 && !nullableData[lhs])
+		{
+			nullableData[lhs] = 1;
+			worklist.push_back(lhs);
+		}
+	}
+
+	while (!worklist.empty())
+	{
+		symbol_id elem = worklist.back();
+		worklist.pop_back();
+		statsData.nullableSteps += 1 + occurrenceStart[elem + 1] - occurrenceStart[elem];
+		for (uint32_t o = occurrenceStart[elem]; o < occurrenceStart[elem + 1]; o++)
+		{
+			production_id p = occurrences[o];
+			symbol_id lhs = rules.production(p).lhs;
+			if (--remaining[p] == 0 && !nullableData[lhs])
+			{
+				nullableData[lhs] = 1;
+				worklist.push_back(lhs);
+			}
+		}
+	}
+}
+
+/*
+	Compute all first sets, nullable must be computed first.
+
+	FIRST(A) is the union of the terminals that directly start one of A's productions and FIRST(B)
+	for every nonterminal B that starts one of A's productions after a (possibly empty) nullable prefix.
+	That "A's FIRST depends on B" graph is condensed into SCCs and resolved in reverse topological
+	order by digraph_solve. Because nullable is already known, one union per edge is the whole fixpoint,
+	members of an SCC simply share its set. No recursion, so left recursive and very deep grammars are safe.
+*/
+void grammar_analyzer::compute_first_sets()
+{
+	size_t nonterminal_count = table.nonterminals().size();
+	vector<terminal_set> first(nonterminal_count, empty_terminal_set());
+	vector<vector<uint32_t>> depends(nonterminal_count);
+
+	//Each nonterminal only touches its own row, so they can be scanned in parallel.
+	pool().parallel_for(nonterminal_count, [&](size_t from, size_t to)
+	{
+		for (uint32_t a = (uint32_t)from; a < to; a++)
+		{
+			symbol_id lhs = table.nonterminals()[a];
+			for (production_id p : rules.productions_of(a))
+			{
+				for (symbol_id elem : rules.production(p))
+				{
+					if (table.isNonterminal(elem))
+					{
+						if (elem != lhs)
+						{
+							depends[a].push_back(table.index(elem));
+						}
+					}
+					else if (elem != table.epsilon)
+					{
+						first[a].set(table.index(elem));
+					}
+					//Later symbols only contribute while everything before them can vanish.
+					if (!nullableData[elem])
+					{
+						break;
+					}
+				}
+			}
+		}
+	});
+
+	digraph_solve(depends, first, &pool(), &statsData.firstGraph);
+
+	firstData.assign(table.size(), empty_terminal_set());
+	for (symbol_id terminal : table.terminals())
+	{
+		firstData[terminal].set(table.index(terminal));
+	}
+	for (size_t nt = 0; nt < nonterminal_count; nt++)
+	{
+		symbol_id lhs = table.nonterminals()[nt];
+		firstData[lhs] = first[nt];
+		if (nullableData[lhs])
+		{
+			firstData[lhs].unite(epsilonMask);
+			statsData.setUnions++;
+		}
+	}
+}
+
+//Fills suffixFirst/suffixNullable in one right-to-left walk over each production, must run after compute_first_sets.
+//FIRST(X β) = FIRST(X) - epsilon, plus FIRST(β) if X is nullable.
+//Productions own disjoint rows, so they are split across the pool.
+void grammar_analyzer::compute_suffix_tables()
+{
+	size_t rows = rules.symbol_count() + rules.production_count();
+	suffixFirst = terminal_set_array(table.terminals().size(), rows);
+	suffixNullable.assign(rows, 0);
+
+	pool().parallel_for(rules.production_count(), [&](size_t from, size_t to)
+	{
+		terminal_set current = empty_terminal_set();
+		for (production_id p = (production_id)from; p < to; p++)
+		{
+			production_view production = rules.production(p);
+			size_t length = production.size();
+
+			//The empty suffix: no terminals, nullable.
+			current.clear();
+			bool suffixIsNullable = true;
+			suffixNullable[suffix_row(p, length)] = 1;
+
+			for (size_t i = length; i-- > 0;)
+			{
+				symbol_id elem = production[i];
+				if (!nullableData[elem])
+				{
+					current.clear();
+					suffixIsNullable = false;
+				}
+				current.unite_difference(firstData[elem], epsilonMask);
+				suffixFirst.store(suffix_row(p, i), current);
+				suffixNullable[suffix_row(p, i)] = suffixIsNullable;
+			}
+		}
+	});
+}
+
+
+/*
+	Compute all follow sets in two passes.
+	The first pass walks every production once (see the rules above) and collects, per nonterminal,
+	the terminals that are directly known to be in its FOLLOW set and the inclusion graph
+	"FOLLOW(X) ⊆ FOLLOW(A)". The second pass resolves the graph with digraph_solve, one SCC level
+	at a time on the pool, so every set comes out fully defined even for mutually recursive nonterminals.
+*/
+void grammar_analyzer::compute_follow_sets()
+{
+	//Both are ordered by nonterminal index, see symbol_table::index.
+	size_t nonterminal_count = table.nonterminals().size();
+	vector<terminal_set> follow(nonterminal_count, empty_terminal_set());
+	vector<vector<uint32_t>> includes(nonterminal_count);
+	
+	if (table.goal != NO_SYMBOL && table.eof != NO_SYMBOL) 
+	{
+		follow[table.index(table.goal)].set(table.index(table.eof));
+	}
+
+
+	//Every position is O(1): the suffix tables already hold FIRST and nullable of whatever follows it.
+	for (production_id p : rules.all_productions())
+	{
+		production_view production = rules.production(p);
+		if (trace.enabled<TRACE_UPDATES>())
+		{
+			trace.out() << "\n\n" << table.name(production.lhs) << " ::= ";
+			for (symbol_id elem : production)
+			{
+				trace.out() << table.name(elem) << " ";
+			}
+		}
+
+		for (size_t itr = 0; itr < production.size(); itr++) 
+		{
+			symbol_id g_elem = production[itr];
+			//Terminals have no FOLLOW set of their own.
+			if (!table.isNonterminal(g_elem))
+			{
+				continue;
+			}
+
+			//The suffix after g_elem, the empty suffix if g_elem is the last element.
+			uint32_t rest = suffix_row(p, itr + 1);
+			terminal_set& current = follow[table.index(g_elem)];
+			if (trace.enabled<TRACE_UPDATES>())
+			{
+				trace.out() << "\n\tAll in FIRST of the rest, except epsilon, placed in FOLLOW(" << table.name(g_elem) << ")\n";
+			}
+			current.unite(suffixFirst[rest]);
+			statsData.setUnions++;
+			if (suffixNullable[rest])
+			{
+				if (trace.enabled<TRACE_UPDATES>())
+				{
+					trace.out() << "\tRest is nullable, everything in FOLLOW(" << table.name(production.lhs)
+						<< ") is placed in FOLLOW(" << table.name(g_elem) << ")\n";
+				}
+				//FOLLOW(X) ⊆ FOLLOW(X) adds nothing.
+				if (g_elem != production.lhs)
+				{
+					includes[table.index(g_elem)].push_back(table.index(production.lhs));
+				}
+			}
+		}
+	}
+
+
+	if (trace.enabled<TRACE_UPDATES>())
+	{
+		trace_follow_inclusions(follow, includes);
+	}
+
+	//FOLLOW(X) = directly known terminals U FOLLOW(A) for every A that X includes, transitively.
+	digraph_solve(includes, follow, &pool(), &statsData.followGraph);
+
+	followData = move(follow);
+}
+
+//FIRST+(A ::= β) = FIRST(β) - epsilon, plus FOLLOW(A) if β is nullable. Both come straight from the suffix tables.
+//Kept per production, and merged into one set per LHS for first_plus().
+void grammar_analyzer::compute_first_plus_sets()
+{
+	productionFirstPlus = terminal_set_array(table.terminals().size(), rules.production_count());
+	firstPlusData.assign(table.nonterminals().size(), empty_terminal_set());
+	terminal_set current = empty_terminal_set();
+	for (symbol_id lhs : table.nonterminals())
+	{
+		uint32_t nt = table.index(lhs);
+		for (production_id p : rules.productions_of(nt))
+		{
+			current.clear();
+			current.unite(suffixFirst[suffix_row(p, 0)]);
+			statsData.setUnions++;
+
+			//If the production is nullable then we add the LHS's FOLLOW
+			if (suffixNullable[suffix_row(p, 0)])
+			{
+				current.unite(followData[nt]);
+				statsData.setUnions++;
+			}
+			productionFirstPlus.store(p, current);
+			firstPlusData[nt].unite(current);
+			statsData.setUnions++;
+		}
+	}
+}
+
+//The grammar is LL(1) if the FIRST+ sets of each nonterminal's alternatives are pairwise disjoint.
+//Every alternative is first tested against the union of the ones before it, only a hit falls back
+//to the pairwise intersections, so a conflict free nonterminal costs one test per alternative.
+void grammar_analyzer::compute_ll1_conflicts()
+{
+	conflicts.clear();
+	terminal_set seen = empty_terminal_set();
+	for (symbol_id lhs : table.nonterminals())
+	{
+		production_range alternatives = rules.productions_of(table.index(lhs));
+		seen.clear();
+		for (production_id p : alternatives)
+		{
+			terminal_set_view current = productionFirstPlus[p];
+			if (seen.intersects(current))
+			{
+				for (production_id q : alternatives)
+				{
+					if (q == p)
+					{
+						break;
+					}
+					if (productionFirstPlus[q].intersects(current))
+					{
+						ll1_conflict conflict{ lhs, q, p, terminal_set(productionFirstPlus[q]) };
+						conflict.overlap.intersect(current);
+						conflicts.push_back(move(conflict));
+					}
+				}
+			}
+			seen.unite(current);
+		}
+	}
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <ostream>
+
+#include "symbol_table.h"
+#include "grammar.h"
+#include "terminal_set.h"
+#include "thread_pool.h"
+#include "analysis_stats.h"
+#include "trace_log.h"
+#include "grammar_transform.h"
+
+//Two alternatives of one nonterminal that a single token of lookahead can't tell apart.
+struct ll1_conflict
+{
+	symbol_id nonterminal;
+	production_id first;		//the earlier of the two alternatives
+	production_id second;
+	terminal_set overlap;		//the terminals in both FIRST+ sets
+};
+
+/*
+	FIRST, FOLLOW and FIRST+ analysis of a grammar. An analyzer owns all of its state, so any number of
+	them can live in one process and a single one can be reused for grammar after grammar:
+		load / parse	read the terminals and the rules, dropping whatever was loaded before
+		remove_useless	optionally, drop the unproductive and unreachable symbols (grammar_transform.h)
+		transform		optionally, rewrite the rules without left recursion and left factored (grammar_transform.h)
+		compute			nullable, FIRST, the suffix tables, FOLLOW, FIRST+ and the LL(1) conflicts, in that order
+		queries			valid from compute until the next load, parse or clear
+
+	Accepted format: "A ::= B | C D | E !" where ! denotes end of productions for the LHS symbol,
+	see grammar_loader.h for the details.
+*/
+class grammar_analyzer
+{
+public:
+	//compute() splits its work across pool, nullptr runs everything on the calling thread.
+	explicit grammar_analyzer(thread_pool* pool = nullptr) : workers(pool), serial(1) {}
+
+	//Both return false with error set ("path:line:column: message") if the input is malformed.
+	bool load(const char* terminals_path, const char* grammar_path, std::string& error);
+	bool parse(std::string_view terminals, std::string_view text, std::string& error);
+	void clear();
+	//Rewrites the loaded grammar, see grammar_transform.h. Results of an earlier compute are stale afterwards.
+	const transform_stats& transform(const transform_options& options = transform_options());
+	//Drops the useless symbols of the loaded grammar, see remove_useless_symbols. Symbol IDs change, so
+	//anything looked up in symbols() before is stale afterwards.
+	const useless_stats& remove_useless();
+	void compute();
+
+	//Result cache, see analysis_cache.h. read_cache takes the place of compute() if path holds the results
+	//for exactly the loaded grammar, otherwise it returns false with error saying why and changes nothing.
+	//write_cache stores the results of the last compute() or read_cache.
+	bool read_cache(const char* path, std::string& error);
+	bool write_cache(const char* path, std::string& error) const;
+	//Key of the loaded grammar's cache file, see grammar_content_hash.
+	uint64_t content_hash() const;
+
+	//Optional sink for the trace of compute(), see trace_log.h. Nothing is written while it is nullptr or
+	//level is TRACE_OFF, the output is buffered and flushed at the end of every compute.
+	void set_trace(std::ostream* out, trace_level level = TRACE_SUMMARY) { trace.open(out, level); }
+
+	//Timings and counters of the last load/parse and compute.
+	const analysis_stats& stats() const { return statsData; }
+
+	//Symbols that were neither declared as terminals nor given any rules. They are treated as terminals.
+	const std::vector<symbol_id>& undeclared() const { return undeclaredSymbols; }
+
+	const symbol_table& symbols() const { return table; }
+	const grammar& productions() const { return rules; }
+	//Name of the terminal stored at a terminal_set bit.
+	const std::string& terminal_name(size_t bit) const { return table.name(table.terminals()[bit]); }
+
+	bool nullable(symbol_id s) const { return nullableData[s] != 0; }
+	//FIRST of any symbol, with epsilon if it is nullable.
+	const terminal_set& first(symbol_id s) const { return firstData[s]; }
+	const terminal_set& follow(symbol_id nonterminal) const { return followData[table.index(nonterminal)]; }
+	//FIRST+ of all of a nonterminal's productions, merged into one set.
+	const terminal_set& first_plus(symbol_id nonterminal) const { return firstPlusData[table.index(nonterminal)]; }
+	//FIRST+ of a single production, what a predictive parser looks the next token up in.
+	terminal_set_view production_first_plus(production_id p) const { return productionFirstPlus[p]; }
+	//Every pair of alternatives whose FIRST+ sets overlap, by nonterminal order then alternative order. Empty if the grammar is LL(1).
+	const std::vector<ll1_conflict>& ll1_conflicts() const { return conflicts; }
+
+	//FIRST (without epsilon) and nullable of production p's RHS from position pos on, pos == size() is the empty suffix.
+	terminal_set_view suffix_first(production_id p, size_t pos) const { return suffixFirst[suffix_row(p, pos)]; }
+	bool suffix_nullable(production_id p, size_t pos) const { return suffixNullable[suffix_row(p, pos)] != 0; }
+
+private:
+	uint32_t suffix_row(production_id p, size_t pos) const { return rules.rhs_offset(p) + p + (uint32_t)pos; }
+	thread_pool& pool() { return workers != nullptr ? *workers : serial; }
+	terminal_set empty_terminal_set() const { return terminal_set(table.terminals().size()); }
+
+	void resolve_symbols();
+	void count_symbols();
+	void compute_nullable();
+	void compute_first_sets();
+	void compute_suffix_tables();
+	void compute_follow_sets();
+	void compute_first_plus_sets();
+	void compute_ll1_conflicts();
+	void reset_epsilon_mask();
+	void count_set_bytes();
+	void trace_summary(const char* phase, const phase_time& time);
+	void trace_graph(const char* name, const graph_stats& graph);
+	void trace_follow_inclusions(const std::vector<terminal_set>& follow, const std::vector<std::vector<uint32_t>>& includes);
+
+	thread_pool* workers;
+	thread_pool serial;
+	trace_log trace;
+
+	//Every symbol of the grammar, interned once at load time. All set computations work on its IDs.
+	symbol_table table;
+	//Every production, stored as flat arrays of symbol IDs (see grammar.h).
+	grammar rules;
+	std::vector<symbol_id> undeclaredSymbols;
+	analysis_stats statsData;
+	transform_stats transformStats;
+	useless_stats uselessStats;
+
+	//Terminal sets are one bit per terminal, indexed by symbols().index(). epsilonMask only has epsilon set,
+	//it is used to union FIRST sets 'except epsilon' in a single pass.
+	terminal_set epsilonMask;
+	std::vector<char> nullableData;				//by symbol ID, 1 if the symbol can derive epsilon
+	std::vector<terminal_set> firstData;		//by symbol ID
+	std::vector<terminal_set> followData;		//by nonterminal index
+	std::vector<terminal_set> firstPlusData;	//by nonterminal index
+
+	//FIRST(β) without epsilon and nullable(β) for every suffix β of every production's RHS, including the
+	//empty suffix at its end. Row of position i of production p: suffix_row(p, i).
+	terminal_set_array suffixFirst;
+	std::vector<char> suffixNullable;
+
+	terminal_set_array productionFirstPlus;		//by production ID
+	std::vector<ll1_conflict> conflicts;
+};
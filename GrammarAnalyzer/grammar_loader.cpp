@@ -0,0 +1,206 @@
+#include "grammar_loader.h"
+#include "mapped_file.h"
+
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+	inline bool is_space(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+	}
+
+	struct token
+	{
+		string_view text;
+		size_t line;
+		size_t column;
+	};
+
+	//Splits the input into whitespace separated tokens while keeping track of line and column.
+	class scanner
+	{
+	public:
+		explicit scanner(string_view input) : text(input) {}
+
+		bool next(token& out)
+		{
+			const char* data = text.data();
+			size_t size = text.size();
+			while (pos < size && is_space(data[pos]))
+			{
+				if (data[pos] == '\n')
+				{
+					line++;
+					lineStart = pos + 1;
+				}
+				pos++;
+			}
+			if (pos == size)
+			{
+				return false;
+			}
+			size_t start = pos;
+			while (pos < size && !is_space(data[pos]))
+			{
+				pos++;
+			}
+			out.text = string_view(data + start, pos - start);
+			out.line = line;
+			out.column = start - lineStart + 1;
+			return true;
+		}
+
+	private:
+		string_view text;
+		size_t pos = 0;
+		size_t line = 1;
+		size_t lineStart = 0;
+	};
+
+	bool fail(string& error, const char* path, size_t line, size_t column, const string& message)
+	{
+		error = string(path) + ":" + to_string(line) + ":" + to_string(column) + ": " + message;
+		return false;
+	}
+}
+
+bool load_terminals(const char* path, symbol_table& symbols, string& error)
+{
+	mapped_file file;
+	if (!file.open(path, error))
+	{
+		return false;
+	}
+	return parse_terminals(file.contents(), path, symbols, error);
+}
+
+bool parse_terminals(string_view text, const char* path, symbol_table& symbols, string& error)
+{
+	size_t start = 0;
+	for (size_t line = 1; start < text.size(); line++)
+	{
+		size_t end = text.find('\n', start);
+		if (end == string_view::npos)
+		{
+			end = text.size();
+		}
+		size_t first = start;
+		size_t last = end;
+		while (first < last && is_space(text[first]))
+		{
+			first++;
+		}
+		while (last > first && is_space(text[last - 1]))
+		{
+			last--;
+		}
+		if (first < last)
+		{
+			string_view name = text.substr(first, last - first);
+			//A blank inside the name would make a terminal no grammar token can ever be.
+			for (size_t i = 0; i < name.size(); i++)
+			{
+				if (is_space(name[i]))
+				{
+					while (is_space(name[i]))
+					{
+						i++;
+					}
+					return fail(error, path, line, first - start + i + 1, "expected one terminal per line");
+				}
+			}
+			if (name == "::=" || name == "|" || name == "!")
+			{
+				return fail(error, path, line, first - start + 1, "'" + string(name) + "' is grammar syntax, not a terminal");
+			}
+			symbols.intern(name, TERMINAL);
+		}
+		start = end + 1;
+	}
+	return true;
+}
+
+bool load_grammar(const char* path, symbol_table& symbols, grammar& productions, string& error)
+{
+	mapped_file file;
+	if (!file.open(path, error))
+	{
+		return false;
+	}
+	return parse_grammar(file.contents(), path, symbols, productions, error);
+}
+
+bool parse_grammar(string_view text, const char* path, symbol_table& symbols, grammar& productions, string& error)
+{
+	enum { EXPECT_LHS, EXPECT_ARROW, IN_RHS } state = EXPECT_LHS;
+	const string_view arrow = "::=";
+	scanner tokens(text);
+	token tok;
+	token lhsToken = {};
+	symbol_id lhs = NO_SYMBOL;
+	vector<symbol_id> rhs;
+
+	while (tokens.next(tok))
+	{
+		if (state == IN_RHS)
+		{
+			if (tok.text == "|" || tok.text == "!")
+			{
+				productions.add_production(lhs, rhs);
+				rhs.clear();
+				if (tok.text == "!")
+				{
+					state = EXPECT_LHS;
+				}
+			}
+			else if (tok.text == arrow)
+			{
+				return fail(error, path, tok.line, tok.column, "unexpected '::=', missing '!' after the rules for '" + symbols.name(lhs) + "'?");
+			}
+			else
+			{
+				rhs.push_back(symbols.intern(tok.text, UNKNOWN));
+			}
+		}
+		else if (state == EXPECT_ARROW)
+		{
+			if (tok.text != arrow)
+			{
+				return fail(error, path, tok.line, tok.column, "expected '::=' after '" + symbols.name(lhs) + "'");
+			}
+			state = IN_RHS;
+		}
+		else
+		{
+			if (tok.text == "|" || tok.text == "!" || tok.text == arrow)
+			{
+				return fail(error, path, tok.line, tok.column, "expected a nonterminal before '" + string(tok.text) + "'");
+			}
+
+			//"lhs::=" written without a space.
+			string_view name = tok.text;
+			state = EXPECT_ARROW;
+			if (name.size() > arrow.size() && name.substr(name.size() - arrow.size()) == arrow)
+			{
+				name.remove_suffix(arrow.size());
+				state = IN_RHS;
+			}
+			lhs = symbols.intern(name, NONTERMINAL);
+			lhsToken = tok;
+			if (!symbols.isNonterminal(lhs))
+			{
+				return fail(error, path, tok.line, tok.column, "'" + string(name) + "' is declared as a terminal but has rules");
+			}
+		}
+	}
+
+	if (state != EXPECT_LHS)
+	{
+		return fail(error, path, lhsToken.line, lhsToken.column, "rules for '" + symbols.name(lhs) + "' are not terminated by '!'");
+	}
+	return true;
+}
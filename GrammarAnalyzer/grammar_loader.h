@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "symbol_table.h"
+#include "grammar.h"
+
+//Loaders for the two input files. Both map the whole file and tokenize it in place, symbol names are
+//only copied when symbols interns them for the first time, and there are no limits on line or token length.
+//On failure they return false and set error to "path:line:column: message".
+
+//One terminal per line, surrounding whitespace is ignored and empty lines are skipped. A line with more
+//than one word on it or with '::=', '|' or '!' is an error.
+bool load_terminals(const char* path, symbol_table& symbols, std::string& error);
+
+//Rules look like "lhs ::= a b | c | epsilon !", tokens are separated by any whitespace (including
+//newlines), '|' starts another alternative and '!' ends the rules for lhs. '::=', '|' and '!' are only
+//special as whole tokens, so terminals such as "||" or "!=" can be used. RHS symbols which are not
+//known yet are interned as UNKNOWN.
+bool load_grammar(const char* path, symbol_table& symbols, grammar& productions, std::string& error);
+
+//The same two formats, for input that is already in memory. path is only used in error messages.
+bool parse_terminals(std::string_view text, const char* path, symbol_table& symbols, std::string& error);
+bool parse_grammar(std::string_view text, const char* path, symbol_table& symbols, grammar& productions, std::string& error);
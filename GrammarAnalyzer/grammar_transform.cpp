@@ -0,0 +1,594 @@
+#include "grammar_transform.h"
+#include "digraph.h"
+#include "stopwatch.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+using namespace std;
+
+namespace
+{
+	typedef vector<symbol_id> alternative;
+
+	//The tail of a cycle's member before it has a name: this bit plus the member's position in the cycle.
+	//Substitution carries tails into the other members' alternatives, not always at the end.
+	const symbol_id PENDING = 0x80000000;
+	const uint32_t NO_POSITION = 0xFFFFFFFF;
+	const uint32_t NO_NODE = 0xFFFFFFFF;
+
+	//Works on a copy of the grammar with one list of alternatives per nonterminal index, epsilon taken out
+	//(an empty alternative is an epsilon one), and writes it back as a grammar at the end.
+	class grammar_rewriter
+	{
+	public:
+		grammar_rewriter(symbol_table& table, const grammar& productions, const transform_options& opts, transform_stats& out)
+			: symbols(table), options(opts), stats(out), alts(table.nonterminals().size())
+		{
+			for (production_id p : productions.all_productions())
+			{
+				production_view production = productions.production(p);
+				alternative alt;
+				for (symbol_id symbol : production)
+				{
+					if (symbol != symbols.epsilon)
+					{
+						alt.push_back(symbol);
+					}
+				}
+				alts[symbols.index(production.lhs)].push_back(move(alt));
+			}
+		}
+
+		void remove_left_recursion();
+		void factor();
+		void rebuild(grammar& productions);
+
+	private:
+		uint32_t add_nonterminal(const string& base);
+		void rewrite_cycle(const uint32_t* members, size_t size);
+		uint32_t insert(uint32_t node, symbol_id symbol);
+		vector<alternative> emit(uint32_t node, const string& base);
+
+		symbol_table& symbols;
+		const transform_options& options;
+		transform_stats& stats;
+		vector<vector<alternative>> alts;		//by nonterminal index
+		vector<uint32_t> position;				//in the cycle being rewritten, NO_POSITION outside of it
+
+		//The prefix trie, one root per nonterminal that is factored. Children are a list in insertion
+		//order, so the alternatives come out in the order they went in, and found through edges.
+		vector<symbol_id> nodeSymbol;
+		vector<uint32_t> firstChild;
+		vector<uint32_t> lastChild;
+		vector<uint32_t> nextSibling;
+		vector<char> isEnd;
+		unordered_map<uint64_t, uint32_t> edges;	//node << 32 | symbol
+	};
+
+	//A new nonterminal named base, or base followed by _2, _3, ... if that name is taken.
+	uint32_t grammar_rewriter::add_nonterminal(const string& base)
+	{
+		string name = base;
+		for (size_t n = 2; symbols.find(name) != NO_SYMBOL; n++)
+		{
+			name = base + "_" + to_string(n);
+		}
+		symbols.intern(name, NONTERMINAL);
+		stats.newNonterminals++;
+		alts.emplace_back();
+		return (uint32_t)(alts.size() - 1);
+	}
+
+	void grammar_rewriter::remove_left_recursion()
+	{
+		size_t count = alts.size();
+		vector<vector<uint32_t>> corner(count);
+		vector<char> selfLoop(count, 0);
+		for (uint32_t a = 0; a < count; a++)
+		{
+			for (const alternative& alt : alts[a])
+			{
+				if (!alt.empty() && symbols.isNonterminal(alt[0]))
+				{
+					corner[a].push_back(symbols.index(alt[0]));
+					selfLoop[a] |= symbols.index(alt[0]) == a;
+				}
+			}
+		}
+		vector<uint32_t> component;
+		size_t components = digraph_components(corner, component);
+		vector<vector<uint32_t>>().swap(corner);
+
+		//Members of every component in nonterminal order, counting sort on the component.
+		vector<uint32_t> memberStart(components + 1, 0);
+		for (uint32_t c : component)
+		{
+			memberStart[c + 1]++;
+		}
+		for (size_t c = 0; c < components; c++)
+		{
+			memberStart[c + 1] += memberStart[c];
+		}
+		vector<uint32_t> members(count);
+		{
+			vector<uint32_t> next(memberStart.begin(), memberStart.end() - 1);
+			for (uint32_t a = 0; a < count; a++)
+			{
+				members[next[component[a]]++] = a;
+			}
+		}
+
+		position.assign(count, NO_POSITION);
+		for (size_t c = 0; c < components; c++)
+		{
+			size_t size = memberStart[c + 1] - memberStart[c];
+			const uint32_t* first = members.data() + memberStart[c];
+			if (size > 1 || selfLoop[first[0]])
+			{
+				rewrite_cycle(first, size);
+			}
+		}
+	}
+
+	void grammar_rewriter::rewrite_cycle(const uint32_t* members, size_t size)
+	{
+		size_t before = 0;
+		for (size_t i = 0; i < size; i++)
+		{
+			position[members[i]] = (uint32_t)i;
+			before += alts[members[i]].size();
+		}
+		size_t limit = before * options.growthLimit;
+		size_t total = 0;
+		size_t substitutions = 0;
+		bool resolved = true;
+		vector<vector<alternative>> result(size);
+		vector<vector<alternative>> tails(size);
+		vector<alternative> stack;
+		for (size_t i = 0; i < size && resolved; i++)
+		{
+			uint32_t a = members[i];
+			symbol_id self = symbols.nonterminals()[a];
+
+			//Alternatives that start with an earlier member are replaced by that member's final ones. Those
+			//start with a later member or outside the cycle, so this ends, and the stack keeps them in order.
+			for (size_t k = alts[a].size(); k-- > 0;)
+			{
+				stack.push_back(alts[a][k]);
+			}
+			vector<alternative> recursive;
+			vector<alternative> base;
+			while (!stack.empty())
+			{
+				alternative alt = move(stack.back());
+				stack.pop_back();
+				symbol_id lead = alt.empty() ? NO_SYMBOL : alt[0];
+				uint32_t j = lead == NO_SYMBOL || (lead & PENDING) != 0 || !symbols.isNonterminal(lead) ? NO_POSITION : position[symbols.index(lead)];
+				if (j != NO_POSITION && j < i)
+				{
+					substitutions++;
+					for (size_t k = result[j].size(); k-- > 0;)
+					{
+						alternative expanded = result[j][k];
+						expanded.insert(expanded.end(), alt.begin() + 1, alt.end());
+						stack.push_back(move(expanded));
+					}
+					if (total + base.size() + recursive.size() + stack.size() > limit)
+					{
+						resolved = false;
+						break;
+					}
+				}
+				else if (lead == self)
+				{
+					//A ::= A derives nothing new and is dropped.
+					if (alt.size() > 1)
+					{
+						alt.erase(alt.begin());
+						recursive.push_back(move(alt));
+					}
+				}
+				else
+				{
+					base.push_back(move(alt));
+				}
+			}
+			stack.clear();
+
+			//Direct left recursion, A ::= A a | b becomes A ::= b A_prime and A_prime ::= a A_prime | epsilon.
+			//Without a b there is nothing to start from and the cycle is left alone.
+			if (!recursive.empty())
+			{
+				if (base.empty())
+				{
+					resolved = false;
+					break;
+				}
+				symbol_id tail = PENDING | (symbol_id)i;
+				for (alternative& alt : base)
+				{
+					alt.push_back(tail);
+				}
+				for (alternative& alt : recursive)
+				{
+					alt.push_back(tail);
+				}
+				recursive.emplace_back();
+				tails[i] = move(recursive);
+			}
+			result[i] = move(base);
+			total += result[i].size() + tails[i].size();
+			resolved = resolved && total <= limit;
+		}
+
+		for (size_t i = 0; i < size; i++)
+		{
+			position[members[i]] = NO_POSITION;
+		}
+		if (!resolved)
+		{
+			stats.unresolvedCycles++;
+			return;
+		}
+		stats.substitutions += substitutions;
+		if (size == 1)
+		{
+			stats.directRecursive++;
+		}
+		else
+		{
+			stats.indirectCycles++;
+		}
+
+		//Only now that the cycle is done do the tails get names.
+		vector<symbol_id> tailSymbol(size, NO_SYMBOL);
+		vector<uint32_t> tailIndex(size, NO_POSITION);
+		for (size_t i = 0; i < size; i++)
+		{
+			if (!tails[i].empty())
+			{
+				tailIndex[i] = add_nonterminal(symbols.name(symbols.nonterminals()[members[i]]) + "_prime");
+				tailSymbol[i] = symbols.nonterminals()[tailIndex[i]];
+			}
+		}
+		for (size_t i = 0; i < size; i++)
+		{
+			for (vector<alternative>* list : { &result[i], &tails[i] })
+			{
+				for (alternative& alt : *list)
+				{
+					for (symbol_id& symbol : alt)
+					{
+						if ((symbol & PENDING) != 0)
+						{
+							symbol = tailSymbol[symbol & ~PENDING];
+						}
+					}
+				}
+			}
+			alts[members[i]] = move(result[i]);
+			if (tailIndex[i] != NO_POSITION)
+			{
+				alts[tailIndex[i]] = move(tails[i]);
+			}
+		}
+	}
+
+	uint32_t grammar_rewriter::insert(uint32_t node, symbol_id symbol)
+	{
+		uint32_t next = (uint32_t)nodeSymbol.size();
+		auto found = edges.emplace(((uint64_t)node << 32) | symbol, next);
+		if (!found.second)
+		{
+			return found.first->second;
+		}
+		nodeSymbol.push_back(symbol);
+		firstChild.push_back(NO_NODE);
+		lastChild.push_back(NO_NODE);
+		nextSibling.push_back(NO_NODE);
+		isEnd.push_back(0);
+		if (node != NO_NODE)
+		{
+			if (firstChild[node] == NO_NODE)
+			{
+				firstChild[node] = next;
+			}
+			else
+			{
+				nextSibling[lastChild[node]] = next;
+			}
+			lastChild[node] = next;
+		}
+		return next;
+	}
+
+	//The alternatives below node: each child's path down to where it branches or ends, followed by a new
+	//nonterminal for the branches if it branches, and an empty alternative last if node ends one.
+	vector<alternative> grammar_rewriter::emit(uint32_t node, const string& base)
+	{
+		vector<alternative> out;
+		for (uint32_t child = firstChild[node]; child != NO_NODE; child = nextSibling[child])
+		{
+			alternative alt;
+			uint32_t at = child;
+			alt.push_back(nodeSymbol[at]);
+			while (!isEnd[at] && firstChild[at] != NO_NODE && nextSibling[firstChild[at]] == NO_NODE)
+			{
+				at = firstChild[at];
+				alt.push_back(nodeSymbol[at]);
+			}
+			if (firstChild[at] != NO_NODE)
+			{
+				uint32_t factor = add_nonterminal(base + "_factor");
+				stats.factoredPrefixes++;
+				alt.push_back(symbols.nonterminals()[factor]);
+				vector<alternative> branches = emit(at, base);
+				alts[factor] = move(branches);
+			}
+			out.push_back(move(alt));
+		}
+		if (isEnd[node])
+		{
+			out.emplace_back();
+		}
+		return out;
+	}
+
+	void grammar_rewriter::factor()
+	{
+		size_t symbolCount = 0;
+		for (const vector<alternative>& list : alts)
+		{
+			for (const alternative& alt : list)
+			{
+				symbolCount += alt.size() + 1;
+			}
+		}
+		edges.reserve(symbolCount);
+
+		//The nonterminals added on the way are factored as they are made, so only the ones there now are walked.
+		size_t count = alts.size();
+		for (uint32_t a = 0; a < count; a++)
+		{
+			if (alts[a].size() < 2)
+			{
+				continue;
+			}
+			//Roots get a symbol of their own, the nonterminal, so their edges can't meet another root's.
+			uint32_t root = insert(NO_NODE, symbols.nonterminals()[a]);
+			for (const alternative& alt : alts[a])
+			{
+				uint32_t node = root;
+				for (symbol_id symbol : alt)
+				{
+					node = insert(node, symbol);
+				}
+				if (isEnd[node])
+				{
+					stats.duplicates++;
+				}
+				isEnd[node] = 1;
+			}
+			vector<alternative> factored = emit(root, symbols.name(symbols.nonterminals()[a]));
+			alts[a] = move(factored);
+		}
+		stats.trieNodes = nodeSymbol.size();
+	}
+
+	void grammar_rewriter::rebuild(grammar& productions)
+	{
+		grammar rebuilt;
+		alternative empty;
+		for (uint32_t a = 0; a < alts.size(); a++)
+		{
+			symbol_id lhs = symbols.nonterminals()[a];
+			for (const alternative& alt : alts[a])
+			{
+				if (!alt.empty())
+				{
+					rebuilt.add_production(lhs, alt);
+					continue;
+				}
+				if (empty.empty())
+				{
+					empty.push_back(symbols.epsilon != NO_SYMBOL ? symbols.epsilon : symbols.intern("epsilon", TERMINAL));
+				}
+				rebuilt.add_production(lhs, empty);
+			}
+		}
+		rebuilt.finalize(symbols);
+		productions = move(rebuilt);
+	}
+}
+
+void transform_grammar(symbol_table& symbols, grammar& productions, const transform_options& options, transform_stats& stats)
+{
+	stopwatch timer;
+	stats = transform_stats();
+	stats.productionsBefore = productions.production_count();
+	grammar_rewriter rewriter(symbols, productions, options, stats);
+	if (options.leftRecursion)
+	{
+		rewriter.remove_left_recursion();
+	}
+	stats.leftRecursion = timer.lap();
+	if (options.leftFactoring)
+	{
+		rewriter.factor();
+	}
+	stats.leftFactoring = timer.lap();
+	rewriter.rebuild(productions);
+	stats.productionsAfter = productions.production_count();
+	stats.rebuild = timer.lap();
+}
+
+void remove_useless_symbols(symbol_table& symbols, grammar& productions, vector<symbol_id>& renumbered, useless_stats& stats)
+{
+	stopwatch timer;
+	stats = useless_stats();
+	stats.productionsBefore = productions.production_count();
+	size_t symbolCount = symbols.size();
+	size_t productionCount = productions.production_count();
+
+	//Nonterminal occurrences in CSR form: symbol s occurs in occurrences[occurrenceStart[s], occurrenceStart[s + 1]).
+	vector<uint32_t> occurrenceStart(symbolCount + 1, 0);
+	vector<uint32_t> remaining(productionCount, 0);
+	for (production_id p : productions.all_productions())
+	{
+		for (symbol_id symbol : productions.production(p))
+		{
+			if (symbols.isNonterminal(symbol))
+			{
+				occurrenceStart[symbol + 1]++;
+				remaining[p]++;
+			}
+		}
+	}
+	for (size_t id = 0; id < symbolCount; id++)
+	{
+		occurrenceStart[id + 1] += occurrenceStart[id];
+	}
+	vector<production_id> occurrences(occurrenceStart.back());
+	vector<uint32_t> fill(occurrenceStart.begin(), occurrenceStart.end() - 1);
+	for (production_id p : productions.all_productions())
+	{
+		for (symbol_id symbol : productions.production(p))
+		{
+			if (symbols.isNonterminal(symbol))
+			{
+				occurrences[fill[symbol]++] = p;
+			}
+		}
+	}
+
+	vector<char> productive(symbolCount, 0);
+	vector<symbol_id> worklist;
+	for (production_id p = 0; p < productionCount; p++)
+	{
+		symbol_id lhs = productions.production(p).lhs;
+		if (remaining[p] == 0 && !productive[lhs])
+		{
+			productive[lhs] = 1;
+			worklist.push_back(lhs);
+		}
+	}
+	while (!worklist.empty())
+	{
+		symbol_id symbol = worklist.back();
+		worklist.pop_back();
+		for (uint32_t o = occurrenceStart[symbol]; o < occurrenceStart[symbol + 1]; o++)
+		{
+			production_id p = occurrences[o];
+			symbol_id lhs = productions.production(p).lhs;
+			if (--remaining[p] == 0 && !productive[lhs])
+			{
+				productive[lhs] = 1;
+				worklist.push_back(lhs);
+			}
+		}
+	}
+	stats.productive = timer.lap();
+
+	//remaining[p] == 0 now says production p is all productive, only those are walked and kept.
+	vector<char> live(symbolCount, 0);
+	symbol_id start = NO_SYMBOL;
+	if (symbols.goal != NO_SYMBOL && symbols.isNonterminal(symbols.goal))
+	{
+		start = symbols.goal;
+	}
+	else if (!symbols.nonterminals().empty())
+	{
+		start = symbols.nonterminals()[0];
+	}
+	if (start != NO_SYMBOL)
+	{
+		live[start] = 1;
+		worklist.push_back(start);
+	}
+	while (!worklist.empty())
+	{
+		symbol_id symbol = worklist.back();
+		worklist.pop_back();
+		for (production_id p : productions.productions_of(symbols.index(symbol)))
+		{
+			if (remaining[p] != 0)
+			{
+				continue;
+			}
+			for (symbol_id next : productions.production(p))
+			{
+				if (!live[next])
+				{
+					live[next] = 1;
+					if (symbols.isNonterminal(next))
+					{
+						worklist.push_back(next);
+					}
+				}
+			}
+		}
+	}
+	stats.reachable = timer.lap();
+
+	//Both tables are only replaced once nothing reads the old ones any more. The live symbols go in as
+	//UNKNOWN in ID order first, then get their type terminal by terminal and nonterminal by nonterminal in
+	//index order, which is what numbers them. IDs and indices both keep their old relative order that way,
+	//the nonterminals stay in the order of their first rule and not of their first appearance.
+	symbol_table liveSymbols;
+	renumbered.assign(symbolCount, NO_SYMBOL);
+	for (symbol_id id = 0; id < symbolCount; id++)
+	{
+		if (symbols.isTerminal(id) && !live[id])
+		{
+			stats.unusedTerminals.push_back(symbols.name(id));
+			live[id] = 1;
+		}
+		if (live[id])
+		{
+			renumbered[id] = liveSymbols.intern(symbols.name(id), UNKNOWN);
+			//Only the start can be live without being productive.
+			if (symbols.isNonterminal(id) && !productive[id])
+			{
+				stats.unproductive.push_back(symbols.name(id));
+				stats.emptyLanguage = true;
+			}
+		}
+		else
+		{
+			(productive[id] ? stats.unreachable : stats.unproductive).push_back(symbols.name(id));
+		}
+	}
+	for (const vector<symbol_id>* ids : { &symbols.terminals(), &symbols.nonterminals() })
+	{
+		for (symbol_id id : *ids)
+		{
+			if (live[id])
+			{
+				liveSymbols.intern(symbols.name(id), symbols.type(id));
+			}
+		}
+	}
+	grammar liveProductions;
+	vector<symbol_id> rhs;
+	for (production_id p : productions.all_productions())
+	{
+		production_view production = productions.production(p);
+		if (remaining[p] != 0 || !live[production.lhs])
+		{
+			continue;
+		}
+		rhs.clear();
+		for (symbol_id symbol : production)
+		{
+			rhs.push_back(renumbered[symbol]);
+		}
+		liveProductions.add_production(renumbered[production.lhs], rhs);
+	}
+	liveProductions.finalize(liveSymbols);
+	symbols = move(liveSymbols);
+	productions = move(liveProductions);
+	stats.productionsAfter = productions.production_count();
+	stats.rebuild = timer.lap();
+}
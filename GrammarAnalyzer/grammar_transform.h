@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "symbol_table.h"
+#include "grammar.h"
+#include "analysis_stats.h"
+
+struct transform_options
+{
+	bool leftRecursion = true;
+	bool leftFactoring = true;
+	//A left recursive cycle that substitution would grow past growthLimit times its own alternatives
+	//is left as it is and counted in unresolvedCycles.
+	size_t growthLimit = 16;
+};
+
+struct transform_stats
+{
+	phase_time leftRecursion;
+	phase_time leftFactoring;
+	phase_time rebuild;
+	size_t productionsBefore = 0;
+	size_t productionsAfter = 0;
+	size_t directRecursive = 0;			//nonterminals that were only left recursive on their own
+	size_t indirectCycles = 0;			//left recursive cycles through more than one nonterminal
+	size_t substitutions = 0;			//alternatives replaced by the alternatives of an earlier member of their cycle
+	size_t unresolvedCycles = 0;		//cycles left alone, see transform_options::growthLimit
+	size_t factoredPrefixes = 0;		//common prefixes pulled out into a nonterminal of their own
+	size_t duplicates = 0;				//alternatives dropped because an identical one came before
+	size_t newNonterminals = 0;
+	size_t trieNodes = 0;
+};
+
+/*
+	Rewrites a loaded grammar so more of it is LL(1), the way the _prime and _factor helpers of
+	language_input.txt are written by hand:
+
+	Left recursion: the left corner relation (A -> B for A ::= B ...) is split into its SCCs with
+	digraph_components and only the cyclic ones are touched. Inside a cycle the members are ordered by
+	nonterminal index and each alternative that starts with an earlier member gets that member's (already
+	rewritten) alternatives substituted for it, then direct left recursion is removed:
+		A ::= A a | b		becomes		A ::= b A_prime ! A_prime ::= a A_prime | epsilon !
+	That is Paull's algorithm, but each cycle is rewritten on its own, so the cost follows the size of the
+	cycles and not the grammar. Only the first symbol counts as left corner, left recursion hidden behind
+	a nullable prefix (A ::= B A x with B nullable) isn't seen.
+
+	Left factoring: every nonterminal's alternatives go into a prefix trie, one root per nonterminal
+	and the children of a node kept in insertion order. A path that branches after at least one symbol is
+	a common prefix: it stays in the alternative, followed by a new A_factor nonterminal whose alternatives
+	are the branches, factored the same way. Identical alternatives collapse into one.
+
+	New nonterminals are interned into symbols (epsilon too, if an empty alternative needs it and the
+	terminals file didn't declare it) and productions is rebuilt and finalized. The whole pass is linear in
+	the size of the grammar outside of left recursive cycles.
+*/
+void transform_grammar(symbol_table& symbols, grammar& productions, const transform_options& options, transform_stats& stats);
+
+//What remove_useless_symbols took out, by name since the IDs are gone afterwards.
+struct useless_stats
+{
+	phase_time productive;
+	phase_time reachable;
+	phase_time rebuild;
+	size_t productionsBefore = 0;
+	size_t productionsAfter = 0;
+	std::vector<std::string> unproductive;		//nonterminals that derive no string of terminals, goal too though it is kept
+	std::vector<std::string> unreachable;		//productive nonterminals goal can't derive a sentence through
+	std::vector<std::string> unusedTerminals;	//terminals in no production that is left, they are kept all the same
+	bool emptyLanguage = false;					//goal is unproductive, the grammar derives no sentence at all
+};
+
+/*
+	Drops the useless symbols of a loaded grammar so FIRST, FOLLOW and everything after them only see
+	the live part, in two linear passes:
+
+	Productive: every production keeps a count of the nonterminals in its RHS that aren't known to be
+	productive yet, the same counters compute_nullable uses for nullable. A production whose count is 0
+	makes its LHS productive, and each newly productive nonterminal counts down the productions it
+	occurs in. Each occurrence is counted down once.
+
+	Reachable: a walk from goal (the first nonterminal if there is none) over the productions whose RHS
+	is all productive. Only those productions are kept. goal itself always stays, with no productions
+	if it is unproductive, and is then listed in unproductive all the same with emptyLanguage set.
+
+	Terminals are never removed, the unused ones are only reported: the LL(1) tables (ll1_table.h) number
+	their columns like terminals_input.txt, and dropping one would shift every terminal after it.
+
+	symbols and productions are rebuilt with the live symbols in their old order, so IDs and terminal and
+	nonterminal indices keep their relative order. renumbered maps an old symbol ID to the new one, or
+	NO_SYMBOL if it was removed.
+*/
+void remove_useless_symbols(symbol_table& symbols, grammar& productions, std::vector<symbol_id>& renumbered, useless_stats& stats);
@@ -0,0 +1,578 @@
+#include "incremental_analysis.h"
+
+#include <algorithm>
+
+using namespace std;
+
+static const uint32_t NO_RULE = 0xFFFFFFFF;
+
+//Sorts and drops duplicates, edits collect their dirty lists with repeats.
+template <typename T>
+static void make_unique(vector<T>& values)
+{
+	sort(values.begin(), values.end());
+	values.erase(unique(values.begin(), values.end()), values.end());
+}
+
+void incremental_analysis::load(const symbol_table& source, const grammar& productions)
+{
+	//Interning in the same order keeps every symbol ID the same as in source.
+	for (symbol_id id = 0; id < source.size(); id++)
+	{
+		symbol_type type = source.type(id);
+		table.intern(source.name(id), type == UNKNOWN ? TERMINAL : type);
+	}
+	grow_tables();
+	for (production_id p : productions.all_productions())
+	{
+		production_view production = productions.production(p);
+		insert_rule(production.lhs, vector<symbol_id>(production.begin(), production.end()));
+	}
+
+	//Everything is dirty: this is the batch computation run through the incremental code.
+	const vector<symbol_id>& all = table.nonterminals();
+	update_nullable(all);
+	for (symbol_id lhs : all)
+	{
+		rebuild_first(lhs);
+	}
+	firstGraph.update(workers);
+	for (symbol_id nt : all)
+	{
+		rebuild_follow(nt);
+	}
+	followGraph.update(workers);
+	for (symbol_id lhs : all)
+	{
+		rebuild_first_plus(lhs);
+	}
+}
+
+bool incremental_analysis::declare_terminal(string_view name, analysis_changes& changes)
+{
+	changes = analysis_changes();
+	symbol_id known = table.find(name);
+	if (known != NO_SYMBOL)
+	{
+		return table.isTerminal(known);
+	}
+	vector<symbol_id> followed;
+	intern_terminal(name, followed);
+	propagate(vector<symbol_id>(), vector<rule>(), followed, changes);
+	return true;
+}
+
+bool incremental_analysis::add_production(string_view lhs, const vector<string_view>& rhs, analysis_changes& changes)
+{
+	changes = analysis_changes();
+	symbol_id left = define(lhs);
+	if (left == NO_SYMBOL)
+	{
+		return false;
+	}
+	vector<symbol_id> followed;
+	uint32_t r = insert_rule(left, intern_rhs(rhs, followed));
+	propagate(vector<symbol_id>(1, left), vector<rule>(1, rules[r]), followed, changes);
+	return true;
+}
+
+bool incremental_analysis::remove_production(string_view lhs, const vector<string_view>& rhs, analysis_changes& changes)
+{
+	changes = analysis_changes();
+	symbol_id left = table.find(lhs);
+	if (left == NO_SYMBOL || !table.isNonterminal(left))
+	{
+		return false;
+	}
+	uint32_t r = find_rule(left, rhs);
+	if (r == NO_RULE)
+	{
+		return false;
+	}
+	vector<rule> edited(1, rules[r]);
+	erase_rule(r);
+	propagate(vector<symbol_id>(1, left), edited, vector<symbol_id>(), changes);
+	return true;
+}
+
+bool incremental_analysis::replace_production(string_view lhs, const vector<string_view>& before,
+	const vector<string_view>& after, analysis_changes& changes)
+{
+	changes = analysis_changes();
+	symbol_id left = table.find(lhs);
+	if (left == NO_SYMBOL || !table.isNonterminal(left))
+	{
+		return false;
+	}
+	uint32_t r = find_rule(left, before);
+	if (r == NO_RULE)
+	{
+		return false;
+	}
+	vector<rule> edited(1, rules[r]);
+	erase_rule(r);
+	vector<symbol_id> followed;
+	r = insert_rule(left, intern_rhs(after, followed));
+	edited.push_back(rules[r]);
+	propagate(vector<symbol_id>(1, left), edited, followed, changes);
+	return true;
+}
+
+terminal_set incremental_analysis::first(symbol_id s) const
+{
+	terminal_set result(table.terminals().size());
+	if (table.isTerminal(s))
+	{
+		result.set(table.index(s));
+		return result;
+	}
+	result.unite(firstGraph[table.index(s)]);
+	if (nullableData[s])
+	{
+		result.unite(epsilonMask);
+	}
+	return result;
+}
+
+symbol_id incremental_analysis::define(string_view lhs)
+{
+	symbol_id known = table.find(lhs);
+	if (known != NO_SYMBOL && table.isTerminal(known))
+	{
+		return NO_SYMBOL;
+	}
+	symbol_id id = table.intern(lhs, NONTERMINAL);
+	grow_tables();
+	return id;
+}
+
+//Widens every set for a new terminal.
+symbol_id incremental_analysis::intern_terminal(string_view name, vector<symbol_id>& followed)
+{
+	symbol_id id = table.intern(name, TERMINAL);
+	size_t terminal_count = table.terminals().size();
+	epsilonMask.resize(terminal_count);
+	firstGraph.widen(terminal_count);
+	followGraph.widen(terminal_count);
+	for (terminal_set& set : firstPlusData)
+	{
+		set.resize(terminal_count);
+	}
+	grow_tables();
+
+	//goal's FOLLOW starts with $, so declaring $ late is an edit of its own.
+	if (id == table.eof && table.goal != NO_SYMBOL && table.isNonterminal(table.goal))
+	{
+		followed.push_back(table.goal);
+	}
+	return id;
+}
+
+//Names not seen before are undeclared terminals, as grammar_analyzer takes them.
+vector<symbol_id> incremental_analysis::intern_rhs(const vector<string_view>& rhs, vector<symbol_id>& followed)
+{
+	vector<symbol_id> result;
+	result.reserve(rhs.size());
+	for (string_view name : rhs)
+	{
+		symbol_id known = table.find(name);
+		result.push_back(known != NO_SYMBOL ? known : intern_terminal(name, followed));
+	}
+	return result;
+}
+
+uint32_t incremental_analysis::find_rule(symbol_id lhs, const vector<string_view>& rhs) const
+{
+	for (uint32_t r : rulesOf[table.index(lhs)])
+	{
+		const vector<symbol_id>& symbols = rules[r].rhs;
+		if (symbols.size() != rhs.size())
+		{
+			continue;
+		}
+		size_t i = 0;
+		while (i < rhs.size() && table.find(rhs[i]) == symbols[i])
+		{
+			i++;
+		}
+		if (i == rhs.size())
+		{
+			return r;
+		}
+	}
+	return NO_RULE;
+}
+
+uint32_t incremental_analysis::insert_rule(symbol_id lhs, const vector<symbol_id>& rhs)
+{
+	uint32_t r;
+	if (!freeRules.empty())
+	{
+		r = freeRules.back();
+		freeRules.pop_back();
+	}
+	else
+	{
+		r = (uint32_t)rules.size();
+		rules.push_back(rule());
+	}
+	rules[r].lhs = lhs;
+	rules[r].rhs = rhs;
+	rulesOf[table.index(lhs)].push_back(r);
+	for (symbol_id s : rhs)
+	{
+		occurrences[s].push_back(r);
+	}
+	return r;
+}
+
+void incremental_analysis::erase_rule(uint32_t r)
+{
+	//Alternatives keep their order, the occurrence lists don't need to.
+	vector<uint32_t>& alternatives = rulesOf[table.index(rules[r].lhs)];
+	alternatives.erase(find(alternatives.begin(), alternatives.end(), r));
+	for (symbol_id s : rules[r].rhs)
+	{
+		vector<uint32_t>& uses = occurrences[s];
+		*find(uses.begin(), uses.end(), r) = uses.back();
+		uses.pop_back();
+	}
+	rules[r].rhs.clear();
+	freeRules.push_back(r);
+}
+
+//Sizes every table for the symbols interned so far.
+void incremental_analysis::grow_tables()
+{
+	size_t terminal_count = table.terminals().size();
+	size_t nonterminal_count = table.nonterminals().size();
+
+	if (epsilonMask.size() != terminal_count)
+	{
+		epsilonMask.resize(terminal_count);
+	}
+	nullableData.resize(table.size(), 0);
+	mark.resize(table.size(), 0);
+	occurrences.resize(table.size());
+	if (table.epsilon != NO_SYMBOL && table.isTerminal(table.epsilon))
+	{
+		nullableData[table.epsilon] = 1;
+		epsilonMask.set(table.index(table.epsilon));
+	}
+
+	rulesOf.resize(nonterminal_count);
+	firstGraph.resize(nonterminal_count, terminal_count);
+	followGraph.resize(nonterminal_count, terminal_count);
+	while (firstPlusData.size() < nonterminal_count)
+	{
+		firstPlusData.push_back(terminal_set(terminal_count));
+	}
+}
+
+void incremental_analysis::propagate(vector<symbol_id> edited, const vector<rule>& edited_rules,
+	vector<symbol_id> followed, analysis_changes& changes)
+{
+	make_unique(edited);
+
+	//FIRST: the edited LHS, plus every LHS whose nullable prefix got longer or shorter.
+	vector<symbol_id> nullableChanged = update_nullable(edited);
+	vector<symbol_id> dirty = edited;
+	for (symbol_id s : nullableChanged)
+	{
+		for (uint32_t r : occurrences[s])
+		{
+			dirty.push_back(rules[r].lhs);
+		}
+	}
+	make_unique(dirty);
+	for (symbol_id lhs : dirty)
+	{
+		rebuild_first(lhs);
+	}
+	changes.first = nullableChanged;
+	for (uint32_t nt : firstGraph.update(workers))
+	{
+		changes.first.push_back(table.nonterminals()[nt]);
+	}
+	make_unique(changes.first);
+
+	//FOLLOW: everything in an added or removed production, and everything in front of a changed FIRST.
+	for (const rule& edit : edited_rules)
+	{
+		for (symbol_id s : edit.rhs)
+		{
+			if (table.isNonterminal(s))
+			{
+				followed.push_back(s);
+			}
+		}
+	}
+	for (symbol_id s : changes.first)
+	{
+		for (uint32_t r : occurrences[s])
+		{
+			const vector<symbol_id>& rhs = rules[r].rhs;
+			size_t last = rhs.size();
+			while (rhs[last - 1] != s)
+			{
+				last--;
+			}
+			for (size_t i = 0; i + 1 < last; i++)
+			{
+				if (table.isNonterminal(rhs[i]))
+				{
+					followed.push_back(rhs[i]);
+				}
+			}
+		}
+	}
+	if (table.goal != NO_SYMBOL && binary_search(edited.begin(), edited.end(), table.goal))
+	{
+		followed.push_back(table.goal);
+	}
+	make_unique(followed);
+	for (symbol_id nt : followed)
+	{
+		rebuild_follow(nt);
+	}
+	for (uint32_t nt : followGraph.update(workers))
+	{
+		changes.follow.push_back(table.nonterminals()[nt]);
+	}
+	make_unique(changes.follow);
+
+	//FIRST+: the edited LHS, anything using a changed FIRST, and every changed FOLLOW.
+	dirty = edited;
+	for (symbol_id s : changes.first)
+	{
+		for (uint32_t r : occurrences[s])
+		{
+			dirty.push_back(rules[r].lhs);
+		}
+	}
+	dirty.insert(dirty.end(), changes.follow.begin(), changes.follow.end());
+	make_unique(dirty);
+	for (symbol_id lhs : dirty)
+	{
+		if (rebuild_first_plus(lhs))
+		{
+			changes.firstPlus.push_back(lhs);
+		}
+	}
+}
+
+bool incremental_analysis::rule_nullable(uint32_t r) const
+{
+	for (symbol_id s : rules[r].rhs)
+	{
+		if (!nullableData[s])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+	Delete and rederive: every edited LHS that was nullable, and everything that was only nullable
+	because of it, is cleared first. Then the cleared symbols, and the edited ones, get the chance to
+	become nullable again from any production whose RHS is all nullable, which is passed on to the
+	productions they occur in. Returns the symbols whose nullable changed.
+*/
+vector<symbol_id> incremental_analysis::update_nullable(const vector<symbol_id>& edited)
+{
+	vector<symbol_id> cleared;
+	for (symbol_id lhs : edited)
+	{
+		if (nullableData[lhs] && !mark[lhs])
+		{
+			mark[lhs] = 1;
+			cleared.push_back(lhs);
+		}
+	}
+	for (size_t i = 0; i < cleared.size(); i++)
+	{
+		for (uint32_t r : occurrences[cleared[i]])
+		{
+			symbol_id lhs = rules[r].lhs;
+			if (nullableData[lhs] && !mark[lhs])
+			{
+				mark[lhs] = 1;
+				cleared.push_back(lhs);
+			}
+		}
+	}
+	for (symbol_id s : cleared)
+	{
+		nullableData[s] = 0;
+	}
+
+	vector<symbol_id> worklist;
+	vector<symbol_id> changed;
+	auto derive = [&](symbol_id lhs)
+	{
+		nullableData[lhs] = 1;
+		worklist.push_back(lhs);
+		if (!mark[lhs])
+		{
+			changed.push_back(lhs);
+		}
+	};
+	auto retry = [&](symbol_id lhs)
+	{
+		if (nullableData[lhs])
+		{
+			return;
+		}
+		for (uint32_t r : rulesOf[table.index(lhs)])
+		{
+			if (rule_nullable(r))
+			{
+				derive(lhs);
+				return;
+			}
+		}
+	};
+	for (symbol_id lhs : cleared)
+	{
+		retry(lhs);
+	}
+	for (symbol_id lhs : edited)
+	{
+		retry(lhs);
+	}
+	while (!worklist.empty())
+	{
+		symbol_id s = worklist.back();
+		worklist.pop_back();
+		for (uint32_t r : occurrences[s])
+		{
+			symbol_id lhs = rules[r].lhs;
+			if (!nullableData[lhs] && rule_nullable(r))
+			{
+				derive(lhs);
+			}
+		}
+	}
+
+	for (symbol_id s : cleared)
+	{
+		mark[s] = 0;
+		if (!nullableData[s])
+		{
+			changed.push_back(s);
+		}
+	}
+	return changed;
+}
+
+void incremental_analysis::add_first(terminal_set& set, symbol_id s) const
+{
+	if (table.isNonterminal(s))
+	{
+		set.unite(firstGraph[table.index(s)]);
+	}
+	else if (s != table.epsilon)
+	{
+		set.set(table.index(s));
+	}
+}
+
+//Same scan as compute_first_sets: direct terminals and nonterminals behind a nullable prefix.
+void incremental_analysis::rebuild_first(symbol_id lhs)
+{
+	terminal_set seed(table.terminals().size());
+	vector<uint32_t> edges;
+	for (uint32_t r : rulesOf[table.index(lhs)])
+	{
+		for (symbol_id s : rules[r].rhs)
+		{
+			if (table.isNonterminal(s))
+			{
+				if (s != lhs)
+				{
+					edges.push_back(table.index(s));
+				}
+			}
+			else if (s != table.epsilon)
+			{
+				seed.set(table.index(s));
+			}
+			if (!nullableData[s])
+			{
+				break;
+			}
+		}
+	}
+	make_unique(edges);
+	firstGraph.set_node(table.index(lhs), seed, edges);
+}
+
+//Same rules as compute_follow_sets, for every place the nonterminal occurs.
+void incremental_analysis::rebuild_follow(symbol_id nonterminal)
+{
+	terminal_set seed(table.terminals().size());
+	vector<uint32_t> edges;
+	if (nonterminal == table.goal && table.eof != NO_SYMBOL)
+	{
+		seed.set(table.index(table.eof));
+	}
+	vector<uint32_t> uses = occurrences[nonterminal];
+	make_unique(uses);
+	for (uint32_t r : uses)
+	{
+		const vector<symbol_id>& rhs = rules[r].rhs;
+		for (size_t i = 0; i < rhs.size(); i++)
+		{
+			if (rhs[i] != nonterminal)
+			{
+				continue;
+			}
+			size_t j = i + 1;
+			while (j < rhs.size())
+			{
+				add_first(seed, rhs[j]);
+				if (!nullableData[rhs[j]])
+				{
+					break;
+				}
+				j++;
+			}
+			if (j == rhs.size() && rules[r].lhs != nonterminal)
+			{
+				edges.push_back(table.index(rules[r].lhs));
+			}
+		}
+	}
+	make_unique(edges);
+	followGraph.set_node(table.index(nonterminal), seed, edges);
+}
+
+bool incremental_analysis::rebuild_first_plus(symbol_id lhs)
+{
+	uint32_t nt = table.index(lhs);
+	terminal_set result(table.terminals().size());
+	for (uint32_t r : rulesOf[nt])
+	{
+		bool vanishes = true;
+		for (symbol_id s : rules[r].rhs)
+		{
+			add_first(result, s);
+			if (!nullableData[s])
+			{
+				vanishes = false;
+				break;
+			}
+		}
+		if (vanishes)
+		{
+			result.unite(followGraph[nt]);
+		}
+	}
+	if (result == firstPlusData[nt])
+	{
+		return false;
+	}
+	firstPlusData[nt] = result;
+	return true;
+}
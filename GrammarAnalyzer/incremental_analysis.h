@@ -0,0 +1,101 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+#include "symbol_table.h"
+#include "grammar.h"
+#include "terminal_set.h"
+#include "incremental_digraph.h"
+#include "thread_pool.h"
+
+//Nonterminals whose sets changed because of one edit, sorted by symbol ID.
+//first includes changes that only added or removed epsilon (i.e. nullable changed).
+struct analysis_changes
+{
+	std::vector<symbol_id> first;
+	std::vector<symbol_id> follow;
+	std::vector<symbol_id> firstPlus;
+};
+
+/*
+	FIRST, FOLLOW and FIRST+ that follow a grammar through single production edits.
+
+	Every edit is applied straight away and only the sets it can affect are recomputed:
+		nullable	the edited LHS and whatever used it, deleted and rederived with the usual counters
+		FIRST		nonterminals whose productions changed, or whose nullable prefix did
+		FOLLOW		nonterminals appearing in a changed production, or in front of a symbol whose FIRST changed
+		FIRST+		the edited LHS, and anything whose productions see a changed FIRST or whose FOLLOW changed
+	FIRST and FOLLOW are repaired with incremental_digraph, so only their affected SCCs are solved again.
+
+	A RHS name that hasn't been seen before is an undeclared terminal, as in grammar_analyzer, so a
+	nonterminal needs a production of its own before another production uses it. A new LHS name is a
+	nonterminal. A new terminal, declared or not, widens every set and is the one edit that costs time in
+	the size of the grammar. The edit functions return false, and change nothing, if lhs is a terminal or
+	the production isn't there.
+*/
+class incremental_analysis
+{
+public:
+	explicit incremental_analysis(thread_pool* pool = nullptr) : workers(pool) {}
+
+	//Starts from a loaded grammar, unknown symbols are taken as terminals like update_all_grammar does.
+	void load(const symbol_table& source, const grammar& productions);
+
+	bool declare_terminal(std::string_view name, analysis_changes& changes);
+	bool add_production(std::string_view lhs, const std::vector<std::string_view>& rhs, analysis_changes& changes);
+	bool remove_production(std::string_view lhs, const std::vector<std::string_view>& rhs, analysis_changes& changes);
+	bool replace_production(std::string_view lhs, const std::vector<std::string_view>& before,
+		const std::vector<std::string_view>& after, analysis_changes& changes);
+
+	const symbol_table& symbols() const { return table; }
+	bool nullable(symbol_id s) const { return nullableData[s] != 0; }
+	//FIRST of any symbol, with epsilon if it is nullable.
+	terminal_set first(symbol_id s) const;
+	const terminal_set& follow(symbol_id nonterminal) const { return followGraph[table.index(nonterminal)]; }
+	const terminal_set& first_plus(symbol_id nonterminal) const { return firstPlusData[table.index(nonterminal)]; }
+
+private:
+	struct rule
+	{
+		symbol_id lhs;
+		std::vector<symbol_id> rhs;
+	};
+
+	symbol_id define(std::string_view lhs);
+	//followed gets goal if $ is among the new terminals.
+	symbol_id intern_terminal(std::string_view name, std::vector<symbol_id>& followed);
+	std::vector<symbol_id> intern_rhs(const std::vector<std::string_view>& rhs, std::vector<symbol_id>& followed);
+	uint32_t find_rule(symbol_id lhs, const std::vector<std::string_view>& rhs) const;
+	uint32_t insert_rule(symbol_id lhs, const std::vector<symbol_id>& rhs);
+	void erase_rule(uint32_t r);
+	void grow_tables();
+
+	//Recomputes everything that depends on the productions of edited (nonterminals), edited_rules are
+	//the added and removed productions.
+	//followed are nonterminals whose own FOLLOW seed changed, i.e. goal once $ is declared.
+	void propagate(std::vector<symbol_id> edited, const std::vector<rule>& edited_rules,
+		std::vector<symbol_id> followed, analysis_changes& changes);
+	std::vector<symbol_id> update_nullable(const std::vector<symbol_id>& edited);
+	void rebuild_first(symbol_id lhs);
+	void rebuild_follow(symbol_id nonterminal);
+	bool rebuild_first_plus(symbol_id lhs);
+	bool rule_nullable(uint32_t r) const;
+	//this |= FIRST(s) - epsilon
+	void add_first(terminal_set& set, symbol_id s) const;
+
+	thread_pool* workers;
+	symbol_table table;
+	terminal_set epsilonMask;
+
+	std::vector<rule> rules;
+	std::vector<uint32_t> freeRules;
+	std::vector<std::vector<uint32_t>> rulesOf;				//by nonterminal index
+	std::vector<std::vector<uint32_t>> occurrences;			//by symbol ID, one entry per RHS occurrence
+
+	std::vector<char> nullableData;							//by symbol ID
+	std::vector<char> mark;									//by symbol ID, all clear between edits
+	incremental_digraph firstGraph;							//by nonterminal index, without epsilon
+	incremental_digraph followGraph;						//by nonterminal index
+	std::vector<terminal_set> firstPlusData;				//by nonterminal index
+};
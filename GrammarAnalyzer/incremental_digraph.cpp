@@ -0,0 +1,200 @@
+#include "incremental_digraph.h"
+#include "digraph.h"
+
+#include <algorithm>
+
+using namespace std;
+
+void incremental_digraph::resize(size_t node_count, size_t terminal_count)
+{
+	if (terminal_count != bitCount)
+	{
+		widen(terminal_count);
+	}
+	while (sets.size() < node_count)
+	{
+		seeds.push_back(terminal_set(bitCount));
+		sets.push_back(terminal_set(bitCount));
+		successors.push_back(vector<uint32_t>());
+		predecessors.push_back(vector<uint32_t>());
+		isDirty.push_back(0);
+		slot.push_back(OUTSIDE);
+		stamp.push_back(0);
+	}
+}
+
+void incremental_digraph::widen(size_t terminal_count)
+{
+	bitCount = terminal_count;
+	for (size_t x = 0; x < sets.size(); x++)
+	{
+		seeds[x].resize(terminal_count);
+		sets[x].resize(terminal_count);
+	}
+}
+
+void incremental_digraph::set_node(uint32_t x, const terminal_set& seed, const vector<uint32_t>& edges)
+{
+	for (uint32_t y : successors[x])
+	{
+		vector<uint32_t>& back = predecessors[y];
+		auto found = find(back.begin(), back.end(), x);
+		*found = back.back();
+		back.pop_back();
+	}
+	successors[x] = edges;
+	for (uint32_t y : edges)
+	{
+		predecessors[y].push_back(x);
+	}
+	seeds[x] = seed;
+
+	if (!isDirty[x])
+	{
+		isDirty[x] = 1;
+		dirty.push_back(x);
+	}
+}
+
+uint32_t& incremental_digraph::slot_of(uint32_t x)
+{
+	if (stamp[x] != epoch)
+	{
+		stamp[x] = epoch;
+		slot[x] = OUTSIDE;
+	}
+	return slot[x];
+}
+
+vector<uint32_t> incremental_digraph::update(thread_pool* pool)
+{
+	vector<uint32_t> changed;
+	if (dirty.empty())
+	{
+		return changed;
+	}
+	epoch++;
+
+	//1. Over-delete. removed[i] is what region[i] may have lost, old[i] its set before the update.
+	vector<uint32_t> region;
+	vector<terminal_set> removed;
+	vector<terminal_set> old;
+	vector<uint32_t> worklist;
+	vector<char> queued;
+	for (uint32_t x : dirty)
+	{
+		isDirty[x] = 0;
+		slot_of(x) = (uint32_t)region.size();
+		region.push_back(x);
+		old.push_back(sets[x]);
+		removed.push_back(sets[x]);
+		removed.back().subtract(seeds[x]);
+		worklist.push_back(slot_of(x));
+		queued.push_back(1);
+	}
+	dirty.clear();
+
+	terminal_set lost(bitCount);
+	while (!worklist.empty())
+	{
+		uint32_t i = worklist.back();
+		worklist.pop_back();
+		queued[i] = 0;
+		for (uint32_t p : predecessors[region[i]])
+		{
+			//p only loses what it had and can't vouch for itself.
+			lost = removed[i];
+			lost.intersect(sets[p]);
+			lost.subtract(seeds[p]);
+			if (lost.empty())
+			{
+				continue;
+			}
+			uint32_t& j = slot_of(p);
+			if (j == OUTSIDE)
+			{
+				j = (uint32_t)region.size();
+				region.push_back(p);
+				old.push_back(sets[p]);
+				removed.push_back(lost);
+				queued.push_back(0);
+			}
+			else if (!removed[j].unite(lost))
+			{
+				continue;
+			}
+			if (!queued[j])
+			{
+				queued[j] = 1;
+				worklist.push_back(j);
+			}
+		}
+	}
+
+	//2. Rederive the region on its own, with everything outside it folded into the initial sets.
+	size_t region_size = region.size();
+	vector<vector<uint32_t>> relation(region_size);
+	vector<terminal_set> local(region_size);
+	for (size_t i = 0; i < region_size; i++)
+	{
+		uint32_t x = region[i];
+		local[i] = old[i];
+		local[i].subtract(removed[i]);
+		local[i].unite(seeds[x]);
+		for (uint32_t y : successors[x])
+		{
+			uint32_t j = slot_of(y);
+			if (j == OUTSIDE)
+			{
+				local[i].unite(sets[y]);
+			}
+			else if (j != i)
+			{
+				relation[i].push_back(j);
+			}
+		}
+	}
+	digraph_solve(relation, local, pool);
+
+	//3. Grow. Anything a region node gained over its old set may still be missing further up.
+	for (size_t i = 0; i < region_size; i++)
+	{
+		uint32_t x = region[i];
+		sets[x] = local[i];
+		lost = sets[x];
+		lost.subtract(old[i]);
+		if (!lost.empty())
+		{
+			worklist.push_back(x);
+		}
+	}
+	vector<uint32_t> grown;
+	while (!worklist.empty())
+	{
+		uint32_t x = worklist.back();
+		worklist.pop_back();
+		for (uint32_t p : predecessors[x])
+		{
+			if (sets[p].unite(sets[x]))
+			{
+				uint32_t& j = slot_of(p);
+				if (j == OUTSIDE)
+				{
+					j = GROWN;
+					grown.push_back(p);
+				}
+				worklist.push_back(p);
+			}
+		}
+	}
+
+	for (size_t i = 0; i < region_size; i++)
+	{
+		if (sets[region[i]] != old[i])
+		{
+			changed.push_back(region[i]);
+		}
+	}
+	changed.insert(changed.end(), grown.begin(), grown.end());
+	return changed;
+}
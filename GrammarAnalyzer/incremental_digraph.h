@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "terminal_set.h"
+#include "thread_pool.h"
+
+/*
+	The digraph problem of digraph.h, kept up to date while nodes change.
+
+		F(x) = seed(x) U { F(y) | x R y }
+
+	set_node replaces a node's seed and outgoing edges, update() then repairs only what that can reach,
+	in the usual delete and rederive style:
+		1. over-delete: the edited nodes lose everything that isn't in their own seed, and every node
+		   that can reach them loses the same terminals unless its own seed still has them.
+		2. rederive: the over-deleted region is solved with digraph_solve, nodes outside the region are
+		   still exact and are read as constants. Only the SCCs inside the region are recomputed.
+		3. grow: terminals that are new to a node are pushed on to its predecessors until nothing changes.
+	Each step stops as soon as a set stays the same, so the work follows the size of the change and not
+	the size of the relation.
+*/
+class incremental_digraph
+{
+public:
+	//Adds empty nodes until there are node_count of them.
+	void resize(size_t node_count, size_t terminal_count);
+	//Makes room in every set for terminals declared later.
+	void widen(size_t terminal_count);
+	size_t size() const { return sets.size(); }
+
+	//Replaces x's own terminals and the nodes it includes. Nothing is recomputed until update().
+	void set_node(uint32_t x, const terminal_set& seed, const std::vector<uint32_t>& edges);
+
+	//Brings every set up to date, returns the nodes whose set changed (in no particular order).
+	std::vector<uint32_t> update(thread_pool* pool = nullptr);
+
+	const terminal_set& operator[](uint32_t x) const { return sets[x]; }
+
+private:
+	static constexpr uint32_t OUTSIDE = 0xFFFFFFFF;
+	static constexpr uint32_t GROWN = 0xFFFFFFFE;
+
+	//Region slot of x during update(), OUTSIDE for every node that isn't in it and GROWN once
+	//a node outside the region has gained terminals.
+	uint32_t& slot_of(uint32_t x);
+
+	std::vector<terminal_set> seeds;
+	std::vector<terminal_set> sets;
+	std::vector<std::vector<uint32_t>> successors;
+	std::vector<std::vector<uint32_t>> predecessors;
+	std::vector<uint32_t> dirty;
+	std::vector<char> isDirty;
+	size_t bitCount = 0;
+
+	//Scratch space reused by update(), an entry of slot is only valid if its stamp is the current epoch,
+	//so nothing has to be cleared between updates.
+	std::vector<uint32_t> slot;
+	std::vector<uint32_t> stamp;
+	uint32_t epoch = 0;
+};
@@ -0,0 +1,348 @@
+#include "lalr_lookahead.h"
+#include "grammar_analyzer.h"
+#include "digraph.h"
+#include "thread_pool.h"
+#include "stopwatch.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+	const uint32_t NO_KERNEL_ITEM = 0xFFFFFFFF;
+	const uint32_t NO_REDUCTION = 0xFFFFFFFF;
+	const uint32_t NO_ROW = 0xFFFFFFFF;
+
+	void add(phase_time& total, const phase_time& lap)
+	{
+		total.wall += lap.wall;
+		total.cpu += lap.cpu;
+	}
+}
+
+void lalr_lookahead::compute(const lr0_automaton& automaton, const grammar_analyzer& analyzer, thread_pool* pool)
+{
+	stopwatch timer;
+	statsData = lalr_stats();
+	const symbol_table& symbols = analyzer.symbols();
+	const grammar& productions = analyzer.productions();
+	size_t terminalCount = symbols.terminals().size();
+	lookaheads = terminal_set_array(terminalCount, automaton.reduction_count());
+	if (automaton.state_count() == 0)
+	{
+		statsData.relations = timer.lap();
+		return;
+	}
+	thread_pool serial(1);
+	thread_pool& workers = pool != nullptr ? *pool : serial;
+
+	//One node per nonterminal transition, numbered in transition order, and the end of the input last.
+	//nodeFrom is the state the transition leaves, the one the walks below start in.
+	vector<uint32_t> nodeOf(automaton.transition_count(), NO_TRANSITION);
+	vector<uint32_t> nodeTransition;
+	vector<state_id> nodeFrom;
+	for (state_id state = 0; state < automaton.state_count(); state++)
+	{
+		for (uint32_t t = automaton.transition_begin(state); t < automaton.transition_end(state); t++)
+		{
+			if (symbols.isNonterminal(automaton.transition_symbol(t)))
+			{
+				nodeOf[t] = (uint32_t)nodeTransition.size();
+				nodeTransition.push_back(t);
+				nodeFrom.push_back(state);
+			}
+		}
+	}
+	uint32_t endNode = (uint32_t)nodeTransition.size();
+	size_t nodeCount = nodeTransition.size() + 1;
+	uint32_t start = symbols.goal != NO_SYMBOL && symbols.isNonterminal(symbols.goal) ? symbols.index(symbols.goal) : 0;
+	nodeFrom.push_back(0);
+	statsData.nodes = nodeCount;
+	auto lhs_of = [&](size_t node)
+	{
+		return node == endNode ? start : symbols.index(automaton.transition_symbol(nodeTransition[node]));
+	};
+
+	//DR and reads only depend on the state goto(p, A), which is the target of many transitions, so both are
+	//read off the transitions of every state reached on a nonterminal once and then copied to the nodes.
+	vector<uint32_t> stateRow(automaton.state_count(), NO_ROW);
+	size_t rows = 0;
+	for (state_id state = 0; state < automaton.state_count(); state++)
+	{
+		symbol_id accessing = automaton.accessing_symbol(state);
+		if (accessing != NO_SYMBOL && symbols.isNonterminal(accessing))
+		{
+			stateRow[state] = (uint32_t)rows++;
+		}
+	}
+	terminal_set_array direct(terminalCount, rows);
+	vector<uint32_t> readsStart(rows + 1, 0);
+	vector<uint32_t> readsNode;
+	{
+		terminal_set row(terminalCount);
+		for (state_id state = 0; state < automaton.state_count(); state++)
+		{
+			if (stateRow[state] == NO_ROW)
+			{
+				continue;
+			}
+			row.clear();
+			for (uint32_t t = automaton.transition_begin(state); t < automaton.transition_end(state); t++)
+			{
+				symbol_id symbol = automaton.transition_symbol(t);
+				if (!symbols.isNonterminal(symbol))
+				{
+					row.set(symbols.index(symbol));
+				}
+				else if (analyzer.nullable(symbol))
+				{
+					readsNode.push_back(nodeOf[t]);
+				}
+			}
+			direct.store(stateRow[state], row);
+			readsStart[stateRow[state] + 1] = (uint32_t)readsNode.size();
+		}
+	}
+	vector<terminal_set> sets(nodeCount, terminal_set(terminalCount));
+	vector<vector<uint32_t>> relation(nodeCount);
+	workers.parallel_for(endNode, [&](size_t from, size_t to)
+	{
+		for (size_t node = from; node < to; node++)
+		{
+			uint32_t row = stateRow[automaton.transition_target(nodeTransition[node])];
+			sets[node].unite(direct[row]);
+			relation[node].assign(readsNode.begin() + readsStart[row], readsNode.begin() + readsStart[row + 1]);
+		}
+	});
+	if (symbols.eof != NO_SYMBOL)
+	{
+		sets[endNode].set(symbols.index(symbols.eof));
+	}
+	for (const vector<uint32_t>& edges : relation)
+	{
+		statsData.readsEdges += edges.size();
+	}
+	add(statsData.relations, timer.lap());
+	digraph_solve(relation, sets, pool, &statsData.readsGraph);
+	statsData.reads = timer.lap();
+
+	//includes and lookback both come from following every production of B from p' through the automaton:
+	//each nonterminal on the way with a nullable rest includes (p', B) and the state the walk ends in has
+	//the reduction that looks back at it. Past its first step a walk only goes through kernel items, and
+	//there are few of those next to the walks, so every kernel item gets the kernel item one step further
+	//and the reduction its path ends in once. A walk is then one transition lookup and a hop from kernel
+	//item to kernel item, and only as far as the last nonterminal that includes.
+	const item_id* kernelBase = automaton.kernel_begin(0);
+	size_t kernelCount = automaton.kernel_item_count();
+	vector<uint32_t> kernelNext(kernelCount, NO_KERNEL_ITEM);			//NO_KERNEL_ITEM once complete
+	vector<uint32_t> kernelTransition(kernelCount, NO_TRANSITION);	//the transition that step takes
+	vector<uint32_t> kernelReduction(kernelCount, NO_REDUCTION);
+	auto step = [&](item_id item)
+	{
+		item++;
+		while (automaton.item_symbol(item) != NO_SYMBOL && automaton.item_symbol(item) == symbols.epsilon)
+		{
+			item++;
+		}
+		return item;
+	};
+	auto find_kernel = [&](state_id state, item_id item)
+	{
+		return (uint32_t)(lower_bound(automaton.kernel_begin(state), automaton.kernel_end(state), item) - kernelBase);
+	};
+	auto find_reduction = [&](state_id state, production_id p)
+	{
+		uint32_t first = automaton.reduction_begin(state);
+		uint32_t last = automaton.reduction_end(state);
+		while (first < last)
+		{
+			uint32_t middle = first + (last - first) / 2;
+			if (automaton.reduction_production(middle) < p)
+			{
+				first = middle + 1;
+			}
+			else
+			{
+				last = middle;
+			}
+		}
+		return first;
+	};
+	workers.parallel_for(automaton.state_count(), [&](size_t from, size_t to)
+	{
+		for (state_id state = (state_id)from; state < to; state++)
+		{
+			for (const item_id* item = automaton.kernel_begin(state); item != automaton.kernel_end(state); item++)
+			{
+				uint32_t k = (uint32_t)(item - kernelBase);
+				symbol_id symbol = automaton.item_symbol(*item);
+				if (symbol == NO_SYMBOL)
+				{
+					kernelReduction[k] = find_reduction(state, automaton.item_production(*item));
+					continue;
+				}
+				uint32_t t = automaton.transition(state, symbol);
+				kernelTransition[k] = t;
+				kernelNext[k] = find_kernel(automaton.transition_target(t), step(*item));
+			}
+		}
+	});
+	//The dot only moves right, so every path ends in a complete item and the reductions fill in back to front.
+	vector<uint32_t> path;
+	for (uint32_t k = 0; k < kernelCount; k++)
+	{
+		uint32_t last = k;
+		for (; kernelReduction[last] == NO_REDUCTION; last = kernelNext[last])
+		{
+			path.push_back(last);
+		}
+		for (uint32_t item : path)
+		{
+			kernelReduction[item] = kernelReduction[last];
+		}
+		path.clear();
+	}
+
+	//How many of each a node gets only depends on B, so both are laid out CSR style up front and the
+	//walks run on the pool with every node writing its own slots. The first step of every production is
+	//kept next to its count, B's productions are consecutive and so a walk reads them in order.
+	vector<uint32_t> productionIncludes(productions.production_count(), 0);
+	vector<symbol_id> productionSymbol(productions.production_count());	//after the dot of the first item
+	vector<item_id> productionNext(productions.production_count());		//the item past it
+	vector<char> productionIncludesFirst(productions.production_count(), 0);
+	vector<uint32_t> includesCount(symbols.nonterminals().size(), 0);
+	for (production_id p : productions.all_productions())
+	{
+		production_view production = productions.production(p);
+		item_id item = step(productions.rhs_offset(p) + p - 1);
+		productionSymbol[p] = automaton.item_symbol(item);
+		if (productionSymbol[p] != NO_SYMBOL)
+		{
+			productionNext[p] = step(item);
+			productionIncludesFirst[p] = symbols.isNonterminal(productionSymbol[p]) && analyzer.suffix_nullable(p, automaton.item_dot(item) + 1);
+		}
+		for (size_t i = 0; i < production.size(); i++)
+		{
+			if (symbols.isNonterminal(production[i]) && analyzer.suffix_nullable(p, i + 1))
+			{
+				productionIncludes[p]++;
+			}
+		}
+		includesCount[symbols.index(production.lhs)] += productionIncludes[p];
+	}
+	vector<size_t> lookbackStart(nodeCount + 1, 0);
+	vector<size_t> includesStart(nodeCount + 1, 0);
+	for (size_t node = 0; node < nodeCount; node++)
+	{
+		uint32_t lhs = lhs_of(node);
+		lookbackStart[node + 1] = lookbackStart[node] + productions.productions_of(lhs).size();
+		includesStart[node + 1] = includesStart[node] + includesCount[lhs];
+	}
+	vector<uint32_t> lookbackReduction(lookbackStart.back());
+	vector<uint32_t> includesNode(includesStart.back());
+	workers.parallel_for(nodeCount, [&](size_t from, size_t to)
+	{
+		for (size_t node = from; node < to; node++)
+		{
+			size_t lookback = lookbackStart[node];
+			size_t includes = includesStart[node];
+			for (production_id p : productions.productions_of(lhs_of(node)))
+			{
+				if (productionSymbol[p] == NO_SYMBOL)
+				{
+					lookbackReduction[lookback++] = find_reduction(nodeFrom[node], p);
+					continue;
+				}
+				uint32_t t = automaton.transition(nodeFrom[node], productionSymbol[p]);
+				size_t left = productionIncludes[p];
+				if (productionIncludesFirst[p])
+				{
+					includesNode[includes++] = nodeOf[t];
+					left--;
+				}
+				uint32_t k = find_kernel(automaton.transition_target(t), productionNext[p]);
+				lookbackReduction[lookback++] = kernelReduction[k];
+				for (; left != 0; k = kernelNext[k])
+				{
+					symbol_id symbol = automaton.item_symbol(kernelBase[k]);
+					if (symbols.isNonterminal(symbol) && analyzer.suffix_nullable(p, automaton.item_dot(kernelBase[k]) + 1))
+					{
+						includesNode[includes++] = nodeOf[kernelTransition[k]];
+						left--;
+					}
+				}
+			}
+		}
+	});
+	//The slots say which nodes include each node, turned around into the relation digraph_solve wants.
+	for (vector<uint32_t>& edges : relation)
+	{
+		edges.clear();
+	}
+	for (uint32_t node = 0; node < nodeCount; node++)
+	{
+		for (size_t e = includesStart[node]; e < includesStart[node + 1]; e++)
+		{
+			relation[includesNode[e]].push_back(node);
+		}
+	}
+	statsData.includesEdges = includesNode.size();
+	statsData.lookbackEdges = lookbackReduction.size();
+	vector<uint32_t>().swap(includesNode);
+	add(statsData.relations, timer.lap());
+	digraph_solve(relation, sets, pool, &statsData.includesGraph);
+	statsData.includes = timer.lap();
+
+	//LA(q, A ::= ω) is the union of Follow over its lookbacks. A counting sort turns lookback around to
+	//go by reduction, then each reduction is one row of the result and the rows are split across the pool.
+	vector<uint32_t> reductionStart(automaton.reduction_count() + 1, 0);
+	for (uint32_t reduction : lookbackReduction)
+	{
+		reductionStart[reduction + 1]++;
+	}
+	for (size_t r = 0; r < automaton.reduction_count(); r++)
+	{
+		reductionStart[r + 1] += reductionStart[r];
+	}
+	vector<uint32_t> reductionNode(lookbackReduction.size());
+	{
+		vector<uint32_t> next(reductionStart.begin(), reductionStart.end() - 1);
+		for (uint32_t node = 0; node < nodeCount; node++)
+		{
+			for (size_t e = lookbackStart[node]; e < lookbackStart[node + 1]; e++)
+			{
+				reductionNode[next[lookbackReduction[e]]++] = node;
+			}
+		}
+	}
+	workers.parallel_for(automaton.reduction_count(), [&](size_t from, size_t to)
+	{
+		terminal_set lookahead(terminalCount);
+		for (size_t r = from; r < to; r++)
+		{
+			lookahead.clear();
+			for (uint32_t e = reductionStart[r]; e < reductionStart[r + 1]; e++)
+			{
+				lookahead.unite(sets[reductionNode[e]]);
+			}
+			lookaheads.store(r, lookahead);
+		}
+	});
+
+	statsData.bytes = lookaheads.byte_size() + nodeCount * (sizeof(terminal_set) + terminal_set_words(terminalCount) * sizeof(uint64_t)
+		+ sizeof(vector<uint32_t>) + 2 * sizeof(uint32_t) + 2 * sizeof(size_t)) + nodeOf.capacity() * sizeof(uint32_t)
+		+ (statsData.readsEdges + statsData.includesEdges + 2 * statsData.lookbackEdges + reductionStart.size()) * sizeof(uint32_t);
+	statsData.lookahead = timer.lap();
+}
+
+vector<terminal_set_view> lalr_lookahead::views() const
+{
+	vector<terminal_set_view> result;
+	result.reserve(lookaheads.size());
+	for (size_t r = 0; r < lookaheads.size(); r++)
+	{
+		result.push_back(lookaheads[r]);
+	}
+	return result;
+}
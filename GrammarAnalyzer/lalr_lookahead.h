@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "lr0_automaton.h"
+#include "terminal_set.h"
+#include "analysis_stats.h"
+
+class grammar_analyzer;
+class thread_pool;
+
+struct lalr_stats
+{
+	phase_time relations;		//DR, reads, includes and lookback
+	phase_time reads;			//Read = digraph over reads
+	phase_time includes;		//Follow = digraph over includes
+	phase_time lookahead;		//LA, the union over lookback
+	size_t nodes = 0;			//nonterminal transitions, plus one for the end of the input
+	size_t readsEdges = 0;
+	size_t includesEdges = 0;
+	size_t lookbackEdges = 0;
+	graph_stats readsGraph;
+	graph_stats includesGraph;
+	size_t bytes = 0;
+};
+
+/*
+	LALR(1) lookaheads of an LR(0) automaton by DeRemer & Pennello's relations, one terminal set per
+	reduction of the automaton, ready for lr_table::build.
+
+	Everything is over the nonterminal transitions (p, A) of the automaton:
+		DR(p, A)		the terminals goto(p, A) shifts
+		(p, A) reads (r, C)			r = goto(p, A) has a transition on C and C is nullable
+		(p, A) includes (p', B)		B ::= β A γ, γ is nullable and p' reaches p on β
+		(q, A ::= ω) lookback (p, A)	p reaches q on ω
+	then Read = DR closed over reads, Follow = Read closed over includes, and the lookahead of a reduction
+	is the union of Follow over its lookbacks. Both closures are digraph_solve, so each is linear in the
+	size of its relation and cycles cost nothing extra.
+
+	The end of the input is one more node, the transition on goal out of the start state that the automaton
+	leaves implicit, with { $ } as its DR. Every goal production includes it, so a grammar with $ declared
+	reduces at the end of the input even where goal ::= ... has no $ of its own.
+*/
+class lalr_lookahead
+{
+public:
+	//analyzer must have been computed (the relations need nullable) and the automaton built on its grammar.
+	void compute(const lr0_automaton& automaton, const grammar_analyzer& analyzer, thread_pool* pool = nullptr);
+
+	terminal_set_view lookahead(uint32_t reduction) const { return lookaheads[reduction]; }
+	//One view per reduction, for lr_table::build. Valid while this object is.
+	std::vector<terminal_set_view> views() const;
+
+	const lalr_stats& stats() const { return statsData; }
+
+private:
+	terminal_set_array lookaheads;		//by reduction
+	lalr_stats statsData;
+};
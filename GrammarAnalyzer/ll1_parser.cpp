@@ -0,0 +1,154 @@
+#include "ll1_parser.h"
+
+using namespace std;
+
+ll1_parser::ll1_parser(const ll1_table_view& table) : table(table), stack(64)
+{
+	reset();
+}
+
+void ll1_parser::reset()
+{
+	depth = 0;
+	consumed = 0;
+	expansionCount = 0;
+	maxDepth = 0;
+	errorSymbol = LL1_NO_PRODUCTION;
+	state = LL1_RUNNING;
+	if (table.nonterminalCount == 0)
+	{
+		state = LL1_ACCEPTED;
+		return;
+	}
+	stack[depth++] = table.terminalCount + table.start;
+	maxDepth = 1;
+}
+
+ll1_status ll1_parser::fail(uint32_t symbol)
+{
+	errorSymbol = symbol;
+	state = LL1_ERROR;
+	return state;
+}
+
+//Replaces the nonterminal on top of the stack by production p's RHS, first symbol on top.
+//Returns false if the stack would outgrow LL1_MAX_STACK, which only a left recursive grammar does.
+inline bool ll1_parser::expand(uint32_t p)
+{
+	uint32_t from = table.productionStart[p];
+	uint32_t to = table.productionStart[p + 1];
+	depth--;
+	if (depth + (to - from) > stack.size())
+	{
+		if (depth + (to - from) > LL1_MAX_STACK)
+		{
+			depth++;
+			return false;
+		}
+		stack.resize(2 * (depth + (to - from)));
+	}
+	uint32_t* top = stack.data() + depth;
+	for (uint32_t k = to; k > from; k--)
+	{
+		*top++ = table.rhs[k - 1];
+	}
+	depth += to - from;
+	expansionCount++;
+	if (depth > maxDepth)
+	{
+		maxDepth = depth;
+	}
+	return true;
+}
+
+ll1_status ll1_parser::feed(const uint32_t* tokens, size_t count)
+{
+	if (state == LL1_ERROR || count == 0)
+	{
+		return state;
+	}
+	if (state == LL1_ACCEPTED)
+	{
+		return fail(LL1_NO_PRODUCTION);
+	}
+
+	const uint32_t terminalCount = table.terminalCount;
+	for (size_t i = 0; i < count; i++, consumed++)
+	{
+		uint32_t token = tokens[i];
+		if (token >= terminalCount)
+		{
+			return fail(LL1_NO_PRODUCTION);
+		}
+		//Expand nonterminals until a terminal is on top, it must be the token.
+		for (;;)
+		{
+			if (depth == 0)
+			{
+				return fail(LL1_NO_PRODUCTION);
+			}
+			uint32_t symbol = stack[depth - 1];
+			if (symbol < terminalCount)
+			{
+				if (symbol != token)
+				{
+					return fail(symbol);
+				}
+				depth--;
+				break;
+			}
+			uint32_t p = table.predict(symbol - terminalCount, token);
+			if (p == LL1_NO_PRODUCTION)
+			{
+				return fail(symbol);
+			}
+			if (!expand(p))
+			{
+				return fail(symbol);
+			}
+		}
+	}
+
+	if (depth == 0)
+	{
+		state = LL1_ACCEPTED;
+	}
+	return state;
+}
+
+ll1_status ll1_parser::finish()
+{
+	//Whatever is left has to derive the empty string, followed by at most one $. Without a $ terminal the
+	//table has no column to predict those epsilon expansions with, so only an empty stack is accepted.
+	while (state == LL1_RUNNING && depth > 0)
+	{
+		uint32_t symbol = stack[depth - 1];
+		if (table.eof == LL1_NO_PRODUCTION)
+		{
+			return fail(symbol);
+		}
+		if (symbol < table.terminalCount)
+		{
+			if (symbol != table.eof)
+			{
+				return fail(symbol);
+			}
+			depth--;
+			continue;
+		}
+		uint32_t p = table.predict(symbol - table.terminalCount, table.eof);
+		if (p == LL1_NO_PRODUCTION)
+		{
+			return fail(symbol);
+		}
+		if (!expand(p))
+		{
+			return fail(symbol);
+		}
+	}
+	if (state == LL1_RUNNING)
+	{
+		state = LL1_ACCEPTED;
+	}
+	return state;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "ll1_table.h"
+
+//Deepest parse stack allowed, in symbols. Only a left recursive grammar gets anywhere near it: its table
+//expands the same nonterminal forever without consuming a token.
+const size_t LL1_MAX_STACK = (size_t)1 << 24;
+
+enum ll1_status
+{
+	LL1_RUNNING,		//everything so far is a prefix of a sentence
+	LL1_ACCEPTED,		//the start symbol has been matched completely
+	LL1_ERROR
+};
+
+/*
+	Table driven LL(1) recognizer over an ll1_table_view, so it runs off an ll1_table, a generated header
+	or a mapped binary table alike. Tokens are terminal indices, i.e. lines of the terminals file.
+
+	The parse stack is an explicit array of encoded symbols (see ll1_table_view) that only grows, so after
+	the first few tokens there is no allocation at all; reset() keeps it for the next input. Growing past
+	LL1_MAX_STACK is an error. Tokens are fed in batches of any size, a sentence can be split across any
+	number of feed() calls:
+		parser.reset();
+		while (more tokens) parser.feed(batch, count);
+		parser.finish();
+*/
+class ll1_parser
+{
+public:
+	explicit ll1_parser(const ll1_table_view& table);
+
+	//Ready for a new input: only the start symbol on the stack.
+	void reset();
+	//Consumes tokens until they run out or one is rejected. Once the status is not LL1_RUNNING, feed does nothing
+	//more, except that any token after LL1_ACCEPTED is an error.
+	ll1_status feed(const uint32_t* tokens, size_t count);
+	//End of input. If the grammar has a $ terminal which has not been seen it is fed first, so inputs
+	//may or may not end with it. Anything still on the stack after that is an error.
+	ll1_status finish();
+
+	ll1_status status() const { return state; }
+	//Tokens consumed so far. After an error this is the index of the rejected token.
+	size_t position() const { return consumed; }
+	//The encoded symbol that was on top of the stack when the error happened.
+	uint32_t error_symbol() const { return errorSymbol; }
+	size_t expansions() const { return expansionCount; }
+	size_t max_depth() const { return maxDepth; }
+
+private:
+	ll1_status fail(uint32_t symbol);
+	bool expand(uint32_t production);
+
+	ll1_table_view table;
+	std::vector<uint32_t> stack;	//[0, depth) is in use, the rest is spare room
+	size_t depth = 0;
+	size_t consumed = 0;
+	size_t expansionCount = 0;
+	size_t maxDepth = 0;
+	uint32_t errorSymbol = LL1_NO_PRODUCTION;
+	ll1_status state = LL1_RUNNING;
+};
@@ -0,0 +1,381 @@
+#include "ll1_table.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+
+#include "grammar_analyzer.h"
+
+using namespace std;
+
+namespace
+{
+	const uint32_t LL1_MAGIC = 0x54314C4C;
+	const uint32_t LL1_VERSION = 1;
+	//magic, version, then the seven counts of ll1_table_view
+	const size_t LL1_HEADER_WORDS = 9;
+	//How many full rows back from the end of the table build() looks for a place to fit a row.
+	const size_t LL1_PACK_WINDOW = 4;
+
+	void write_words(ostream& out, const uint32_t* words, size_t count)
+	{
+		out.write((const char*)words, count * sizeof(uint32_t));
+	}
+
+	//Comma separated, 16 to a line.
+	void write_array(ostream& out, const char* type, const char* name, const uint32_t* words, size_t count, size_t perItem = 1)
+	{
+		out << "\tconstexpr " << type << " " << name << "[] =\n\t{";
+		if (count == 0)
+		{
+			//No zero length arrays, the view never looks at it anyway.
+			out << "\n\t\t" << (perItem == 1 ? "0" : "{ 0, 0 }");
+		}
+		for (size_t i = 0; i < count; i++)
+		{
+			out << (i % 16 == 0 ? (i == 0 ? "\n\t\t" : ",\n\t\t") : ", ");
+			if (perItem == 1)
+			{
+				out << words[i];
+			}
+			else
+			{
+				out << "{ " << words[2 * i] << ", " << words[2 * i + 1] << " }";
+			}
+		}
+		out << "\n\t};\n";
+	}
+
+	void write_names(ostream& out, const char* name, const vector<string>& names)
+	{
+		out << "\tconstexpr const char* " << name << "[] =\n\t{";
+		for (size_t i = 0; i < names.size(); i++)
+		{
+			out << (i == 0 ? "\n\t\t\"" : ",\n\t\t\"");
+			for (char c : names[i])
+			{
+				if (c == '"' || c == '\\')
+				{
+					out << '\\';
+				}
+				out << c;
+			}
+			out << "\"";
+		}
+		if (names.empty())
+		{
+			out << "\n\t\tnullptr";
+		}
+		out << "\n\t};\n";
+	}
+}
+
+void ll1_table::build(const grammar_analyzer& analyzer)
+{
+	const symbol_table& symbols = analyzer.symbols();
+	const grammar& productions = analyzer.productions();
+	terminalCount = (uint32_t)symbols.terminals().size();
+	uint32_t nonterminalCount = (uint32_t)symbols.nonterminals().size();
+	start = symbols.goal != NO_SYMBOL && symbols.isNonterminal(symbols.goal) ? symbols.index(symbols.goal) : 0;
+	eof = symbols.eof != NO_SYMBOL && symbols.isTerminal(symbols.eof) ? symbols.index(symbols.eof) : LL1_NO_PRODUCTION;
+
+	terminalNames.clear();
+	nonterminalNames.clear();
+	for (symbol_id id : symbols.terminals())
+	{
+		terminalNames.push_back(symbols.name(id));
+	}
+	for (symbol_id id : symbols.nonterminals())
+	{
+		nonterminalNames.push_back(symbols.name(id));
+	}
+
+	//Productions with their RHS encoded for the view, epsilon dropped.
+	productionLhs.clear();
+	productionStart.clear();
+	rhs.clear();
+	for (production_id p : productions.all_productions())
+	{
+		production_view production = productions.production(p);
+		productionLhs.push_back(symbols.index(production.lhs));
+		productionStart.push_back((uint32_t)rhs.size());
+		for (symbol_id elem : production)
+		{
+			if (elem == symbols.epsilon)
+			{
+				continue;
+			}
+			rhs.push_back(symbols.isNonterminal(elem) ? terminalCount + symbols.index(elem) : symbols.index(elem));
+		}
+	}
+	productionStart.push_back((uint32_t)rhs.size());
+
+	//Every row as its (terminal, production) cells in terminal order, the earliest alternative wins a cell.
+	//Identical rows share one check value and one placement, so only the distinct rows' cells are kept,
+	//one after the other in cellData. Rows are hashed, equal hashes are compared cell by cell.
+	typedef pair<uint32_t, uint32_t> cell;
+	vector<cell> cellData;
+	vector<size_t> cellStart(1, 0);
+	vector<cell> current;
+	vector<uint32_t> cellOf(terminalCount, LL1_NO_PRODUCTION);
+	unordered_multimap<uint64_t, uint32_t> distinct;
+	rows.assign(nonterminalCount, ll1_row{ 0, 0 });
+	for (uint32_t nt = 0; nt < nonterminalCount; nt++)
+	{
+		for (production_id p : productions.productions_of(nt))
+		{
+			for (size_t terminal : analyzer.production_first_plus(p))
+			{
+				if (cellOf[terminal] == LL1_NO_PRODUCTION)
+				{
+					cellOf[terminal] = p;
+				}
+			}
+		}
+		current.clear();
+		uint64_t hash = 14695981039346656037ull;
+		for (uint32_t terminal = 0; terminal < terminalCount; terminal++)
+		{
+			if (cellOf[terminal] != LL1_NO_PRODUCTION)
+			{
+				current.emplace_back(terminal, cellOf[terminal]);
+				hash = (hash ^ (((uint64_t)terminal << 32) | cellOf[terminal])) * 1099511628211ull;
+				cellOf[terminal] = LL1_NO_PRODUCTION;
+			}
+		}
+
+		uint32_t check = (uint32_t)(cellStart.size() - 1);
+		auto candidates = distinct.equal_range(hash);
+		for (auto it = candidates.first; it != candidates.second; ++it)
+		{
+			size_t from = cellStart[it->second];
+			if (cellStart[it->second + 1] - from == current.size() && equal(current.begin(), current.end(), cellData.begin() + from))
+			{
+				check = it->second;
+				break;
+			}
+		}
+		if (check == cellStart.size() - 1)
+		{
+			distinct.emplace(hash, check);
+			cellData.insert(cellData.end(), current.begin(), current.end());
+			cellStart.push_back(cellData.size());
+		}
+		rows[nt].check = check;
+	}
+	size_t rowCount = cellStart.size() - 1;
+	distinctRows = rowCount;
+
+	//Densest rows first, they are the hardest to fit. The sort is stable so the layout is deterministic.
+	vector<uint32_t> order(rowCount);
+	for (uint32_t r = 0; r < order.size(); r++)
+	{
+		order[r] = r;
+	}
+	stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+	{
+		return cellStart[a + 1] - cellStart[a] > cellStart[b + 1] - cellStart[b];
+	});
+
+	//Slots taken so far, one bit each. A row is tested against a candidate base a word at a time:
+	//its own cells as a bitmask against the 64 slots that would lie under each word of it.
+	size_t maskWords = (terminalCount + 63) / 64;
+	vector<uint64_t> used(maskWords + 1, 0);
+	vector<uint64_t> mask(maskWords);
+	size_t tableSize = 0;
+	size_t firstFree = 0;
+	vector<uint32_t> baseOf(rowCount, 0);
+	for (uint32_t r : order)
+	{
+		const cell* row = cellData.data() + cellStart[r];
+		const cell* rowEnd = cellData.data() + cellStart[r + 1];
+		if (row == rowEnd)
+		{
+			continue;
+		}
+		fill(mask.begin(), mask.end(), 0);
+		for (const cell* c = row; c != rowEnd; c++)
+		{
+			mask[c->first >> 6] |= (uint64_t)1 << (c->first & 63);
+		}
+
+		//Holes far behind the end rarely fit anything, so only the last few rows' worth of slots are searched.
+		//The last candidate puts the first cell at the end of the table, which always fits.
+		size_t from = max(firstFree, tableSize > LL1_PACK_WINDOW * terminalCount ? tableSize - LL1_PACK_WINDOW * terminalCount : 0);
+		size_t base = from > row[0].first ? from - row[0].first : 0;
+		for (;; base++)
+		{
+			size_t word = base >> 6;
+			size_t shift = base & 63;
+			bool fits = true;
+			for (size_t i = 0; i < maskWords && fits; i++)
+			{
+				uint64_t under = used[word + i] >> shift;
+				if (shift != 0)
+				{
+					under |= used[word + i + 1] << (64 - shift);
+				}
+				fits = (under & mask[i]) == 0;
+			}
+			if (fits)
+			{
+				break;
+			}
+		}
+
+		tableSize = max(tableSize, base + terminalCount);
+		used.resize(max(used.size(), tableSize / 64 + maskWords + 2), 0);
+		for (const cell* c = row; c != rowEnd; c++)
+		{
+			size_t slot = base + c->first;
+			used[slot >> 6] |= (uint64_t)1 << (slot & 63);
+		}
+		while (firstFree < tableSize && ((used[firstFree >> 6] >> (firstFree & 63)) & 1))
+		{
+			firstFree++;
+		}
+		baseOf[r] = (uint32_t)base;
+	}
+
+	//Room for base + terminal of every row, empty rows sit at 0 and never match a check.
+	entries.assign(max(tableSize, (size_t)terminalCount), ll1_entry{ LL1_NO_PRODUCTION, LL1_NO_PRODUCTION });
+	for (uint32_t r = 0; r < rowCount; r++)
+	{
+		for (size_t c = cellStart[r]; c < cellStart[r + 1]; c++)
+		{
+			entries[baseOf[r] + cellData[c].first] = ll1_entry{ r, cellData[c].second };
+		}
+	}
+	for (ll1_row& row : rows)
+	{
+		row.base = baseOf[row.check];
+	}
+}
+
+ll1_table_view ll1_table::view() const
+{
+	ll1_table_view view;
+	view.terminalCount = terminalCount;
+	view.nonterminalCount = (uint32_t)rows.size();
+	view.productionCount = (uint32_t)productionLhs.size();
+	view.entryCount = (uint32_t)entries.size();
+	view.rhsCount = (uint32_t)rhs.size();
+	view.start = start;
+	view.eof = eof;
+	view.rows = rows.data();
+	view.entries = entries.data();
+	view.productionLhs = productionLhs.data();
+	view.productionStart = productionStart.data();
+	view.rhs = rhs.data();
+	return view;
+}
+
+void ll1_table::write_header(ostream& out, const string& name) const
+{
+	ll1_table_view v = view();
+	out << "//LL(1) prediction table generated by First_and_Follow_sets, do not edit. See ll1_table.h for the layout.\n"
+		<< "#pragma once\n\n#include \"ll1_table.h\"\n\nnamespace " << name << "\n{\n";
+	out << "\tconstexpr uint32_t terminal_count = " << v.terminalCount << ";\n"
+		<< "\tconstexpr uint32_t nonterminal_count = " << v.nonterminalCount << ";\n"
+		<< "\tconstexpr uint32_t production_count = " << v.productionCount << ";\n\n";
+	write_array(out, "ll1_row", "rows", (const uint32_t*)rows.data(), rows.size(), 2);
+	write_array(out, "ll1_entry", "entries", (const uint32_t*)entries.data(), entries.size(), 2);
+	write_array(out, "uint32_t", "production_lhs", productionLhs.data(), productionLhs.size());
+	write_array(out, "uint32_t", "production_start", productionStart.data(), productionStart.size());
+	write_array(out, "uint32_t", "rhs", rhs.data(), rhs.size());
+	write_names(out, "terminal_names", terminalNames);
+	write_names(out, "nonterminal_names", nonterminalNames);
+	out << "\n\tconstexpr ll1_table_view table =\n\t{\n\t\t" << v.terminalCount << ", " << v.nonterminalCount << ", " << v.productionCount
+		<< ", " << v.entryCount << ", " << v.rhsCount << ", " << v.start << ", " << v.eof << "u,\n"
+		<< "\t\trows, entries, production_lhs, production_start, rhs\n\t};\n}\n";
+}
+
+void ll1_table::write_binary(ostream& out) const
+{
+	ll1_table_view v = view();
+	uint32_t header[LL1_HEADER_WORDS] = { LL1_MAGIC, LL1_VERSION, v.terminalCount, v.nonterminalCount, v.productionCount,
+		v.entryCount, v.rhsCount, v.start, v.eof };
+	write_words(out, header, LL1_HEADER_WORDS);
+	write_words(out, (const uint32_t*)rows.data(), rows.size() * 2);
+	write_words(out, (const uint32_t*)entries.data(), entries.size() * 2);
+	write_words(out, productionLhs.data(), productionLhs.size());
+	write_words(out, productionStart.data(), productionStart.size());
+	write_words(out, rhs.data(), rhs.size());
+}
+
+bool read_ll1_table(string_view data, ll1_table_view& view, string& error)
+{
+	const uint32_t* words = (const uint32_t*)data.data();
+	size_t wordCount = data.size() / sizeof(uint32_t);
+	if (wordCount < LL1_HEADER_WORDS || words[0] != LL1_MAGIC)
+	{
+		error = "not an LL(1) table";
+		return false;
+	}
+	if (words[1] != LL1_VERSION)
+	{
+		error = "LL(1) table version " + to_string(words[1]) + ", expected " + to_string(LL1_VERSION);
+		return false;
+	}
+	view.terminalCount = words[2];
+	view.nonterminalCount = words[3];
+	view.productionCount = words[4];
+	view.entryCount = words[5];
+	view.rhsCount = words[6];
+	view.start = words[7];
+	view.eof = words[8];
+
+	//Widened so a corrupt count can't wrap around.
+	uint64_t expected = LL1_HEADER_WORDS + 2 * (uint64_t)view.nonterminalCount + 2 * (uint64_t)view.entryCount
+		+ 2 * (uint64_t)view.productionCount + 1 + view.rhsCount;
+	if (expected != wordCount || data.size() % sizeof(uint32_t) != 0)
+	{
+		error = "LL(1) table is truncated or has trailing data";
+		return false;
+	}
+	const uint32_t* next = words + LL1_HEADER_WORDS;
+	view.rows = (const ll1_row*)next;
+	next += 2 * (size_t)view.nonterminalCount;
+	view.entries = (const ll1_entry*)next;
+	next += 2 * (size_t)view.entryCount;
+	view.productionLhs = next;
+	next += view.productionCount;
+	view.productionStart = next;
+	next += view.productionCount + 1;
+	view.rhs = next;
+
+	//predict trusts base + terminal to be in range, and the parser trusts the RHS offsets.
+	for (uint32_t nt = 0; nt < view.nonterminalCount; nt++)
+	{
+		if ((uint64_t)view.rows[nt].base + view.terminalCount > view.entryCount)
+		{
+			error = "LL(1) table row " + to_string(nt) + " is out of range";
+			return false;
+		}
+	}
+	for (uint32_t p = 0; p < view.productionCount; p++)
+	{
+		if (view.productionStart[p] > view.productionStart[p + 1] || view.productionStart[p + 1] > view.rhsCount)
+		{
+			error = "LL(1) table production " + to_string(p) + " is out of range";
+			return false;
+		}
+	}
+	for (uint32_t i = 0; i < view.rhsCount; i++)
+	{
+		if (view.rhs[i] >= view.terminalCount + (uint64_t)view.nonterminalCount)
+		{
+			error = "LL(1) table RHS symbol " + to_string(i) + " is out of range";
+			return false;
+		}
+	}
+	for (uint32_t i = 0; i < view.entryCount; i++)
+	{
+		if (view.entries[i].production != LL1_NO_PRODUCTION && view.entries[i].production >= view.productionCount)
+		{
+			error = "LL(1) table cell " + to_string(i) + " is out of range";
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <ostream>
+#include <cstdint>
+
+class grammar_analyzer;
+
+const uint32_t LL1_NO_PRODUCTION = 0xFFFFFFFF;
+
+//One cell of the packed table. check tells which row the cell belongs to, see ll1_table_view::predict.
+struct ll1_entry
+{
+	uint32_t check;
+	uint32_t production;
+};
+
+struct ll1_row
+{
+	uint32_t base;		//where the row's terminal 0 would be in entries
+	uint32_t check;		//shared by identical rows
+};
+
+/*
+	Non-owning view of an LL(1) prediction table. It can point into an ll1_table, into the constexpr arrays
+	of a generated header or straight into a mapped binary table, so a parser needs no start up work at all.
+
+	Numbering is stable across runs of the same input:
+		terminals		their position in the terminals file, undeclared terminals after them in order of appearance
+		nonterminals	in order of their first rule
+		productions		grouped by LHS like grammar::finalize, nonterminals in the order above and each one's
+						alternatives in file order, so rules of one LHS in two places are numbered together
+	A RHS symbol s is terminal s if s < terminalCount, nonterminal s - terminalCount otherwise. epsilon is
+	never stored, an epsilon production just has an empty RHS.
+*/
+struct ll1_table_view
+{
+	uint32_t terminalCount;
+	uint32_t nonterminalCount;
+	uint32_t productionCount;
+	uint32_t entryCount;
+	uint32_t rhsCount;
+	uint32_t start;				//nonterminal index of goal, 0 if the grammar has none
+	uint32_t eof;				//terminal index of $, LL1_NO_PRODUCTION if it was never declared
+	const ll1_row* rows;				//by nonterminal
+	const ll1_entry* entries;			//entryCount cells, base + terminal is always in range
+	const uint32_t* productionLhs;		//by production
+	const uint32_t* productionStart;	//productionCount + 1 offsets into rhs
+	const uint32_t* rhs;
+
+	//The production to expand nonterminal with when terminal is the next token, LL1_NO_PRODUCTION if there is none.
+	//One row load, one cell load.
+	constexpr uint32_t predict(uint32_t nonterminal, uint32_t terminal) const
+	{
+		ll1_row row = rows[nonterminal];
+		ll1_entry entry = entries[row.base + terminal];
+		return entry.check == row.check ? entry.production : LL1_NO_PRODUCTION;
+	}
+};
+
+/*
+	The nonterminal x terminal -> production table of an analysed grammar, built from the per production
+	FIRST+ sets. Where alternatives conflict (see grammar_analyzer::ll1_conflicts) the cell keeps the
+	earliest of them, the way a hand written recursive descent parser would try them.
+
+	The table is row compressed: identical rows are stored once and the distinct rows are overlaid in one
+	entries array (row displacement), each one shifted to the first base where its cells fall in free slots.
+*/
+class ll1_table
+{
+public:
+	//analyzer must have been computed.
+	void build(const grammar_analyzer& analyzer);
+
+	ll1_table_view view() const;
+	size_t distinct_rows() const { return distinctRows; }
+
+	//A self contained C++ header: the arrays as constexpr data and an ll1_table_view called table,
+	//all in namespace name. Names of the symbols are included for error messages.
+	void write_header(std::ostream& out, const std::string& name) const;
+
+	//The arrays as raw 32 bit words in this machine's byte order, behind a small header, see read_ll1_table.
+	void write_binary(std::ostream& out) const;
+
+private:
+	uint32_t terminalCount = 0;
+	uint32_t start = 0;
+	uint32_t eof = LL1_NO_PRODUCTION;
+	size_t distinctRows = 0;
+	std::vector<ll1_row> rows;
+	std::vector<ll1_entry> entries;
+	std::vector<uint32_t> productionLhs;
+	std::vector<uint32_t> productionStart;
+	std::vector<uint32_t> rhs;
+	std::vector<std::string> terminalNames;
+	std::vector<std::string> nonterminalNames;
+};
+
+//Points view into a table written by ll1_table::write_binary, without copying anything. data must stay alive
+//and be 4 byte aligned (a mapped_file is). Returns false and sets error if it is not a valid table.
+bool read_ll1_table(std::string_view data, ll1_table_view& view, std::string& error);
@@ -0,0 +1,368 @@
+#include "lookahead_analysis.h"
+#include "stopwatch.h"
+
+#include <algorithm>
+
+using namespace std;
+
+sequence_id sequence_trie::child(sequence_id s, uint32_t terminal)
+{
+	uint64_t key = ((uint64_t)s << 32) | terminal;
+	auto found = children.find(key);
+	if (found != children.end())
+	{
+		return found->second;
+	}
+	sequence_id id = (sequence_id)nodes.size();
+	nodes.push_back(node{ s, terminal, nodes[s].length + 1 });
+	children.emplace(key, id);
+	return id;
+}
+
+sequence_id sequence_trie::concat(sequence_id prefix, sequence_id suffix, size_t k)
+{
+	size_t room = k > nodes[prefix].length ? k - nodes[prefix].length : 0;
+	if (room == 0 || suffix == EMPTY_SEQUENCE)
+	{
+		return prefix;
+	}
+	//The suffix is a path up to the root, so its terminals come out last one first.
+	path.clear();
+	for (sequence_id s = suffix; s != EMPTY_SEQUENCE; s = nodes[s].parent)
+	{
+		path.push_back(nodes[s].terminal);
+	}
+	size_t take = min(room, path.size());
+	sequence_id result = prefix;
+	for (size_t i = 0; i < take; i++)
+	{
+		result = child(result, path[path.size() - 1 - i]);
+	}
+	return result;
+}
+
+sequence_id sequence_trie::prefix(sequence_id s, size_t length) const
+{
+	while (nodes[s].length > length)
+	{
+		s = nodes[s].parent;
+	}
+	return s;
+}
+
+void sequence_trie::terminals(sequence_id s, vector<uint32_t>& out) const
+{
+	out.resize(nodes[s].length);
+	for (size_t i = out.size(); i-- > 0; s = nodes[s].parent)
+	{
+		out[i] = nodes[s].terminal;
+	}
+}
+
+size_t sequence_trie::byte_size() const
+{
+	//An unordered_map node is the pair plus a next pointer and the cached hash, plus a bucket pointer.
+	return nodes.capacity() * sizeof(node) + children.size() * (sizeof(pair<uint64_t, sequence_id>) + 2 * sizeof(void*))
+		+ children.bucket_count() * sizeof(void*);
+}
+
+void lookahead_analysis::compute(const symbol_table& symbols, const grammar& productions)
+{
+	table = &symbols;
+	rules = &productions;
+	trie = sequence_trie();
+	statsData = lookahead_stats();
+	cut.assign(depth + 1, lookahead_set());
+	endTerminal = symbols.eof != NO_SYMBOL ? symbols.index(symbols.eof) : UINT32_MAX;
+	size_t nonterminalCount = symbols.nonterminals().size();
+	firstData.assign(nonterminalCount, lookahead_set());
+	followData.assign(nonterminalCount, lookahead_set());
+	terminalFirst.assign(symbols.terminals().size(), lookahead_set());
+	for (symbol_id t : symbols.terminals())
+	{
+		terminalFirst[symbols.index(t)].push_back(t == symbols.epsilon ? EMPTY_SEQUENCE : trie.child(EMPTY_SEQUENCE, symbols.index(t)));
+	}
+
+	stopwatch timer;
+	compute_first();
+	statsData.first = timer.lap();
+	compute_follow();
+	statsData.follow = timer.lap();
+	compute_conflicts();
+	statsData.conflicts = timer.lap();
+
+	statsData.sequences = trie.size();
+	statsData.bytes = trie.byte_size();
+	for (const vector<lookahead_set>* sets : { &firstData, &followData, &productionData })
+	{
+		for (const lookahead_set& set : *sets)
+		{
+			statsData.bytes += set.capacity() * sizeof(sequence_id);
+			if (sets != &productionData)
+			{
+				statsData.setEntries += set.size();
+			}
+		}
+	}
+	statsData.llkConflicts = conflictData.size();
+}
+
+void lookahead_analysis::concat_sets(const lookahead_set& left, const lookahead_set& right, lookahead_set& out)
+{
+	out.clear();
+	//A prefix of length l only keeps the first k - l terminals of what follows it, and many sequences
+	//on the right share those. Cutting the right side down first keeps the product small.
+	for (lookahead_set& suffixes : cut)
+	{
+		suffixes.clear();
+	}
+	for (sequence_id prefix : left)
+	{
+		size_t space = room(prefix);
+		//A full sequence is cut off whatever follows, even if nothing does yet: like FIRST and FOLLOW
+		//at k = 1, which don't ask whether the rest of the RHS or the LHS derives anything.
+		if (space == 0)
+		{
+			out.push_back(prefix);
+			continue;
+		}
+		lookahead_set& suffixes = cut[space];
+		if (suffixes.empty())
+		{
+			for (sequence_id next : right)
+			{
+				suffixes.push_back(trie.prefix(next, space));
+			}
+			sort(suffixes.begin(), suffixes.end());
+			suffixes.erase(unique(suffixes.begin(), suffixes.end()), suffixes.end());
+		}
+		for (sequence_id next : suffixes)
+		{
+			out.push_back(trie.concat(prefix, next, depth));
+		}
+	}
+	sort(out.begin(), out.end());
+	out.erase(unique(out.begin(), out.end()), out.end());
+}
+
+bool lookahead_analysis::unite(lookahead_set& set, const lookahead_set& other, lookahead_set* added)
+{
+	fresh.clear();
+	set_difference(other.begin(), other.end(), set.begin(), set.end(), back_inserter(fresh));
+	if (fresh.empty())
+	{
+		return false;
+	}
+	merged.clear();
+	set_union(set.begin(), set.end(), fresh.begin(), fresh.end(), back_inserter(merged));
+	set.swap(merged);
+	if (added != nullptr)
+	{
+		merged.clear();
+		set_union(added->begin(), added->end(), fresh.begin(), fresh.end(), back_inserter(merged));
+		added->swap(merged);
+	}
+	return true;
+}
+
+bool lookahead_analysis::full(const lookahead_set& set) const
+{
+	for (sequence_id s : set)
+	{
+		if (room(s) != 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void lookahead_analysis::extend(production_id p, size_t from, size_t to, lookahead_set& set)
+{
+	production_view production = rules->production(p);
+	for (size_t i = from; i < to && !set.empty() && !full(set); i++)
+	{
+		concat_sets(set, symbol_first(production[i]), partial);
+		set.swap(partial);
+	}
+}
+
+//FIRST_k(A) is the union of FIRST_k of A's RHSs. Every production is evaluated once, after that a
+//nonterminal whose set grew pushes the new sequences through each place it is used: for Y in
+//A ::= α Y β, FIRST_k(α), the new sequences of Y and FIRST_k(β) one after the other go to FIRST_k(A). The sets of α and β are taken as they are
+//now, so whichever of two growing nonterminals is passed on last sees the other's new sequences.
+void lookahead_analysis::compute_first()
+{
+	size_t nonterminalCount = table->nonterminals().size();
+	vector<vector<pair<production_id, uint32_t>>> uses(nonterminalCount);
+	for (production_id p : rules->all_productions())
+	{
+		production_view production = rules->production(p);
+		for (size_t i = 0; i < production.size(); i++)
+		{
+			if (table->isNonterminal(production[i]))
+			{
+				uses[table->index(production[i])].push_back(make_pair(p, (uint32_t)i));
+			}
+		}
+	}
+
+	pending.assign(nonterminalCount, lookahead_set());
+	vector<uint32_t> worklist;
+	vector<char> queued(nonterminalCount, 0);
+	auto add = [&](uint32_t nonterminal, const lookahead_set& sequences)
+	{
+		if (unite(firstData[nonterminal], sequences, &pending[nonterminal]) && !queued[nonterminal])
+		{
+			queued[nonterminal] = 1;
+			worklist.push_back(nonterminal);
+		}
+	};
+
+	for (production_id p : rules->all_productions())
+	{
+		statsData.evaluations++;
+		production_view production = rules->production(p);
+		scratch.assign(1, EMPTY_SEQUENCE);
+		extend(p, 0, production.size(), scratch);
+		add(table->index(production.lhs), scratch);
+	}
+	lookahead_set batch;
+	while (!worklist.empty())
+	{
+		uint32_t nonterminal = worklist.back();
+		worklist.pop_back();
+		queued[nonterminal] = 0;
+		batch.swap(pending[nonterminal]);
+		pending[nonterminal].clear();
+		for (const pair<production_id, uint32_t>& use : uses[nonterminal])
+		{
+			production_view production = rules->production(use.first);
+			scratch.assign(1, EMPTY_SEQUENCE);
+			extend(use.first, 0, use.second, scratch);
+			//A full or empty prefix doesn't depend on what comes after it.
+			if (scratch.empty() || full(scratch))
+			{
+				continue;
+			}
+			statsData.evaluations++;
+			concat_sets(scratch, batch, partial);
+			scratch.swap(partial);
+			extend(use.first, use.second + 1, production.size(), scratch);
+			add(table->index(production.lhs), scratch);
+		}
+	}
+}
+
+//For A ::= ... X β, FOLLOW_k(X) gets FIRST_k(β) FOLLOW_k(A). When FOLLOW_k(A) grows the new sequences
+//are walked right to left through A's productions, each step putting FIRST_k of one more symbol in front.
+//Once that symbol's FIRST_k only has full sequences, the rest of the walk no longer depends on
+//FOLLOW_k(A) and was done the first time A was passed on.
+void lookahead_analysis::compute_follow()
+{
+	size_t nonterminalCount = table->nonterminals().size();
+	vector<char> fullFirst(nonterminalCount, 0);
+	for (size_t i = 0; i < nonterminalCount; i++)
+	{
+		fullFirst[i] = !firstData[i].empty() && full(firstData[i]);
+	}
+
+	pending.assign(nonterminalCount, lookahead_set());
+	vector<uint32_t> worklist;
+	vector<char> queued(nonterminalCount, 0);
+	vector<char> passed(nonterminalCount, 0);
+	if (table->goal != NO_SYMBOL)
+	{
+		uint32_t goal = table->index(table->goal);
+		scratch.assign(1, table->eof != NO_SYMBOL ? trie.child(EMPTY_SEQUENCE, table->index(table->eof)) : EMPTY_SEQUENCE);
+		unite(followData[goal], scratch, &pending[goal]);
+	}
+	//Every nonterminal is passed on once even with nothing in its FOLLOW_k, A ::= X b puts b in FOLLOW_k(X)
+	//whether or not anything follows A.
+	for (uint32_t i = (uint32_t)nonterminalCount; i-- > 0;)
+	{
+		queued[i] = 1;
+		worklist.push_back(i);
+	}
+
+	lookahead_set batch;
+	lookahead_set running;
+	while (!worklist.empty())
+	{
+		uint32_t lhs = worklist.back();
+		worklist.pop_back();
+		queued[lhs] = 0;
+		//Taken out first, A ::= a A adds to it again.
+		batch.swap(pending[lhs]);
+		pending[lhs].clear();
+		bool first = !passed[lhs];
+		passed[lhs] = 1;
+		for (production_id p : rules->productions_of(lhs))
+		{
+			statsData.evaluations++;
+			production_view production = rules->production(p);
+			running = batch;
+			for (size_t i = production.size(); i-- > 0 && (first || !running.empty());)
+			{
+				symbol_id symbol = production[i];
+				bool nonterminal = table->isNonterminal(symbol);
+				if (nonterminal)
+				{
+					uint32_t x = table->index(symbol);
+					if (unite(followData[x], running, &pending[x]) && !queued[x])
+					{
+						queued[x] = 1;
+						worklist.push_back(x);
+					}
+				}
+				if (!first && (nonterminal ? fullFirst[table->index(symbol)] : full(symbol_first(symbol))))
+				{
+					break;
+				}
+				concat_sets(symbol_first(symbol), running, scratch);
+				running.swap(scratch);
+			}
+		}
+	}
+}
+
+//Same union first, pairs on a hit scheme as grammar_analyzer::compute_ll1_conflicts.
+void lookahead_analysis::compute_conflicts()
+{
+	conflictData.clear();
+	productionData.assign(rules->production_count(), lookahead_set());
+	lookahead_set seen;
+	for (symbol_id lhs : table->nonterminals())
+	{
+		uint32_t nonterminal = table->index(lhs);
+		production_range alternatives = rules->productions_of(nonterminal);
+		seen.clear();
+		for (production_id p : alternatives)
+		{
+			scratch.assign(1, EMPTY_SEQUENCE);
+			extend(p, 0, rules->production(p).size(), scratch);
+			concat_sets(scratch, followData[nonterminal], productionData[p]);
+			const lookahead_set& current = productionData[p];
+			lookahead_set overlap;
+			set_intersection(seen.begin(), seen.end(), current.begin(), current.end(), back_inserter(overlap));
+			if (!overlap.empty())
+			{
+				for (production_id q : alternatives)
+				{
+					if (q == p)
+					{
+						break;
+					}
+					overlap.clear();
+					set_intersection(productionData[q].begin(), productionData[q].end(), current.begin(), current.end(), back_inserter(overlap));
+					if (!overlap.empty())
+					{
+						conflictData.push_back(llk_conflict{ lhs, q, p, move(overlap) });
+						overlap = lookahead_set();
+					}
+				}
+			}
+			unite(seen, current);
+		}
+	}
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+#include "symbol_table.h"
+#include "grammar.h"
+#include "analysis_stats.h"
+
+typedef uint32_t sequence_id;
+
+//The empty sequence: epsilon in FIRST_k, end of input in FOLLOW_k.
+const sequence_id EMPTY_SEQUENCE = 0;
+
+/*
+	Every lookahead sequence of up to k terminals, hash-consed into one trie: a sequence is the node at the
+	end of its path, so equal sequences have equal IDs and sequences with a common prefix share its nodes.
+	A node costs the same whatever k is, and a set of sequences is just a sorted vector of node IDs that
+	is merged, intersected and compared as integers.
+*/
+class sequence_trie
+{
+public:
+	sequence_trie() : nodes(1, node{ EMPTY_SEQUENCE, 0, 0 }) {}
+
+	//The sequence s followed by terminal.
+	sequence_id child(sequence_id s, uint32_t terminal);
+	//prefix followed by suffix, cut off after k terminals.
+	sequence_id concat(sequence_id prefix, sequence_id suffix, size_t k);
+
+	size_t length(sequence_id s) const { return nodes[s].length; }
+	//Terminal index of the last terminal of s, s can't be the empty sequence.
+	uint32_t last(sequence_id s) const { return nodes[s].terminal; }
+	//The first length terminals of s.
+	sequence_id prefix(sequence_id s, size_t length) const;
+	//The terminal indices of s, first one first.
+	void terminals(sequence_id s, std::vector<uint32_t>& out) const;
+	size_t size() const { return nodes.size(); }
+	size_t byte_size() const;
+
+private:
+	struct node
+	{
+		sequence_id parent;
+		uint32_t terminal;
+		uint32_t length;
+	};
+
+	std::vector<node> nodes;
+	std::unordered_map<uint64_t, sequence_id> children;		//parent << 32 | terminal
+	std::vector<uint32_t> path;
+};
+
+//Sorted, duplicate free.
+typedef std::vector<sequence_id> lookahead_set;
+
+//Work done by one lookahead_analysis::compute.
+struct lookahead_stats
+{
+	phase_time first;
+	phase_time follow;
+	phase_time conflicts;
+	size_t sequences = 0;			//trie nodes, the empty sequence included
+	size_t setEntries = 0;			//sequences summed over every FIRST_k and FOLLOW_k set
+	size_t bytes = 0;				//trie plus sets
+	uint64_t evaluations = 0;		//productions or RHS positions a new batch of sequences was pushed through
+	size_t llkConflicts = 0;
+};
+
+//Two alternatives of a nonterminal that k tokens of lookahead still can't tell apart, like ll1_conflict.
+struct llk_conflict
+{
+	symbol_id nonterminal;
+	production_id first;
+	production_id second;		//the later one
+	lookahead_set overlap;		//the sequences in both
+};
+
+/*
+	FIRST_k and FOLLOW_k, for a fixed k >= 1, of a loaded grammar. FIRST_k(A) is every sequence of k
+	terminals a derivation of A can start with, plus the whole of any shorter sentence A derives.
+	FOLLOW_k(A) is every sequence of up to k terminals that can come after A, cut short where the input
+	ends; FOLLOW_k(goal) is { $ } if $ is declared, like FOLLOW, and { end of input } otherwise. A
+	sequence ends at $. As at k = 1 nothing is checked for being reachable or productive.
+
+	Both are least fixpoints over worklists of nonterminals that only pass on what is new: when a set
+	grows, just the added sequences are pushed through the productions that read it. Concatenation
+	distributes over union, so that gives the same sets as evaluating everything again, at a fraction
+	of the cost once the sets hold thousands of sequences. k = 1 gives the same sets as grammar_analyzer,
+	with epsilon as the empty sequence. The LL(k) check then compares FIRST_k(RHS) FOLLOW_k(LHS) of the alternatives of every nonterminal, so
+	the LL(1) conflicts that k tokens resolve drop out.
+*/
+class lookahead_analysis
+{
+public:
+	explicit lookahead_analysis(size_t k) : depth(k < 1 ? 1 : k) {}
+
+	//The grammar has to stay alive and unchanged while the results are used.
+	void compute(const symbol_table& symbols, const grammar& productions);
+
+	size_t k() const { return depth; }
+	const sequence_trie& sequences() const { return trie; }
+	const lookahead_set& first(symbol_id nonterminal) const { return firstData[table->index(nonterminal)]; }
+	const lookahead_set& follow(symbol_id nonterminal) const { return followData[table->index(nonterminal)]; }
+	//FIRST_k(RHS) FOLLOW_k(LHS), cut off after k terminals: what an LL(k) parser predicts p on.
+	const lookahead_set& production_lookahead(production_id p) const { return productionData[p]; }
+	//By nonterminal order then alternative order. Empty if the grammar is LL(k).
+	const std::vector<llk_conflict>& conflicts() const { return conflictData; }
+	const lookahead_stats& stats() const { return statsData; }
+
+private:
+	//FIRST_k of a terminal is the terminal alone, of epsilon the empty sequence.
+	const lookahead_set& symbol_first(symbol_id symbol) const
+	{
+		return table->isNonterminal(symbol) ? firstData[table->index(symbol)] : terminalFirst[table->index(symbol)];
+	}
+	//How many more terminals fit after s: none once it has k, or ends with $ since nothing comes after that.
+	size_t room(sequence_id s) const
+	{
+		return trie.length(s) >= depth || (s != EMPTY_SEQUENCE && trie.last(s) == endTerminal) ? 0 : depth - trie.length(s);
+	}
+	//No sequence has room left, so nothing that comes after can change the set.
+	bool full(const lookahead_set& set) const;
+	//set = set FIRST_k(RHS of p from position from to position to), stopping early once set is empty or full.
+	void extend(production_id p, size_t from, size_t to, lookahead_set& set);
+	//out = every sequence of left followed by every sequence of right, cut off after k. out is overwritten.
+	void concat_sets(const lookahead_set& left, const lookahead_set& right, lookahead_set& out);
+	//set |= other, true if set grew. The sequences that are new to set are also added to added.
+	bool unite(lookahead_set& set, const lookahead_set& other, lookahead_set* added = nullptr);
+	void compute_first();
+	void compute_follow();
+	void compute_conflicts();
+
+	size_t depth;
+	uint32_t endTerminal = UINT32_MAX;			//terminal index of $, if declared
+	const symbol_table* table = nullptr;
+	const grammar* rules = nullptr;
+	sequence_trie trie;
+	std::vector<lookahead_set> firstData;		//by nonterminal index
+	std::vector<lookahead_set> followData;		//by nonterminal index
+	std::vector<lookahead_set> terminalFirst;	//by terminal index
+	std::vector<lookahead_set> productionData;
+	std::vector<llk_conflict> conflictData;
+	lookahead_stats statsData;
+	std::vector<lookahead_set> pending;			//by nonterminal index, what the worklists haven't passed on yet
+	lookahead_set scratch;
+	lookahead_set partial;
+	lookahead_set merged;
+	lookahead_set fresh;
+	std::vector<lookahead_set> cut;			//concat_sets' right side cut down, by the room left
+};
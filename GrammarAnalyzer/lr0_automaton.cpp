@@ -0,0 +1,208 @@
+#include "lr0_automaton.h"
+#include "stopwatch.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+namespace
+{
+	uint64_t hash_items(const item_id* items, size_t count)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (size_t i = 0; i < count; i++)
+		{
+			hash = (hash ^ items[i]) * 1099511628211ull;
+			hash ^= hash >> 29;
+		}
+		return hash;
+	}
+}
+
+item_id lr0_automaton::skip_epsilon(item_id item) const
+{
+	while (itemSymbol[item] != NO_SYMBOL && itemSymbol[item] == table->epsilon)
+	{
+		item++;
+	}
+	return item;
+}
+
+state_id lr0_automaton::intern(size_t from, symbol_id symbol)
+{
+	const item_id* items = kernelItems.data() + from;
+	size_t count = kernelItems.size() - from;
+	uint64_t hash = hash_items(items, count);
+	size_t mask = slots.size() - 1;
+	size_t slot = (size_t)hash & mask;
+	for (; slots[slot] != NO_STATE; slot = (slot + 1) & mask)
+	{
+		state_id s = slots[slot];
+		if (kernelHash[s] == hash && kernelStart[s + 1] - kernelStart[s] == count
+			&& memcmp(kernelItems.data() + kernelStart[s], items, count * sizeof(item_id)) == 0)
+		{
+			kernelItems.resize(from);
+			return s;
+		}
+		statsData.probes++;
+	}
+	state_id state = (state_id)state_count();
+	slots[slot] = state;
+	kernelStart.push_back((uint32_t)kernelItems.size());
+	kernelHash.push_back(hash);
+	accessingSymbol.push_back(symbol);
+	//At most half full, so a miss ends soon.
+	if (2 * state_count() > slots.size())
+	{
+		grow();
+	}
+	return state;
+}
+
+void lr0_automaton::grow()
+{
+	slots.assign(2 * slots.size(), NO_STATE);
+	size_t mask = slots.size() - 1;
+	for (state_id s = 0; s < state_count(); s++)
+	{
+		size_t slot = (size_t)kernelHash[s] & mask;
+		while (slots[slot] != NO_STATE)
+		{
+			slot = (slot + 1) & mask;
+		}
+		slots[slot] = s;
+	}
+}
+
+uint32_t lr0_automaton::transition(state_id state, symbol_id symbol) const
+{
+	const symbol_id* first = transitionSymbol.data() + transitionStart[state];
+	const symbol_id* last = transitionSymbol.data() + transitionStart[state + 1];
+	const symbol_id* found = lower_bound(first, last, symbol);
+	return found != last && *found == symbol ? (uint32_t)(found - transitionSymbol.data()) : NO_TRANSITION;
+}
+
+void lr0_automaton::build(const symbol_table& symbols, const grammar& productions)
+{
+	stopwatch timer;
+	table = &symbols;
+	rules = &productions;
+	size_t productionCount = productions.production_count();
+	size_t itemCount = productions.symbol_count() + productionCount;
+	itemProduction.assign(itemCount, 0);
+	itemSymbol.assign(itemCount, NO_SYMBOL);
+	for (production_id p : productions.all_productions())
+	{
+		production_view production = productions.production(p);
+		item_id item = productions.rhs_offset(p) + p;
+		for (size_t dot = 0; dot <= production.size(); dot++)
+		{
+			itemProduction[item + dot] = p;
+			itemSymbol[item + dot] = dot < production.size() ? production[dot] : NO_SYMBOL;
+		}
+	}
+	firstItem.resize(productionCount);
+	for (production_id p : productions.all_productions())
+	{
+		firstItem[p] = skip_epsilon(productions.rhs_offset(p) + p);
+	}
+
+	kernelItems.clear();
+	kernelStart.assign(1, 0);
+	kernelHash.clear();
+	slots.assign(1024, NO_STATE);
+	accessingSymbol.clear();
+	transitionStart.assign(1, 0);
+	transitionSymbol.clear();
+	transitionTarget.clear();
+	reductionStart.assign(1, 0);
+	reductionProduction.clear();
+	statsData = lr0_stats();
+
+	size_t nonterminalCount = symbols.nonterminals().size();
+	if (nonterminalCount == 0)
+	{
+		statsData.build = timer.lap();
+		return;
+	}
+	uint32_t start = symbols.goal != NO_SYMBOL && symbols.isNonterminal(symbols.goal) ? symbols.index(symbols.goal) : 0;
+	for (production_id p : productions.productions_of(start))
+	{
+		kernelItems.push_back(firstItem[p]);
+	}
+	sort(kernelItems.begin(), kernelItems.end());
+	kernelItems.erase(unique(kernelItems.begin(), kernelItems.end()), kernelItems.end());
+	intern(0, NO_SYMBOL);
+
+	//stamp[n] == state + 1 once nonterminal n's productions are in the closure of state.
+	vector<uint32_t> stamp(nonterminalCount, 0);
+	vector<item_id> closure;
+	vector<uint64_t> moved;
+	for (state_id state = 0; state < state_count(); state++)
+	{
+		closure.assign(kernel_begin(state), kernel_end(state));
+		if (state == 0)
+		{
+			stamp[start] = 1;
+		}
+		for (size_t i = 0; i < closure.size(); i++)
+		{
+			symbol_id next = itemSymbol[closure[i]];
+			if (next == NO_SYMBOL || !symbols.isNonterminal(next) || stamp[symbols.index(next)] == state + 1)
+			{
+				continue;
+			}
+			stamp[symbols.index(next)] = state + 1;
+			for (production_id p : productions.productions_of(symbols.index(next)))
+			{
+				closure.push_back(firstItem[p]);
+			}
+		}
+		statsData.kernelItems += kernelStart[state + 1] - kernelStart[state];
+		statsData.closureItems += closure.size();
+
+		//Every item moves past its symbol into that symbol's kernel, completed ones are reductions. Sorting
+		//the (symbol, moved item) pairs of the state groups the kernels, each one already sorted.
+		moved.clear();
+		for (item_id item : closure)
+		{
+			symbol_id next = itemSymbol[item];
+			if (next == NO_SYMBOL)
+			{
+				reductionProduction.push_back(itemProduction[item]);
+				continue;
+			}
+			moved.push_back(((uint64_t)next << 32) | skip_epsilon(item + 1));
+		}
+		sort(reductionProduction.begin() + reductionStart.back(), reductionProduction.end());
+		reductionStart.push_back((uint32_t)reductionProduction.size());
+
+		sort(moved.begin(), moved.end());
+		for (size_t i = 0; i < moved.size();)
+		{
+			symbol_id symbol = (symbol_id)(moved[i] >> 32);
+			size_t from = kernelItems.size();
+			for (; i < moved.size() && (symbol_id)(moved[i] >> 32) == symbol; i++)
+			{
+				kernelItems.push_back((item_id)moved[i]);
+			}
+			transitionSymbol.push_back(symbol);
+			transitionTarget.push_back(intern(from, symbol));
+			if (symbols.isNonterminal(symbol))
+			{
+				statsData.nonterminalTransitions++;
+			}
+		}
+		transitionStart.push_back((uint32_t)transitionSymbol.size());
+	}
+
+	statsData.states = state_count();
+	statsData.transitions = transitionSymbol.size();
+	statsData.reductions = reductionProduction.size();
+	statsData.bytes = (itemProduction.capacity() + itemSymbol.capacity() + firstItem.capacity() + kernelItems.capacity()
+		+ kernelStart.capacity() + slots.capacity() + accessingSymbol.capacity() + transitionStart.capacity()
+		+ transitionSymbol.capacity() + transitionTarget.capacity() + reductionStart.capacity() + reductionProduction.capacity()) * sizeof(uint32_t)
+		+ kernelHash.capacity() * sizeof(uint64_t);
+	statsData.build = timer.lap();
+}
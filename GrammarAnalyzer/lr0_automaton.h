@@ -0,0 +1,120 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "symbol_table.h"
+#include "grammar.h"
+#include "analysis_stats.h"
+
+typedef uint32_t state_id;
+typedef uint32_t item_id;
+
+const state_id NO_STATE = 0xFFFFFFFF;
+const uint32_t NO_TRANSITION = 0xFFFFFFFF;
+
+//What one lr0_automaton::build did.
+struct lr0_stats
+{
+	phase_time build;
+	size_t states = 0;
+	size_t kernelItems = 0;			//summed over all states
+	size_t closureItems = 0;		//summed over all states, the kernels included
+	size_t transitions = 0;
+	size_t nonterminalTransitions = 0;
+	size_t reductions = 0;
+	size_t probes = 0;				//slots of the kernel table looked at past the first one
+	size_t bytes = 0;
+};
+
+/*
+	The canonical collection of LR(0) item sets of a loaded grammar and its goto function.
+
+	An item A ::= α . β is numbered like a row of grammar_analyzer's suffix tables, rhs_offset(p) + p + dot,
+	so items are plain integers and the item after the dot is item + 1. epsilon in a RHS derives nothing
+	and is skipped over, an epsilon alternative is complete as soon as it is predicted.
+
+	A state is its kernel, the items that don't have the dot at the start (and the start state's items
+	for goal). Kernels are sorted and hash-consed: all of them live in one flat array and a hash of the
+	items leads to the state that has them, so every goto target is found or created with one lookup in an
+	open addressing table that also keeps each state's hash, and only a matching hash costs a compare. The
+	closure is never stored, it is rebuilt from the kernel when a state is expanded.
+
+	States are numbered breadth first from the start state 0, so the numbering only depends on the grammar.
+	Transitions and completed items of each state are kept CSR style, the transitions sorted by symbol.
+	The start state is built from goal's productions, or those of the first nonterminal if there is no goal.
+*/
+class lr0_automaton
+{
+public:
+	//The grammar has to stay alive and unchanged while the automaton is used.
+	void build(const symbol_table& symbols, const grammar& productions);
+
+	size_t state_count() const { return kernelStart.size() - 1; }
+	size_t transition_count() const { return transitionSymbol.size(); }
+
+	//Transitions of state are [transition_begin(state), transition_end(state)), sorted by symbol.
+	uint32_t transition_begin(state_id state) const { return transitionStart[state]; }
+	uint32_t transition_end(state_id state) const { return transitionStart[state + 1]; }
+	symbol_id transition_symbol(uint32_t t) const { return transitionSymbol[t]; }
+	state_id transition_target(uint32_t t) const { return transitionTarget[t]; }
+	//The transition out of state on symbol, NO_TRANSITION if there is none.
+	uint32_t transition(state_id state, symbol_id symbol) const;
+	//The state reached from state on symbol, NO_STATE if there is none.
+	state_id go(state_id state, symbol_id symbol) const
+	{
+		uint32_t t = transition(state, symbol);
+		return t == NO_TRANSITION ? NO_STATE : transitionTarget[t];
+	}
+	//The symbol every transition into state is on, NO_SYMBOL for the start state.
+	symbol_id accessing_symbol(state_id state) const { return accessingSymbol[state]; }
+
+	//Productions state can reduce by, [reduction_begin(state), reduction_end(state)), sorted.
+	uint32_t reduction_begin(state_id state) const { return reductionStart[state]; }
+	uint32_t reduction_end(state_id state) const { return reductionStart[state + 1]; }
+	size_t reduction_count() const { return reductionProduction.size(); }
+	production_id reduction_production(uint32_t r) const { return reductionProduction[r]; }
+
+	//Kernels of all states back to back, state by state, so kernel_begin(state) - kernel_begin(0) numbers
+	//the kernel items of the whole automaton.
+	size_t kernel_item_count() const { return kernelItems.size(); }
+	const item_id* kernel_begin(state_id state) const { return kernelItems.data() + kernelStart[state]; }
+	const item_id* kernel_end(state_id state) const { return kernelItems.data() + kernelStart[state + 1]; }
+	production_id item_production(item_id item) const { return itemProduction[item]; }
+	size_t item_dot(item_id item) const { return item - (rules->rhs_offset(itemProduction[item]) + itemProduction[item]); }
+	//The symbol after the dot, NO_SYMBOL if the item is complete.
+	symbol_id item_symbol(item_id item) const { return itemSymbol[item]; }
+
+	const lr0_stats& stats() const { return statsData; }
+
+private:
+	//The item with the dot moved past any epsilon.
+	item_id skip_epsilon(item_id item) const;
+	//The state with the kernel in kernelItems from from on, adding it as reached on symbol if it is new.
+	//A kernel that is already known is taken back off kernelItems.
+	state_id intern(size_t from, symbol_id symbol);
+	//Doubles slots and puts every state back in.
+	void grow();
+
+	const symbol_table* table = nullptr;
+	const grammar* rules = nullptr;
+
+	std::vector<production_id> itemProduction;	//by item
+	std::vector<symbol_id> itemSymbol;			//by item
+	std::vector<item_id> firstItem;				//by production, epsilon skipped
+
+	std::vector<item_id> kernelItems;
+	std::vector<uint32_t> kernelStart = { 0 };	//by state, one past the end too
+	std::vector<uint64_t> kernelHash;			//by state
+	std::vector<state_id> slots;				//open addressing on kernelHash, linear probing, NO_STATE when free
+	std::vector<symbol_id> accessingSymbol;		//by state
+
+	std::vector<uint32_t> transitionStart;		//by state, one past the end too
+	std::vector<symbol_id> transitionSymbol;
+	std::vector<state_id> transitionTarget;
+	std::vector<uint32_t> reductionStart;		//by state, one past the end too
+	std::vector<production_id> reductionProduction;
+
+	lr0_stats statsData;
+};
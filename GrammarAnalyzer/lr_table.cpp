@@ -0,0 +1,137 @@
+#include "lr_table.h"
+#include "grammar_analyzer.h"
+#include "stopwatch.h"
+
+#include <algorithm>
+
+using namespace std;
+
+void lr_table::build(const lr0_automaton& automaton, const symbol_table& symbols, const vector<terminal_set_view>& lookaheads)
+{
+	stopwatch timer;
+	actionStart.assign(1, 0);
+	actionTerminal.clear();
+	actionValue.clear();
+	gotoStart.assign(1, 0);
+	gotoNonterminal.clear();
+	gotoTarget.clear();
+	conflictData.clear();
+	statsData = lr_table_stats();
+
+	size_t terminalCount = symbols.terminals().size();
+	vector<lr_action> cell(terminalCount, LR_NO_ACTION);
+	vector<uint32_t> touched;
+	vector<pair<uint32_t, state_id>> gotos;
+	terminal_set shifts(terminalCount);
+	terminal_set claimed(terminalCount);
+	terminal_set lost(terminalCount);
+	for (state_id state = 0; state < automaton.state_count(); state++)
+	{
+		touched.clear();
+		gotos.clear();
+		shifts.clear();
+		for (uint32_t t = automaton.transition_begin(state); t < automaton.transition_end(state); t++)
+		{
+			symbol_id symbol = automaton.transition_symbol(t);
+			if (symbols.isNonterminal(symbol))
+			{
+				gotos.push_back(make_pair(symbols.index(symbol), automaton.transition_target(t)));
+				continue;
+			}
+			uint32_t terminal = symbols.index(symbol);
+			cell[terminal] = lr_shift(automaton.transition_target(t));
+			shifts.set(terminal);
+			touched.push_back(terminal);
+			statsData.shifts++;
+		}
+		sort(gotos.begin(), gotos.end());
+		for (const pair<uint32_t, state_id>& entry : gotos)
+		{
+			gotoNonterminal.push_back(entry.first);
+			gotoTarget.push_back(entry.second);
+		}
+		gotoStart.push_back((uint32_t)gotoTarget.size());
+
+		//Reductions come sorted by production. Each one loses to the shifts and then, cell by cell, to
+		//the earliest reduction before it on the same terminal, one conflict per action it lost to.
+		uint32_t first = automaton.reduction_begin(state);
+		for (uint32_t r = first; r < automaton.reduction_end(state); r++)
+		{
+			production_id p = automaton.reduction_production(r);
+			lost.clear();
+			lost.unite(lookaheads[r]);
+			lost.intersect(shifts);
+			if (!lost.empty())
+			{
+				statsData.shiftReduce += lost.count();
+				conflictData.push_back(lr_conflict{ state, SHIFT_REDUCE, p, LR_NO_PRODUCTION, lost });
+			}
+			claimed = shifts;
+			for (uint32_t q = first; q < r; q++)
+			{
+				lost.clear();
+				lost.unite(lookaheads[r]);
+				lost.intersect(lookaheads[q]);
+				lost.subtract(claimed);
+				if (!lost.empty())
+				{
+					statsData.reduceReduce += lost.count();
+					conflictData.push_back(lr_conflict{ state, REDUCE_REDUCE, p, automaton.reduction_production(q), lost });
+				}
+				claimed.unite(lookaheads[q]);
+			}
+			lost.clear();
+			lost.unite(lookaheads[r]);
+			lost.subtract(claimed);
+			for (size_t terminal : lost)
+			{
+				cell[terminal] = lr_reduce(p);
+				touched.push_back((uint32_t)terminal);
+				statsData.reduces++;
+			}
+		}
+
+		sort(touched.begin(), touched.end());
+		for (uint32_t terminal : touched)
+		{
+			actionTerminal.push_back(terminal);
+			actionValue.push_back(cell[terminal]);
+			cell[terminal] = LR_NO_ACTION;
+		}
+		actionStart.push_back((uint32_t)actionValue.size());
+	}
+
+	statsData.actions = actionValue.size();
+	statsData.bytes = (actionStart.capacity() + actionTerminal.capacity() + actionValue.capacity() + gotoStart.capacity()
+		+ gotoNonterminal.capacity() + gotoTarget.capacity()) * sizeof(uint32_t) + conflictData.capacity() * sizeof(lr_conflict)
+		+ conflictData.size() * terminal_set_words(terminalCount) * sizeof(uint64_t);
+	statsData.build = timer.lap();
+}
+
+void lr_table::build_slr(const lr0_automaton& automaton, const grammar_analyzer& analyzer)
+{
+	const grammar& productions = analyzer.productions();
+	vector<terminal_set_view> lookaheads;
+	lookaheads.reserve(automaton.reduction_count());
+	for (uint32_t r = 0; r < automaton.reduction_count(); r++)
+	{
+		lookaheads.push_back(analyzer.follow(productions.production(automaton.reduction_production(r)).lhs));
+	}
+	build(automaton, analyzer.symbols(), lookaheads);
+}
+
+lr_action lr_table::action(state_id state, uint32_t terminal) const
+{
+	const uint32_t* first = actionTerminal.data() + actionStart[state];
+	const uint32_t* last = actionTerminal.data() + actionStart[state + 1];
+	const uint32_t* found = lower_bound(first, last, terminal);
+	return found != last && *found == terminal ? actionValue[found - actionTerminal.data()] : LR_NO_ACTION;
+}
+
+state_id lr_table::go(state_id state, uint32_t nonterminal) const
+{
+	const uint32_t* first = gotoNonterminal.data() + gotoStart[state];
+	const uint32_t* last = gotoNonterminal.data() + gotoStart[state + 1];
+	const uint32_t* found = lower_bound(first, last, nonterminal);
+	return found != last && *found == nonterminal ? gotoTarget[found - gotoNonterminal.data()] : NO_STATE;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "lr0_automaton.h"
+#include "terminal_set.h"
+
+class grammar_analyzer;
+
+/*
+	One ACTION cell: the kind in the low two bits, the state to shift to or the production to reduce by above
+	them. 0 is an error. There is no accept action: reducing by a goal production down to the start state
+	with $ next accepts.
+*/
+typedef uint32_t lr_action;
+
+enum lr_action_kind
+{
+	LR_ERROR,
+	LR_SHIFT,
+	LR_REDUCE
+};
+
+const lr_action LR_NO_ACTION = 0;
+const production_id LR_NO_PRODUCTION = 0xFFFFFFFF;
+
+inline lr_action lr_shift(state_id state) { return (state << 2) | LR_SHIFT; }
+inline lr_action lr_reduce(production_id p) { return (p << 2) | LR_REDUCE; }
+inline lr_action_kind lr_kind(lr_action action) { return (lr_action_kind)(action & 3); }
+inline uint32_t lr_target(lr_action action) { return action >> 2; }
+
+enum lr_conflict_kind
+{
+	SHIFT_REDUCE,
+	REDUCE_REDUCE
+};
+
+//A reduction that lost cells of a state to a shift or to another reduction.
+struct lr_conflict
+{
+	state_id state;
+	lr_conflict_kind kind;
+	production_id first;		//the production that lost
+	production_id second;		//REDUCE_REDUCE: the earlier production it lost to, SHIFT_REDUCE: LR_NO_PRODUCTION
+	terminal_set terminals;		//the cells it lost
+};
+
+struct lr_table_stats
+{
+	phase_time build;
+	size_t actions = 0;			//filled cells
+	size_t shifts = 0;
+	size_t reduces = 0;
+	size_t shiftReduce = 0;		//cells, not lr_conflict entries
+	size_t reduceReduce = 0;
+	size_t bytes = 0;
+};
+
+/*
+	ACTION and GOTO of an LR parser, built from an lr0_automaton and one lookahead set per reduction. Which
+	sets those are decides the kind of table: FOLLOW of the production's LHS for SLR(1) (build_slr), the
+	LALR(1) lookaheads for LALR(1).
+
+	Conflicts are resolved the way yacc does: shift wins over reduce and of two reductions the production
+	that comes first in the grammar wins. Every action that lost is reported, so the table is usable either
+	way and the grammar is SLR(1) or LALR(1) exactly when conflicts() is empty. Conflicts are kept per
+	reduction and per action it lost to, with the terminals as a set, so a badly ambiguous grammar costs
+	one entry per pair of actions rather than one per cell.
+
+	Rows are sparse, each state keeps its filled cells sorted by terminal and a lookup is a binary search.
+*/
+class lr_table
+{
+public:
+	//lookaheads[r] is the set reduction r of the automaton is done on. The automaton and the sets only
+	//need to live during the call.
+	void build(const lr0_automaton& automaton, const symbol_table& symbols, const std::vector<terminal_set_view>& lookaheads);
+	//analyzer must have been computed, the automaton built on its grammar.
+	void build_slr(const lr0_automaton& automaton, const grammar_analyzer& analyzer);
+
+	size_t state_count() const { return actionStart.empty() ? 0 : actionStart.size() - 1; }
+	//LR_NO_ACTION if terminal is an error in state.
+	lr_action action(state_id state, uint32_t terminal) const;
+	//NO_STATE if there is no transition on the nonterminal (index) from state.
+	state_id go(state_id state, uint32_t nonterminal) const;
+
+	//By state, then the production that lost, shift/reduce before reduce/reduce, then the production it lost to.
+	const std::vector<lr_conflict>& conflicts() const { return conflictData; }
+	const lr_table_stats& stats() const { return statsData; }
+
+private:
+	std::vector<uint32_t> actionStart;			//by state, one past the end too
+	std::vector<uint32_t> actionTerminal;
+	std::vector<lr_action> actionValue;
+	std::vector<uint32_t> gotoStart;			//by state, one past the end too
+	std::vector<uint32_t> gotoNonterminal;
+	std::vector<state_id> gotoTarget;
+	std::vector<lr_conflict> conflictData;
+	lr_table_stats statsData;
+};
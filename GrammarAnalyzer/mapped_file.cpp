@@ -0,0 +1,115 @@
+#include "mapped_file.h"
+
+#include <fstream>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+bool mapped_file::open(const char* path, string& error)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file != INVALID_HANDLE_VALUE)
+	{
+		LARGE_INTEGER size;
+		if (GetFileSizeEx(file, &size) && size.QuadPart == 0)
+		{
+			//Empty files can't be mapped, but they are still valid input.
+			CloseHandle(file);
+			return true;
+		}
+		HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping != NULL)
+		{
+			const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			if (view != NULL)
+			{
+				fileHandle = file;
+				mappingHandle = mapping;
+				bytes = (const char*)view;
+				length = (size_t)size.QuadPart;
+				mapped = true;
+				return true;
+			}
+			CloseHandle(mapping);
+		}
+		CloseHandle(file);
+	}
+#else
+	int fd = ::open(path, O_RDONLY);
+	if (fd >= 0)
+	{
+		struct stat info;
+		if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode))
+		{
+			if (info.st_size == 0)
+			{
+				::close(fd);
+				return true;
+			}
+			void* view = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (view != MAP_FAILED)
+			{
+				::close(fd);
+#ifdef MADV_SEQUENTIAL
+				madvise(view, (size_t)info.st_size, MADV_SEQUENTIAL);
+#endif
+				bytes = (const char*)view;
+				length = (size_t)info.st_size;
+				mapped = true;
+				return true;
+			}
+		}
+		::close(fd);
+	}
+#endif
+
+	//Pipes, special files or a failed mapping: read the whole stream instead.
+	ifstream in(path, ios::binary);
+	if (!in)
+	{
+		error = string("can't open ") + path;
+		return false;
+	}
+	char chunk[1 << 16];
+	while (in.read(chunk, sizeof(chunk)) || in.gcount() > 0)
+	{
+		fallback.insert(fallback.end(), chunk, chunk + in.gcount());
+	}
+	bytes = fallback.data();
+	length = fallback.size();
+	return true;
+}
+
+void mapped_file::close()
+{
+	if (mapped)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(bytes);
+		CloseHandle((HANDLE)mappingHandle);
+		CloseHandle((HANDLE)fileHandle);
+		mappingHandle = nullptr;
+		fileHandle = nullptr;
+#else
+		munmap((void*)bytes, length);
+#endif
+	}
+	mapped = false;
+	bytes = nullptr;
+	length = 0;
+	fallback.clear();
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+//Read-only view of a whole file. The file is memory mapped where the platform allows it, so the loaders
+//can tokenize straight out of the page cache; if mapping fails the file is read into one buffer instead.
+class mapped_file
+{
+public:
+	mapped_file() {}
+	~mapped_file() { close(); }
+	mapped_file(const mapped_file&) = delete;
+	mapped_file& operator=(const mapped_file&) = delete;
+
+	//Returns false and fills error if path can not be opened.
+	bool open(const char* path, std::string& error);
+	void close();
+
+	std::string_view contents() const { return std::string_view(bytes, length); }
+
+private:
+	const char* bytes = nullptr;
+	size_t length = 0;
+	bool mapped = false;
+	std::vector<char> fallback;
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#endif
+};
@@ -0,0 +1,649 @@
+#include "output_writer.h"
+#include "grammar_analyzer.h"
+#include "lookahead_analysis.h"
+#include "lr_table.h"
+#include "batch_analysis.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+using namespace std;
+
+bool output_writer::open(const char* path, string& error)
+{
+	close();
+#ifdef _WIN32
+	int file = _open(path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+	int file = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+	if (file < 0)
+	{
+		error = string(path) + ": can't open for writing";
+		return false;
+	}
+	fd = file;
+	owned = true;
+	failed = false;
+	return true;
+}
+
+void output_writer::attach(int descriptor)
+{
+	close();
+	fd = descriptor;
+	owned = false;
+	failed = false;
+}
+
+bool output_writer::close()
+{
+	flush();
+	if (owned)
+	{
+#ifdef _WIN32
+		failed |= _close(fd) != 0;
+#else
+		failed |= ::close(fd) != 0;
+#endif
+	}
+	fd = -1;
+	owned = false;
+	return !failed;
+}
+
+void output_writer::flush()
+{
+	drain();
+}
+
+void output_writer::drain()
+{
+	write_all(buffer.data(), used);
+	used = 0;
+}
+
+void output_writer::write_all(const char* data, size_t size)
+{
+	if (fd < 0)
+	{
+		return;
+	}
+	while (size > 0 && !failed)
+	{
+#ifdef _WIN32
+		int chunk = (int)min(size, (size_t)1 << 30);
+		int written = _write(fd, data, (unsigned int)chunk);
+#else
+		ssize_t written = ::write(fd, data, size);
+		if (written < 0 && errno == EINTR)
+		{
+			continue;
+		}
+#endif
+		if (written <= 0)
+		{
+			failed = true;
+			return;
+		}
+		data += written;
+		size -= (size_t)written;
+	}
+}
+
+namespace
+{
+	//What is written in which order, worked out once for all three formats.
+	struct result_order
+	{
+		const grammar_analyzer& analyzer;
+		const symbol_table& symbols;
+		output_order order;
+		vector<symbol_id> all;					//every symbol, for FIRST
+		vector<symbol_id> nonterminals;
+		vector<uint32_t> terminalRank;			//by terminal index, its place in the output
+		vector<const ll1_conflict*> conflicts;
+		vector<size_t> members;					//scratch for one set
+
+		result_order(const grammar_analyzer& a, output_order o) : analyzer(a), symbols(a.symbols()), order(o)
+		{
+			for (symbol_id id = 0; id < symbols.size(); id++)
+			{
+				all.push_back(id);
+			}
+			nonterminals = symbols.nonterminals();
+			size_t terminalCount = symbols.terminals().size();
+			terminalRank.resize(terminalCount);
+			for (const ll1_conflict& conflict : analyzer.ll1_conflicts())
+			{
+				conflicts.push_back(&conflict);
+			}
+			if (order == ORDER_BY_ID)
+			{
+				for (uint32_t t = 0; t < terminalCount; t++)
+				{
+					terminalRank[t] = t;
+				}
+				return;
+			}
+
+			auto byName = [this](symbol_id a, symbol_id b) { return symbols.name(a) < symbols.name(b); };
+			sort(all.begin(), all.end(), byName);
+			sort(nonterminals.begin(), nonterminals.end(), byName);
+			vector<symbol_id> terminals = symbols.terminals();
+			sort(terminals.begin(), terminals.end(), byName);
+			for (uint32_t rank = 0; rank < terminalCount; rank++)
+			{
+				terminalRank[symbols.index(terminals[rank])] = rank;
+			}
+			//Alternatives of one nonterminal stay in grammar order.
+			stable_sort(conflicts.begin(), conflicts.end(),
+				[&](const ll1_conflict* a, const ll1_conflict* b) { return byName(a->nonterminal, b->nonterminal); });
+		}
+
+		//The terminals of set, in output order.
+		const vector<size_t>& sorted(const terminal_set_view& set)
+		{
+			members.clear();
+			for (size_t bit : set)
+			{
+				members.push_back(bit);
+			}
+			if (order == ORDER_BY_NAME)
+			{
+				sort(members.begin(), members.end(), [this](size_t a, size_t b) { return terminalRank[a] < terminalRank[b]; });
+			}
+			return members;
+		}
+
+		const string& terminal(size_t bit) const { return analyzer.terminal_name(bit); }
+	};
+
+	//The RHS of p, every symbol followed by a space.
+	void write_production(output_writer& out, const result_order& ro, production_id p)
+	{
+		for (symbol_id symbol : ro.analyzer.productions().production(p))
+		{
+			out << ro.symbols.name(symbol) << ' ';
+		}
+	}
+
+	void write_text(output_writer& out, result_order& ro)
+	{
+		const grammar_analyzer& analyzer = ro.analyzer;
+		out << "\n\n ============= FIRST SETS ==============\n\n";
+		for (symbol_id id : ro.all)
+		{
+			out << "Token value: " << ro.symbols.name(id) << " | FIRST =  { ";
+			bool first = true;
+			for (size_t bit : ro.sorted(analyzer.first(id)))
+			{
+				if (!first)
+				{
+					out << ", ";
+				}
+				out << ro.terminal(bit);
+				first = false;
+			}
+			out << " }\n";
+		}
+		out << "\n\n =======================================\n\n";
+
+		out << "\n\n ============= FOLLOW SETS ==============\n\n";
+		for (symbol_id nt : ro.nonterminals)
+		{
+			out << "Token value: " << ro.symbols.name(nt) << " | FOLLOW = { ";
+			for (size_t bit : ro.sorted(analyzer.follow(nt)))
+			{
+				out << ro.terminal(bit) << ' ';
+			}
+			out << "}\n";
+		}
+
+		out << "\n\n ============= FIRSTPLUS SETS ==============\n\n";
+		for (symbol_id nt : ro.nonterminals)
+		{
+			out << "\nFIRST_PLUS(" << ro.symbols.name(nt) << ") = { ";
+			for (size_t bit : ro.sorted(analyzer.first_plus(nt)))
+			{
+				out << ro.terminal(bit) << ' ';
+			}
+			out << '}';
+		}
+		out << '\n';
+
+		//"A ::= x y | A ::= x z on { x }"
+		out << "\n\n ============= LL(1) CONFLICTS ==============\n\n";
+		for (const ll1_conflict* conflict : ro.conflicts)
+		{
+			const string& lhs = ro.symbols.name(conflict->nonterminal);
+			out << lhs << " ::= ";
+			write_production(out, ro, conflict->first);
+			out << "| " << lhs << " ::= ";
+			write_production(out, ro, conflict->second);
+			out << "on { ";
+			for (size_t bit : ro.sorted(conflict->overlap))
+			{
+				out << ro.terminal(bit) << ' ';
+			}
+			out << "}\n";
+		}
+		if (ro.conflicts.empty())
+		{
+			out << "None, the grammar is LL(1).\n";
+		}
+	}
+
+	void write_json_string(output_writer& out, string_view text)
+	{
+		static const char hex[] = "0123456789abcdef";
+		out << '"';
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\')
+			{
+				out << '\\' << c;
+			}
+			else if ((unsigned char)c < 0x20)
+			{
+				out << "\\u00" << hex[(unsigned char)c >> 4] << hex[c & 15];
+			}
+			else
+			{
+				out << c;
+			}
+		}
+		out << '"';
+	}
+
+	void write_json_terminals(output_writer& out, result_order& ro, const terminal_set_view& set)
+	{
+		out << '[';
+		bool first = true;
+		for (size_t bit : ro.sorted(set))
+		{
+			out << (first ? "" : ", ");
+			write_json_string(out, ro.terminal(bit));
+			first = false;
+		}
+		out << ']';
+	}
+
+	void write_json_production(output_writer& out, const result_order& ro, production_id p)
+	{
+		out << '[';
+		bool first = true;
+		for (symbol_id symbol : ro.analyzer.productions().production(p))
+		{
+			out << (first ? "" : ", ");
+			write_json_string(out, ro.symbols.name(symbol));
+			first = false;
+		}
+		out << ']';
+	}
+
+	//One "name": [terminals] member per line.
+	template<typename SetOf>
+	void write_json_sets(output_writer& out, result_order& ro, const char* name, const vector<symbol_id>& ids, SetOf setOf, bool last)
+	{
+		out << "  \"" << name << "\": {";
+		for (size_t i = 0; i < ids.size(); i++)
+		{
+			out << (i == 0 ? "\n    " : ",\n    ");
+			write_json_string(out, ro.symbols.name(ids[i]));
+			out << ": ";
+			write_json_terminals(out, ro, setOf(ids[i]));
+		}
+		out << (ids.empty() ? "}" : "\n  }") << (last ? "\n" : ",\n");
+	}
+
+	void write_json(output_writer& out, result_order& ro)
+	{
+		const grammar_analyzer& analyzer = ro.analyzer;
+		out << "{\n";
+		write_json_sets(out, ro, "first", ro.all, [&](symbol_id id) { return terminal_set_view(analyzer.first(id)); }, false);
+		write_json_sets(out, ro, "follow", ro.nonterminals, [&](symbol_id id) { return terminal_set_view(analyzer.follow(id)); }, false);
+		write_json_sets(out, ro, "first_plus", ro.nonterminals, [&](symbol_id id) { return terminal_set_view(analyzer.first_plus(id)); }, false);
+		out << "  \"ll1_conflicts\": [";
+		for (size_t i = 0; i < ro.conflicts.size(); i++)
+		{
+			const ll1_conflict* conflict = ro.conflicts[i];
+			out << (i == 0 ? "\n    { \"nonterminal\": " : ",\n    { \"nonterminal\": ");
+			write_json_string(out, ro.symbols.name(conflict->nonterminal));
+			out << ", \"first\": ";
+			write_json_production(out, ro, conflict->first);
+			out << ", \"second\": ";
+			write_json_production(out, ro, conflict->second);
+			out << ", \"overlap\": ";
+			write_json_terminals(out, ro, conflict->overlap);
+			out << " }";
+		}
+		out << (ro.conflicts.empty() ? "]\n" : "\n  ]\n") << "}\n";
+	}
+
+	//Grammar symbols never contain whitespace, but they can contain commas and quotes.
+	void write_csv_field(output_writer& out, string_view text)
+	{
+		if (text.find_first_of(",\"\r\n") == string_view::npos)
+		{
+			out << text;
+			return;
+		}
+		out << '"';
+		for (char c : text)
+		{
+			if (c == '"')
+			{
+				out << '"';
+			}
+			out << c;
+		}
+		out << '"';
+	}
+
+	void write_csv_terminals(output_writer& out, result_order& ro, const terminal_set_view& set, string& field)
+	{
+		field.clear();
+		for (size_t bit : ro.sorted(set))
+		{
+			if (!field.empty())
+			{
+				field += ' ';
+			}
+			field += ro.terminal(bit);
+		}
+		write_csv_field(out, field);
+	}
+
+	void write_csv(output_writer& out, result_order& ro)
+	{
+		const grammar_analyzer& analyzer = ro.analyzer;
+		string field;
+		out << "set,symbol,terminals,alternatives\n";
+		for (symbol_id id : ro.all)
+		{
+			out << "first,";
+			write_csv_field(out, ro.symbols.name(id));
+			out << ',';
+			write_csv_terminals(out, ro, analyzer.first(id), field);
+			out << ",\n";
+		}
+		for (symbol_id nt : ro.nonterminals)
+		{
+			out << "follow,";
+			write_csv_field(out, ro.symbols.name(nt));
+			out << ',';
+			write_csv_terminals(out, ro, analyzer.follow(nt), field);
+			out << ",\n";
+		}
+		for (symbol_id nt : ro.nonterminals)
+		{
+			out << "first_plus,";
+			write_csv_field(out, ro.symbols.name(nt));
+			out << ',';
+			write_csv_terminals(out, ro, analyzer.first_plus(nt), field);
+			out << ",\n";
+		}
+		//The overlap in terminals, the two alternatives as "x y | x z".
+		for (const ll1_conflict* conflict : ro.conflicts)
+		{
+			out << "ll1_conflict,";
+			write_csv_field(out, ro.symbols.name(conflict->nonterminal));
+			out << ',';
+			write_csv_terminals(out, ro, conflict->overlap, field);
+			out << ',';
+			field.clear();
+			for (production_id p : { conflict->first, conflict->second })
+			{
+				if (p == conflict->second)
+				{
+					field += " |";
+				}
+				for (symbol_id symbol : analyzer.productions().production(p))
+				{
+					if (!field.empty())
+					{
+						field += ' ';
+					}
+					field += ro.symbols.name(symbol);
+				}
+			}
+			write_csv_field(out, field);
+			out << '\n';
+		}
+	}
+
+	//The sequences of set in output order: terminal by terminal, a sequence before those it is a prefix of.
+	//byRank is terminalRank inverted. empty is what the empty sequence is written as.
+	void write_sequences(output_writer& out, const result_order& ro, const vector<uint32_t>& byRank, const lookahead_analysis& lookahead,
+		const lookahead_set& set, string_view empty)
+	{
+		vector<vector<uint32_t>> sequences(set.size());
+		for (size_t i = 0; i < set.size(); i++)
+		{
+			lookahead.sequences().terminals(set[i], sequences[i]);
+			for (uint32_t& t : sequences[i])
+			{
+				t = ro.terminalRank[t];
+			}
+		}
+		sort(sequences.begin(), sequences.end());
+		out << "{ ";
+		for (size_t i = 0; i < sequences.size(); i++)
+		{
+			out << (i == 0 ? "" : ", ");
+			if (sequences[i].empty())
+			{
+				out << empty;
+			}
+			for (size_t j = 0; j < sequences[i].size(); j++)
+			{
+				out << (j == 0 ? "" : " ") << ro.terminal(byRank[sequences[i][j]]);
+			}
+		}
+		out << (sequences.empty() ? "}" : " }");
+	}
+}
+
+void write_results(output_writer& out, const grammar_analyzer& analyzer, output_format format, output_order order)
+{
+	result_order ro(analyzer, order);
+	switch (format)
+	{
+	case OUTPUT_TEXT:
+		write_text(out, ro);
+		break;
+	case OUTPUT_JSON:
+		write_json(out, ro);
+		break;
+	case OUTPUT_CSV:
+		write_csv(out, ro);
+		break;
+	}
+	out.flush();
+}
+
+void write_lookahead(output_writer& out, const grammar_analyzer& analyzer, const lookahead_analysis& lookahead, output_order order)
+{
+	result_order ro(analyzer, order);
+	string k = to_string(lookahead.k());
+	string epsilon = analyzer.symbols().epsilon != NO_SYMBOL ? analyzer.symbols().name(analyzer.symbols().epsilon) : "epsilon";
+	vector<uint32_t> byRank(ro.terminalRank.size());
+	for (uint32_t t = 0; t < byRank.size(); t++)
+	{
+		byRank[ro.terminalRank[t]] = t;
+	}
+	out << "\n\n ============= FIRST_" << k << " SETS ==============\n\n";
+	for (symbol_id nt : ro.nonterminals)
+	{
+		out << "Token value: " << ro.symbols.name(nt) << " | FIRST_" << k << " = ";
+		write_sequences(out, ro, byRank, lookahead, lookahead.first(nt), epsilon);
+		out << '\n';
+	}
+
+	//The empty sequence in FOLLOW_k is the end of the input, only there when $ isn't declared.
+	out << "\n\n ============= FOLLOW_" << k << " SETS ==============\n\n";
+	for (symbol_id nt : ro.nonterminals)
+	{
+		out << "Token value: " << ro.symbols.name(nt) << " | FOLLOW_" << k << " = ";
+		write_sequences(out, ro, byRank, lookahead, lookahead.follow(nt), "<end>");
+		out << '\n';
+	}
+
+	vector<const llk_conflict*> conflicts;
+	for (const llk_conflict& conflict : lookahead.conflicts())
+	{
+		conflicts.push_back(&conflict);
+	}
+	if (order == ORDER_BY_NAME)
+	{
+		stable_sort(conflicts.begin(), conflicts.end(), [&](const llk_conflict* a, const llk_conflict* b)
+			{ return ro.symbols.name(a->nonterminal) < ro.symbols.name(b->nonterminal); });
+	}
+	out << "\n\n ============= LL(" << k << ") CONFLICTS ==============\n\n";
+	for (const llk_conflict* conflict : conflicts)
+	{
+		const string& lhs = ro.symbols.name(conflict->nonterminal);
+		out << lhs << " ::= ";
+		write_production(out, ro, conflict->first);
+		out << "| " << lhs << " ::= ";
+		write_production(out, ro, conflict->second);
+		out << "on ";
+		write_sequences(out, ro, byRank, lookahead, conflict->overlap, "<end>");
+		out << '\n';
+	}
+	if (conflicts.empty())
+	{
+		out << "None, the grammar is LL(" << k << ").\n";
+	}
+	out.flush();
+}
+
+void write_lr_report(output_writer& out, const grammar_analyzer& analyzer, const lr0_automaton& automaton, const lr_table& table, string_view kind)
+{
+	result_order ro(analyzer, ORDER_BY_ID);
+	const symbol_table& symbols = analyzer.symbols();
+	const lr0_stats& stats = automaton.stats();
+	out << "\n\n ============= " << kind << " AUTOMATON ==============\n\n";
+	out << "states: " << to_string(stats.states) << ", kernel items: " << to_string(stats.kernelItems) << ", closure items: "
+		<< to_string(stats.closureItems) << ", transitions: " << to_string(stats.transitions) << " (" << to_string(stats.nonterminalTransitions)
+		<< " on nonterminals), reductions: " << to_string(stats.reductions) << ", actions: " << to_string(table.stats().actions) << '\n';
+
+	//Each conflicting state's kernel, then one line per conflict: "on { + }, shift/reduce: shift | expr ::= term ".
+	out << "\n\n ============= " << kind << " CONFLICTS ==============\n\n";
+	state_id shown = NO_STATE;
+	for (const lr_conflict& conflict : table.conflicts())
+	{
+		if (conflict.state != shown)
+		{
+			shown = conflict.state;
+			out << "state " << to_string(conflict.state) << ":\n";
+			for (const item_id* item = automaton.kernel_begin(conflict.state); item != automaton.kernel_end(conflict.state); item++)
+			{
+				production_view production = analyzer.productions().production(automaton.item_production(*item));
+				size_t dot = automaton.item_dot(*item);
+				out << '\t' << symbols.name(production.lhs) << " ::=";
+				for (size_t i = 0; i <= production.size(); i++)
+				{
+					if (i == dot)
+					{
+						out << " .";
+					}
+					if (i < production.size())
+					{
+						out << ' ' << symbols.name(production[i]);
+					}
+				}
+				out << '\n';
+			}
+		}
+		//The action that lost comes last.
+		out << "\ton { ";
+		for (size_t terminal : conflict.terminals)
+		{
+			out << analyzer.terminal_name(terminal) << ' ';
+		}
+		if (conflict.kind == SHIFT_REDUCE)
+		{
+			out << "}, shift/reduce: shift | ";
+		}
+		else
+		{
+			out << "}, reduce/reduce: " << symbols.name(analyzer.productions().production(conflict.second).lhs) << " ::= ";
+			write_production(out, ro, conflict.second);
+			out << "| ";
+		}
+		out << symbols.name(analyzer.productions().production(conflict.first).lhs) << " ::= ";
+		write_production(out, ro, conflict.first);
+		out << '\n';
+	}
+	if (table.conflicts().empty())
+	{
+		out << "None, the grammar is " << kind << ".\n";
+	}
+	out.flush();
+}
+
+void write_grammar(output_writer& out, const grammar_analyzer& analyzer)
+{
+	const symbol_table& symbols = analyzer.symbols();
+	const grammar& productions = analyzer.productions();
+	for (uint32_t nonterminal = 0; nonterminal < symbols.nonterminals().size(); nonterminal++)
+	{
+		out << symbols.name(symbols.nonterminals()[nonterminal]) << " ::=";
+		bool first = true;
+		for (production_id p : productions.productions_of(nonterminal))
+		{
+			if (!first)
+			{
+				out << "\n\t|";
+			}
+			first = false;
+			for (symbol_id symbol : productions.production(p))
+			{
+				out << ' ' << symbols.name(symbol);
+			}
+		}
+		out << " !\n";
+	}
+	out.flush();
+}
+
+void write_batch_summary(output_writer& out, const vector<batch_entry>& entries, const vector<batch_result>& results, const batch_stats& stats)
+{
+	out << "{\n  \"grammars\": " << to_string(entries.size()) << ",\n  \"failed\": " << to_string(stats.failed)
+		<< ",\n  \"in_flight\": " << to_string(stats.inFlight) << ",\n  \"seconds\": " << to_string(stats.seconds)
+		<< ",\n  \"peak_memory\": " << to_string(stats.peakMemory) << ",\n  \"results\": [";
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		const batch_entry& entry = entries[i];
+		const batch_result& result = results[i];
+		out << (i == 0 ? "\n    { \"grammar\": " : ",\n    { \"grammar\": ");
+		write_json_string(out, entry.grammar);
+		out << ", \"terminals\": ";
+		write_json_string(out, entry.terminals);
+		out << ", \"output\": ";
+		write_json_string(out, entry.output);
+		if (!result.error.empty())
+		{
+			out << ", \"error\": ";
+			write_json_string(out, result.error);
+			out << " }";
+			continue;
+		}
+		out << ", \"productions\": " << to_string(result.productions) << ", \"terminal_count\": " << to_string(result.terminals)
+			<< ", \"nonterminal_count\": " << to_string(result.nonterminals) << ", \"ll1_conflicts\": " << to_string(result.ll1Conflicts)
+			<< ", \"removed_productions\": " << to_string(result.removedProductions) << ", \"seconds\": " << to_string(result.seconds) << " }";
+	}
+	out << (entries.empty() ? "]\n}\n" : "\n  ]\n}\n");
+	out.flush();
+}
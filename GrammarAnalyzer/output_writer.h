@@ -0,0 +1,110 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+class grammar_analyzer;
+class lookahead_analysis;
+class lr0_automaton;
+class lr_table;
+struct batch_entry;
+struct batch_result;
+struct batch_stats;
+
+enum output_format
+{
+	OUTPUT_TEXT,		//the classic FnF_Sets_Output.txt report
+	OUTPUT_JSON,
+	OUTPUT_CSV
+};
+
+enum output_order
+{
+	ORDER_BY_ID,		//symbols in ID order, the terminals in a set in terminals file order
+	ORDER_BY_NAME		//everything sorted by name, byte wise
+};
+
+/*
+	Buffered output straight to a file descriptor. Text collects in a 1 MiB buffer that goes out in one
+	write() whenever it fills and on flush(), there is no per line flush and no locale or stream state on
+	the way. Either the writer opens the file itself or it is attached to a descriptor it doesn't own,
+	e.g. 1 for standard output.
+*/
+class output_writer
+{
+public:
+	output_writer() : buffer(BUFFER_SIZE) {}
+	~output_writer() { close(); }
+	output_writer(const output_writer&) = delete;
+	output_writer& operator=(const output_writer&) = delete;
+
+	//Creates or truncates path. Returns false and fills error if it can't.
+	bool open(const char* path, std::string& error);
+	void attach(int fd);
+	//Flushes, and closes the descriptor if open() opened it. Returns false if any write failed along the way.
+	bool close();
+	void flush();
+
+	output_writer& operator<<(std::string_view text)
+	{
+		if (text.size() > buffer.size() - used)
+		{
+			drain();
+			if (text.size() > buffer.size())
+			{
+				write_all(text.data(), text.size());
+				return *this;
+			}
+		}
+		text.copy(buffer.data() + used, text.size());
+		used += text.size();
+		return *this;
+	}
+	output_writer& operator<<(char c)
+	{
+		if (used == buffer.size())
+		{
+			drain();
+		}
+		buffer[used++] = c;
+		return *this;
+	}
+
+private:
+	static const size_t BUFFER_SIZE = (size_t)1 << 20;
+
+	void drain();
+	void write_all(const char* data, size_t size);
+
+	std::vector<char> buffer;
+	size_t used = 0;
+	int fd = -1;
+	bool owned = false;
+	bool failed = false;
+};
+
+//FIRST of every symbol, FOLLOW and FIRST+ of every nonterminal and the LL(1) conflicts of a computed
+//analyzer, in a canonical order: the same grammar always gives the same bytes.
+//	OUTPUT_TEXT		the sections of FnF_Sets_Output.txt
+//	OUTPUT_JSON		{ "first": { symbol: [terminals] }, "follow": ..., "first_plus": ..., "ll1_conflicts": [...] }
+//	OUTPUT_CSV		set,symbol,terminals,alternatives with the terminals space separated, one row per set and
+//					per conflict; alternatives is only filled in for conflicts
+void write_results(output_writer& out, const grammar_analyzer& analyzer, output_format format, output_order order);
+
+//FIRST_k and FOLLOW_k of every nonterminal and the LL(k) conflicts, as text in the layout of OUTPUT_TEXT.
+//A sequence is its terminals space separated, the sequences of a set are sorted terminal by terminal.
+void write_lookahead(output_writer& out, const grammar_analyzer& analyzer, const lookahead_analysis& lookahead, output_order order);
+
+//Size of an LR automaton and the conflicts of its table, as text in the layout of OUTPUT_TEXT. kind names
+//the table in the section headers, e.g. "SLR(1)".
+void write_lr_report(output_writer& out, const grammar_analyzer& analyzer, const lr0_automaton& automaton, const lr_table& table, std::string_view kind);
+
+
+//The loaded (or transformed) grammar in the format of the grammar file, one nonterminal after the other in
+//nonterminal order: "lhs ::= a b\n\t| c !\n". Loading it again gives the same productions.
+void write_grammar(output_writer& out, const grammar_analyzer& analyzer);
+
+//A batch run (see batch_analysis.h) as one JSON object: the totals of stats and one object per entry, in
+//entry order, with its paths and what came of it.
+void write_batch_summary(output_writer& out, const std::vector<batch_entry>& entries, const std::vector<batch_result>& results, const batch_stats& stats);
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstddef>
+
+//High water mark of the process' resident memory in bytes, 0 where the platform can't tell.
+//It never goes down, so benchmarks that want one figure per grammar should run the smallest first.
+size_t peak_memory_bytes();
+
+//User plus kernel time used by every thread of the process so far, in seconds.
+double process_cpu_seconds();
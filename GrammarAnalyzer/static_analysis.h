@@ -0,0 +1,423 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include <iterator>
+
+//One rule of a grammar embedded in C++, e.g. { "expr_p", "+ term expr_p" }. The RHS is split on blanks,
+//epsilon in it derives nothing and an empty RHS is an epsilon alternative.
+struct static_production
+{
+	std::string_view lhs;
+	std::string_view rhs;
+};
+
+//Fixed size set of terminal bits that can be built and read in a constant expression, which std::bitset
+//can't before C++23.
+template <size_t Bits>
+class static_set
+{
+public:
+	constexpr bool test(size_t bit) const { return ((words[bit / 64] >> (bit % 64)) & 1) != 0; }
+	constexpr void set(size_t bit) { words[bit / 64] |= 1ull << (bit % 64); }
+
+	//Adds other's bits, true if any of them was new.
+	constexpr bool unite(const static_set& other)
+	{
+		bool changed = false;
+		for (size_t i = 0; i < words.size(); i++)
+		{
+			uint64_t merged = words[i] | other.words[i];
+			changed |= merged != words[i];
+			words[i] = merged;
+		}
+		return changed;
+	}
+
+	constexpr bool intersects(const static_set& other) const
+	{
+		for (size_t i = 0; i < words.size(); i++)
+		{
+			if ((words[i] & other.words[i]) != 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	constexpr size_t count() const
+	{
+		size_t n = 0;
+		for (uint64_t w : words)
+		{
+			for (; w != 0; w &= w - 1)
+			{
+				n++;
+			}
+		}
+		return n;
+	}
+
+	constexpr bool operator==(const static_set& other) const
+	{
+		for (size_t i = 0; i < words.size(); i++)
+		{
+			if (words[i] != other.words[i])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+	constexpr bool operator!=(const static_set& other) const { return !(*this == other); }
+
+private:
+	std::array<uint64_t, (Bits + 63) / 64> words{};
+};
+
+namespace static_analysis_detail
+{
+	constexpr size_t NO_INDEX = ~(size_t)0;
+
+	constexpr bool is_blank(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+	}
+
+	//The next blank separated word of text from pos on, empty once there is none. pos ends up past it.
+	constexpr std::string_view next_word(std::string_view text, size_t& pos)
+	{
+		while (pos < text.size() && is_blank(text[pos]))
+		{
+			pos++;
+		}
+		size_t from = pos;
+		while (pos < text.size() && !is_blank(text[pos]))
+		{
+			pos++;
+		}
+		return text.substr(from, pos - from);
+	}
+
+	template <size_t Count>
+	constexpr size_t find(const std::array<std::string_view, Count>& names, std::string_view name, size_t end = Count)
+	{
+		for (size_t i = 0; i < end; i++)
+		{
+			if (names[i] == name)
+			{
+				return i;
+			}
+		}
+		return NO_INDEX;
+	}
+
+	template <size_t P>
+	constexpr size_t count_rhs_symbols(const static_production (&productions)[P])
+	{
+		size_t count = 0;
+		for (const static_production& production : productions)
+		{
+			size_t pos = 0;
+			for (std::string_view word = next_word(production.rhs, pos); !word.empty(); word = next_word(production.rhs, pos))
+			{
+				count += word != "epsilon";
+			}
+		}
+		return count;
+	}
+
+	template <size_t P>
+	constexpr size_t count_nonterminals(const static_production (&productions)[P])
+	{
+		size_t count = 0;
+		for (size_t p = 0; p < P; p++)
+		{
+			bool seen = false;
+			for (size_t q = 0; q < p && !seen; q++)
+			{
+				seen = productions[q].lhs == productions[p].lhs;
+			}
+			count += !seen;
+		}
+		return count;
+	}
+
+	//Every RHS symbol without epsilon, production by production.
+	template <size_t P, size_t R>
+	struct rhs_words
+	{
+		std::array<std::string_view, R> rhs{};
+		std::array<uint32_t, P + 1> rhsStart{};
+	};
+
+	template <size_t P, size_t R>
+	constexpr rhs_words<P, R> split(const static_production (&productions)[P])
+	{
+		rhs_words<P, R> words{};
+		size_t count = 0;
+		for (size_t p = 0; p < P; p++)
+		{
+			words.rhsStart[p] = (uint32_t)count;
+			size_t pos = 0;
+			for (std::string_view word = next_word(productions[p].rhs, pos); !word.empty(); word = next_word(productions[p].rhs, pos))
+			{
+				if (word != "epsilon")
+				{
+					words.rhs[count++] = word;
+				}
+			}
+		}
+		words.rhsStart[P] = (uint32_t)count;
+		return words;
+	}
+
+	//epsilon and every distinct RHS word that isn't some production's LHS.
+	template <size_t P, size_t R>
+	constexpr size_t count_terminals(const static_production (&productions)[P], const rhs_words<P, R>& words)
+	{
+		size_t count = 1;
+		for (size_t i = 0; i < R; i++)
+		{
+			bool seen = false;
+			for (size_t p = 0; p < P && !seen; p++)
+			{
+				seen = productions[p].lhs == words.rhs[i];
+			}
+			seen = seen || find(words.rhs, words.rhs[i], i) != NO_INDEX;
+			count += !seen;
+		}
+		return count;
+	}
+
+	template <size_t P, size_t R, size_t N, size_t T>
+	struct tables
+	{
+		std::array<std::string_view, N> nonterminalNames{};
+		std::array<std::string_view, T> terminalNames{};
+		std::array<size_t, P> lhs{};
+		//RHS symbols as nonterminal index, or N + terminal bit.
+		std::array<size_t, R> rhs{};
+		std::array<bool, N> nullable{};
+		std::array<static_set<T>, N> first{};
+		std::array<static_set<T>, N> follow{};
+		std::array<static_set<T>, P> firstPlus{};
+		bool ll1 = true;
+	};
+
+	template <size_t P, size_t R, size_t N, size_t T>
+	constexpr tables<P, R, N, T> build(const static_production (&productions)[P], const rhs_words<P, R>& words)
+	{
+		typedef static_set<T> set_type;
+		tables<P, R, N, T> t{};
+		size_t nonterminals = 0;
+		for (size_t p = 0; p < P; p++)
+		{
+			size_t nt = find(t.nonterminalNames, productions[p].lhs, nonterminals);
+			if (nt == NO_INDEX)
+			{
+				nt = nonterminals;
+				t.nonterminalNames[nonterminals++] = productions[p].lhs;
+			}
+			t.lhs[p] = nt;
+		}
+		size_t terminals = 1;
+		t.terminalNames[0] = "epsilon";
+		for (size_t i = 0; i < R; i++)
+		{
+			size_t nt = find(t.nonterminalNames, words.rhs[i]);
+			if (nt != NO_INDEX)
+			{
+				t.rhs[i] = nt;
+				continue;
+			}
+			size_t bit = find(t.terminalNames, words.rhs[i], terminals);
+			if (bit == NO_INDEX)
+			{
+				bit = terminals;
+				t.terminalNames[terminals++] = words.rhs[i];
+			}
+			t.rhs[i] = N + bit;
+		}
+
+		for (bool changed = true; changed;)
+		{
+			changed = false;
+			for (size_t p = 0; p < P; p++)
+			{
+				bool vanishes = !t.nullable[t.lhs[p]];
+				for (size_t i = words.rhsStart[p]; i < words.rhsStart[p + 1] && vanishes; i++)
+				{
+					vanishes = t.rhs[i] < N && t.nullable[t.rhs[i]];
+				}
+				if (vanishes)
+				{
+					t.nullable[t.lhs[p]] = true;
+					changed = true;
+				}
+			}
+		}
+
+		//FIRST without epsilon until FOLLOW and FIRST+ are done with it.
+		for (bool changed = true; changed;)
+		{
+			changed = false;
+			for (size_t p = 0; p < P; p++)
+			{
+				set_type& first = t.first[t.lhs[p]];
+				for (size_t i = words.rhsStart[p]; i < words.rhsStart[p + 1]; i++)
+				{
+					size_t symbol = t.rhs[i];
+					if (symbol >= N)
+					{
+						if (!first.test(symbol - N))
+						{
+							first.set(symbol - N);
+							changed = true;
+						}
+						break;
+					}
+					changed |= first.unite(t.first[symbol]);
+					if (!t.nullable[symbol])
+					{
+						break;
+					}
+				}
+			}
+		}
+
+		size_t goal = find(t.nonterminalNames, "goal");
+		size_t eof = find(t.terminalNames, "$");
+		if (goal != NO_INDEX && eof != NO_INDEX)
+		{
+			t.follow[goal].set(eof);
+		}
+		for (bool changed = true; changed;)
+		{
+			changed = false;
+			for (size_t p = 0; p < P; p++)
+			{
+				//What can come after position i, walking the RHS back to front.
+				set_type trailer = t.follow[t.lhs[p]];
+				for (size_t i = words.rhsStart[p + 1]; i-- > words.rhsStart[p];)
+				{
+					size_t symbol = t.rhs[i];
+					if (symbol >= N)
+					{
+						trailer = set_type();
+						trailer.set(symbol - N);
+						continue;
+					}
+					changed |= t.follow[symbol].unite(trailer);
+					if (!t.nullable[symbol])
+					{
+						trailer = set_type();
+					}
+					trailer.unite(t.first[symbol]);
+				}
+			}
+		}
+
+		for (size_t p = 0; p < P; p++)
+		{
+			set_type& firstPlus = t.firstPlus[p];
+			bool vanishes = true;
+			for (size_t i = words.rhsStart[p]; i < words.rhsStart[p + 1] && vanishes; i++)
+			{
+				size_t symbol = t.rhs[i];
+				if (symbol >= N)
+				{
+					firstPlus.set(symbol - N);
+					vanishes = false;
+				}
+				else
+				{
+					firstPlus.unite(t.first[symbol]);
+					vanishes = t.nullable[symbol];
+				}
+			}
+			if (vanishes)
+			{
+				firstPlus.unite(t.follow[t.lhs[p]]);
+			}
+			for (size_t q = 0; q < p; q++)
+			{
+				if (t.lhs[q] == t.lhs[p] && t.firstPlus[q].intersects(firstPlus))
+				{
+					t.ll1 = false;
+				}
+			}
+		}
+
+		for (size_t nt = 0; nt < N; nt++)
+		{
+			if (t.nullable[nt])
+			{
+				t.first[nt].set(0);
+			}
+		}
+		return t;
+	}
+}
+
+/*
+	FIRST, FOLLOW and FIRST+ of a grammar known at compile time, for small grammars embedded in a parser
+	so the analysis costs nothing at run time:
+
+		constexpr static_production expression[] = { { "goal", "expr $" }, { "expr", "term expr_p" }, ... };
+		typedef static_analysis<expression> expression_sets;
+		static_assert(expression_sets::ll1(), "expression grammar isn't LL(1)");
+		constexpr bool plus = expression_sets::first_plus(2).test(expression_sets::terminal("+"));
+
+	It follows grammar_analyzer's conventions so the results can be compared name by name: a symbol is a
+	nonterminal if it has a production, everything else is a terminal, FIRST of a nullable nonterminal has
+	epsilon, FIRST+ never has it and FOLLOW(goal) has $ if both appear in the grammar. Terminal bit 0 is
+	always epsilon, the rest and the nonterminals are numbered in order of first appearance, productions
+	keep the order of the array.
+
+	The sets are solved by plain iteration to a fixed point, which for the few dozen rules this is meant
+	for is cheaper to evaluate at compile time than grammar_analyzer's SCC solver would be. Every table is a
+	static constexpr member: the compiler works it out and it only ends up in the binary if a query needs it
+	at run time. Only needs C++17. The Lua grammar in First_and_Follow_sets (119 productions) stays within
+	GCC's default constexpr limits and takes it about 2 seconds.
+*/
+template <const auto& Productions>
+class static_analysis
+{
+	static constexpr size_t P = std::size(Productions);
+	static constexpr size_t R = static_analysis_detail::count_rhs_symbols(Productions);
+	static constexpr size_t N = static_analysis_detail::count_nonterminals(Productions);
+	static constexpr static_analysis_detail::rhs_words<P, R> words = static_analysis_detail::split<P, R>(Productions);
+
+public:
+	static constexpr size_t T = static_analysis_detail::count_terminals(Productions, words);
+	typedef static_set<T> set_type;
+	static constexpr size_t NO_INDEX = static_analysis_detail::NO_INDEX;
+
+	static constexpr size_t production_count() { return P; }
+	static constexpr size_t nonterminal_count() { return N; }
+	static constexpr size_t terminal_count() { return T; }
+
+	static constexpr std::string_view nonterminal_name(size_t nt) { return data.nonterminalNames[nt]; }
+	static constexpr std::string_view terminal_name(size_t bit) { return data.terminalNames[bit]; }
+	//Index or bit of name, NO_INDEX if the grammar has no such nonterminal or terminal.
+	static constexpr size_t nonterminal(std::string_view name) { return static_analysis_detail::find(data.nonterminalNames, name); }
+	static constexpr size_t terminal(std::string_view name) { return static_analysis_detail::find(data.terminalNames, name); }
+	//The nonterminal production p is for.
+	static constexpr size_t lhs(size_t p) { return data.lhs[p]; }
+
+	static constexpr bool nullable(size_t nt) { return data.nullable[nt]; }
+	//FIRST of a nonterminal, with epsilon if it is nullable.
+	static constexpr const set_type& first(size_t nt) { return data.first[nt]; }
+	static constexpr const set_type& follow(size_t nt) { return data.follow[nt]; }
+	//FIRST+ of a single production.
+	static constexpr const set_type& first_plus(size_t p) { return data.firstPlus[p]; }
+	//True if no two alternatives of a nonterminal have overlapping FIRST+ sets.
+	static constexpr bool ll1() { return data.ll1; }
+
+private:
+	static constexpr static_analysis_detail::tables<P, R, N, T> data = static_analysis_detail::build<P, R, N, T>(Productions, words);
+};
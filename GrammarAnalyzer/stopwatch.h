@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+
+#include "analysis_stats.h"
+#include "process_stats.h"
+
+//Wall clock and process CPU timer for the phase timings, started when it is constructed.
+class stopwatch
+{
+public:
+	stopwatch() : start(std::chrono::steady_clock::now()), cpuStart(process_cpu_seconds()) {}
+
+	double seconds() const
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	//Time since the last lap (or construction), and starts the next one.
+	phase_time lap()
+	{
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		double cpuNow = process_cpu_seconds();
+		phase_time elapsed;
+		elapsed.wall = std::chrono::duration<double>(now - start).count();
+		elapsed.cpu = cpuNow - cpuStart;
+		start = now;
+		cpuStart = cpuNow;
+		return elapsed;
+	}
+
+private:
+	std::chrono::steady_clock::time_point start;
+	double cpuStart;
+};
@@ -0,0 +1,75 @@
+#include "symbol_table.h"
+
+using namespace std;
+
+symbol_id symbol_table::intern(string_view value, symbol_type type)
+{
+	lookupCount++;
+	auto found = lookup.find(value);
+	if (found != lookup.end())
+	{
+		symbol_id id = found->second;
+		if (types[id] == UNKNOWN && type != UNKNOWN)
+		{
+			types[id] = type;
+			assign_slot(id, type);
+		}
+		return id;
+	}
+
+	symbol_id id = (symbol_id)names.size();
+	names.emplace_back(value);
+	types.push_back(type);
+	slots.push_back(NO_SYMBOL);
+	lookup.emplace(string_view(names.back()), id);
+	assign_slot(id, type);
+
+	if (value == "epsilon")
+	{
+		epsilon = id;
+	}
+	else if (value == "$")
+	{
+		eof = id;
+	}
+	else if (value == "goal")
+	{
+		goal = id;
+	}
+	return id;
+}
+
+symbol_id symbol_table::find(string_view value) const
+{
+	lookupCount++;
+	auto found = lookup.find(value);
+	return (found == lookup.end()) ? NO_SYMBOL : found->second;
+}
+
+void symbol_table::clear()
+{
+	lookup.clear();
+	names.clear();
+	types.clear();
+	slots.clear();
+	terminalIDs.clear();
+	nonterminalIDs.clear();
+	epsilon = NO_SYMBOL;
+	eof = NO_SYMBOL;
+	goal = NO_SYMBOL;
+	lookupCount = 0;
+}
+
+void symbol_table::assign_slot(symbol_id id, symbol_type type)
+{
+	if (type == TERMINAL)
+	{
+		slots[id] = (uint32_t)terminalIDs.size();
+		terminalIDs.push_back(id);
+	}
+	else if (type == NONTERMINAL)
+	{
+		slots[id] = (uint32_t)nonterminalIDs.size();
+		nonterminalIDs.push_back(id);
+	}
+}
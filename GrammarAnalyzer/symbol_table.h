@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <cstdint>
+
+//Every terminal and nonterminal is interned exactly once, at load time, and is referred to by its
+//dense ID from then on. Strings are only looked at again when printing.
+typedef uint32_t symbol_id;
+
+const symbol_id NO_SYMBOL = 0xFFFFFFFF;
+
+//Same values as the old grammar_element::type field.
+enum symbol_type
+{
+	TERMINAL = 0,
+	NONTERMINAL = 1,
+	UNKNOWN = 2
+};
+
+class symbol_table
+{
+public:
+	//The keys of lookup point into names, so a copy would look up in the source's strings. Moves keep
+	//them valid, a moved deque keeps its nodes.
+	symbol_table() = default;
+	symbol_table(const symbol_table&) = delete;
+	symbol_table& operator=(const symbol_table&) = delete;
+	symbol_table(symbol_table&&) = default;
+	symbol_table& operator=(symbol_table&&) = default;
+
+	//Returns the ID of value, adding it if it has not been seen yet. value is only copied the first time,
+	//so loaders can pass views straight into their input buffer.
+	//An UNKNOWN symbol is promoted once its real type is known (e.g. a RHS symbol later defined as a LHS).
+	symbol_id intern(std::string_view value, symbol_type type);
+
+	//Returns NO_SYMBOL if value was never interned.
+	symbol_id find(std::string_view value) const;
+
+	//Forgets every symbol, so the table can be reused for another grammar.
+	void clear();
+
+	const std::string& name(symbol_id id) const { return names[id]; }
+	symbol_type type(symbol_id id) const { return types[id]; }
+	bool isTerminal(symbol_id id) const { return types[id] == TERMINAL; }
+	bool isNonterminal(symbol_id id) const { return types[id] == NONTERMINAL; }
+
+	//Dense position of a symbol among the symbols of its own type, used to index per-terminal
+	//and per-nonterminal tables. Only valid for TERMINAL and NONTERMINAL symbols.
+	uint32_t index(symbol_id id) const { return slots[id]; }
+
+	size_t size() const { return names.size(); }
+	//Hash lookups done by intern and find since construction or clear(), for the instrumentation.
+	uint64_t lookups() const { return lookupCount; }
+	const std::vector<symbol_id>& terminals() const { return terminalIDs; }
+	const std::vector<symbol_id>& nonterminals() const { return nonterminalIDs; }
+
+	//Well known symbols, NO_SYMBOL until they are interned.
+	symbol_id epsilon = NO_SYMBOL;
+	symbol_id eof = NO_SYMBOL;
+	symbol_id goal = NO_SYMBOL;
+
+private:
+	void assign_slot(symbol_id id, symbol_type type);
+
+	//A deque never moves its elements, so the keys of lookup can point into the stored names.
+	std::deque<std::string> names;
+	std::vector<symbol_type> types;
+	std::vector<uint32_t> slots;
+	std::vector<symbol_id> terminalIDs;
+	std::vector<symbol_id> nonterminalIDs;
+	std::unordered_map<std::string_view, symbol_id> lookup;
+	mutable uint64_t lookupCount = 0;
+};
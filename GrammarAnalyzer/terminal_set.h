@@ -0,0 +1,456 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+//Pick the widest union kernel the compiler is allowed to emit, falling back to plain 64-bit words.
+#if defined(__AVX2__)
+#define TERMINAL_SET_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TERMINAL_SET_SSE2
+#include <emmintrin.h>
+#endif
+
+//4 x 64 bits = one AVX2 register. Set storage is padded to whole blocks so the SIMD loops have no scalar tail.
+const size_t TERMINAL_SET_WORDS_PER_BLOCK = 4;
+
+inline size_t terminal_set_words(size_t terminal_count)
+{
+	return ((terminal_count + 255) / 256) * TERMINAL_SET_WORDS_PER_BLOCK;
+}
+
+inline size_t terminal_set_popcount(uint64_t w)
+{
+#if defined(__GNUC__)
+	return (size_t)__builtin_popcountll(w);
+#else
+	size_t n = 0;
+	for (; w != 0; w &= w - 1)
+	{
+		n++;
+	}
+	return n;
+#endif
+}
+
+//w must not be zero.
+inline size_t terminal_set_ctz(uint64_t w)
+{
+#if defined(__GNUC__)
+	return (size_t)__builtin_ctzll(w);
+#else
+	size_t n = 0;
+	while ((w & 1) == 0)
+	{
+		w >>= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+class terminal_set;
+
+/*
+	Read-only window onto terminal set bits stored elsewhere, either a terminal_set or one row of a
+	terminal_set_array. Cheap to copy, only valid while the storage it points into is alive.
+*/
+class terminal_set_view
+{
+public:
+	terminal_set_view(const uint64_t* w, size_t terminal_count) : words(w), bitCount(terminal_count) {}
+	terminal_set_view(const terminal_set& set);
+
+	size_t size() const { return bitCount; }
+	size_t word_count() const { return terminal_set_words(bitCount); }
+	bool test(size_t bit) const { return (words[bit >> 6] >> (bit & 63)) & 1; }
+
+	bool empty() const
+	{
+		for (size_t i = 0; i < word_count(); i++)
+		{
+			if (words[i] != 0)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	size_t count() const
+	{
+		size_t total = 0;
+		for (size_t i = 0; i < word_count(); i++)
+		{
+			total += terminal_set_popcount(words[i]);
+		}
+		return total;
+	}
+
+	//(this & other) != 0
+	bool intersects(const terminal_set_view& other) const;
+
+	//Iterates the set bits in increasing order: for (size_t bit : set) { ... }
+	class iterator
+	{
+	public:
+		iterator(const uint64_t* w, size_t count, size_t b) : words(w), bitCount(count), bit(b) { advance(); }
+		size_t operator*() const { return bit; }
+		iterator& operator++() { bit++; advance(); return *this; }
+		bool operator!=(const iterator& other) const { return bit != other.bit; }
+	private:
+		void advance()
+		{
+			while (bit < bitCount)
+			{
+				uint64_t w = words[bit >> 6] >> (bit & 63);
+				if (w != 0)
+				{
+					bit += terminal_set_ctz(w);
+					return;
+				}
+				bit = (bit | 63) + 1;
+			}
+			bit = bitCount;
+		}
+		const uint64_t* words;
+		size_t bitCount;
+		size_t bit;
+	};
+	iterator begin() const { return iterator(words, bitCount, 0); }
+	iterator end() const { return iterator(words, bitCount, bitCount); }
+
+	const uint64_t* words;
+	size_t bitCount;
+};
+
+/*
+	Fixed-width set of terminals, one bit per terminal (bit = symbol_table::index of the terminal).
+	Every set used in one analysis is created with the same terminal count, so the binary operations
+	below never have to deal with mismatched widths.
+
+	The mutating operations return true if they changed the set, which is what the fixpoint
+	loops in the FIRST/FOLLOW passes need. Their operands can be any set or view of the same width.
+*/
+class terminal_set
+{
+public:
+	static const size_t WORDS_PER_BLOCK = TERMINAL_SET_WORDS_PER_BLOCK;
+
+	terminal_set() {}
+	explicit terminal_set(size_t terminal_count)
+		: bitCount(terminal_count), words(terminal_set_words(terminal_count), 0)
+	{
+	}
+	explicit terminal_set(const terminal_set_view& view)
+		: bitCount(view.bitCount), words(view.words, view.words + view.word_count())
+	{
+	}
+
+	size_t size() const { return bitCount; }
+
+	bool test(size_t bit) const { return (words[bit >> 6] >> (bit & 63)) & 1; }
+	void set(size_t bit) { words[bit >> 6] |= (uint64_t)1 << (bit & 63); }
+	void reset(size_t bit) { words[bit >> 6] &= ~((uint64_t)1 << (bit & 63)); }
+	void clear() { for (auto& w : words) w = 0; }
+	//Makes room for terminals declared after the set was created, the new bits start out clear.
+	void resize(size_t terminal_count)
+	{
+		bitCount = terminal_count;
+		words.resize(terminal_set_words(terminal_count), 0);
+	}
+
+	bool empty() const { return terminal_set_view(*this).empty(); }
+	size_t count() const { return terminal_set_view(*this).count(); }
+
+	bool operator==(const terminal_set& other) const { return words == other.words; }
+	bool operator!=(const terminal_set& other) const { return words != other.words; }
+
+	//this |= other
+	bool unite(const terminal_set_view& other);
+	//this |= (other & ~excluded), e.g. FIRST(b) without epsilon.
+	bool unite_difference(const terminal_set_view& other, const terminal_set_view& excluded);
+	//this &= ~other
+	bool subtract(const terminal_set_view& other);
+	//this &= other
+	bool intersect(const terminal_set_view& other);
+	//(this & other) != 0
+	bool intersects(const terminal_set_view& other) const { return terminal_set_view(*this).intersects(other); }
+
+	typedef terminal_set_view::iterator iterator;
+	iterator begin() const { return terminal_set_view(*this).begin(); }
+	iterator end() const { return terminal_set_view(*this).end(); }
+
+	const uint64_t* data() const { return words.data(); }
+	size_t word_count() const { return words.size(); }
+	size_t byte_size() const { return words.size() * sizeof(uint64_t); }
+
+private:
+	size_t bitCount = 0;
+	std::vector<uint64_t> words;
+};
+
+inline terminal_set_view::terminal_set_view(const terminal_set& set)
+	: words(set.data()), bitCount(set.size())
+{
+}
+
+/*
+	Many terminal sets of the same width stored back to back in a single allocation, e.g. one set per
+	RHS position of every production. Rows are read through views and written by copying a set in.
+*/
+class terminal_set_array
+{
+public:
+	terminal_set_array() {}
+	terminal_set_array(size_t terminal_count, size_t rows)
+		: bitCount(terminal_count), stride(terminal_set_words(terminal_count)), rowCount(rows), words(rows * stride, 0)
+	{
+	}
+
+	//rows sets stored back to back at source, terminal_set_words(terminal_count) words each.
+	terminal_set_array(size_t terminal_count, size_t rows, const uint64_t* source)
+		: bitCount(terminal_count), stride(terminal_set_words(terminal_count)), rowCount(rows), words(source, source + rows * stride)
+	{
+	}
+
+	size_t size() const { return rowCount; }
+	size_t byte_size() const { return words.size() * sizeof(uint64_t); }
+	const uint64_t* data() const { return words.data(); }
+	terminal_set_view operator[](size_t row) const { return terminal_set_view(words.data() + row * stride, bitCount); }
+
+	void store(size_t row, const terminal_set& set)
+	{
+		const uint64_t* src = set.data();
+		for (size_t i = 0; i < stride; i++)
+		{
+			words[row * stride + i] = src[i];
+		}
+	}
+
+private:
+	size_t bitCount = 0;
+	size_t stride = 0;
+	size_t rowCount = 0;
+	std::vector<uint64_t> words;
+};
+
+#if defined(TERMINAL_SET_AVX2)
+
+inline bool terminal_set::unite(const terminal_set_view& other)
+{
+	__m256i changed = _mm256_setzero_si256();
+	for (size_t i = 0; i < words.size(); i += WORDS_PER_BLOCK)
+	{
+		__m256i* dst = (__m256i*)&words[i];
+		__m256i a = _mm256_loadu_si256(dst);
+		__m256i r = _mm256_or_si256(a, _mm256_loadu_si256((const __m256i*)&other.words[i]));
+		changed = _mm256_or_si256(changed, _mm256_xor_si256(a, r));
+		_mm256_storeu_si256(dst, r);
+	}
+	return !_mm256_testz_si256(changed, changed);
+}
+
+inline bool terminal_set::unite_difference(const terminal_set_view& other, const terminal_set_view& excluded)
+{
+	__m256i changed = _mm256_setzero_si256();
+	for (size_t i = 0; i < words.size(); i += WORDS_PER_BLOCK)
+	{
+		__m256i* dst = (__m256i*)&words[i];
+		__m256i a = _mm256_loadu_si256(dst);
+		__m256i add = _mm256_andnot_si256(_mm256_loadu_si256((const __m256i*)&excluded.words[i]),
+			_mm256_loadu_si256((const __m256i*)&other.words[i]));
+		__m256i r = _mm256_or_si256(a, add);
+		changed = _mm256_or_si256(changed, _mm256_xor_si256(a, r));
+		_mm256_storeu_si256(dst, r);
+	}
+	return !_mm256_testz_si256(changed, changed);
+}
+
+inline bool terminal_set::subtract(const terminal_set_view& other)
+{
+	__m256i changed = _mm256_setzero_si256();
+	for (size_t i = 0; i < words.size(); i += WORDS_PER_BLOCK)
+	{
+		__m256i* dst = (__m256i*)&words[i];
+		__m256i a = _mm256_loadu_si256(dst);
+		__m256i r = _mm256_andnot_si256(_mm256_loadu_si256((const __m256i*)&other.words[i]), a);
+		changed = _mm256_or_si256(changed, _mm256_xor_si256(a, r));
+		_mm256_storeu_si256(dst, r);
+	}
+	return !_mm256_testz_si256(changed, changed);
+}
+
+inline bool terminal_set::intersect(const terminal_set_view& other)
+{
+	__m256i changed = _mm256_setzero_si256();
+	for (size_t i = 0; i < words.size(); i += WORDS_PER_BLOCK)
+	{
+		__m256i* dst = (__m256i*)&words[i];
+		__m256i a = _mm256_loadu_si256(dst);
+		__m256i r = _mm256_and_si256(a, _mm256_loadu_si256((const __m256i*)&other.words[i]));
+		changed = _mm256_or_si256(changed, _mm256_xor_si256(a, r));
+		_mm256_storeu_si256(dst, r);
+	}
+	return !_mm256_testz_si256(changed, changed);
+}
+
+inline bool terminal_set_view::intersects(const terminal_set_view& other) const
+{
+	for (size_t i = 0; i < word_count(); i += TERMINAL_SET_WORDS_PER_BLOCK)
+	{
+		__m256i a = _mm256_loadu_si256((const __m256i*)&words[i]);
+		__m256i b = _mm256_loadu_si256((const __m256i*)&other.words[i]);
+		if (!_mm256_testz_si256(a, b))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+#elif defined(TERMINAL_SET_SSE2)
+
+//SSE2 has no ptest, a block is unchanged when every byte of the xor compares equal to zero.
+inline bool terminal_set_sse2_nonzero(__m128i v)
+{
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) != 0xFFFF;
+}
+
+inline bool terminal_set::unite(const terminal_set_view& other)
+{
+	__m128i changed = _mm_setzero_si128();
+	for (size_t i = 0; i < words.size(); i += 2)
+	{
+		__m128i* dst = (__m128i*)&words[i];
+		__m128i a = _mm_loadu_si128(dst);
+		__m128i r = _mm_or_si128(a, _mm_loadu_si128((const __m128i*)&other.words[i]));
+		changed = _mm_or_si128(changed, _mm_xor_si128(a, r));
+		_mm_storeu_si128(dst, r);
+	}
+	return terminal_set_sse2_nonzero(changed);
+}
+
+inline bool terminal_set::unite_difference(const terminal_set_view& other, const terminal_set_view& excluded)
+{
+	__m128i changed = _mm_setzero_si128();
+	for (size_t i = 0; i < words.size(); i += 2)
+	{
+		__m128i* dst = (__m128i*)&words[i];
+		__m128i a = _mm_loadu_si128(dst);
+		__m128i add = _mm_andnot_si128(_mm_loadu_si128((const __m128i*)&excluded.words[i]),
+			_mm_loadu_si128((const __m128i*)&other.words[i]));
+		__m128i r = _mm_or_si128(a, add);
+		changed = _mm_or_si128(changed, _mm_xor_si128(a, r));
+		_mm_storeu_si128(dst, r);
+	}
+	return terminal_set_sse2_nonzero(changed);
+}
+
+inline bool terminal_set::subtract(const terminal_set_view& other)
+{
+	__m128i changed = _mm_setzero_si128();
+	for (size_t i = 0; i < words.size(); i += 2)
+	{
+		__m128i* dst = (__m128i*)&words[i];
+		__m128i a = _mm_loadu_si128(dst);
+		__m128i r = _mm_andnot_si128(_mm_loadu_si128((const __m128i*)&other.words[i]), a);
+		changed = _mm_or_si128(changed, _mm_xor_si128(a, r));
+		_mm_storeu_si128(dst, r);
+	}
+	return terminal_set_sse2_nonzero(changed);
+}
+
+inline bool terminal_set::intersect(const terminal_set_view& other)
+{
+	__m128i changed = _mm_setzero_si128();
+	for (size_t i = 0; i < words.size(); i += 2)
+	{
+		__m128i* dst = (__m128i*)&words[i];
+		__m128i a = _mm_loadu_si128(dst);
+		__m128i r = _mm_and_si128(a, _mm_loadu_si128((const __m128i*)&other.words[i]));
+		changed = _mm_or_si128(changed, _mm_xor_si128(a, r));
+		_mm_storeu_si128(dst, r);
+	}
+	return terminal_set_sse2_nonzero(changed);
+}
+
+inline bool terminal_set_view::intersects(const terminal_set_view& other) const
+{
+	for (size_t i = 0; i < word_count(); i += 2)
+	{
+		__m128i a = _mm_loadu_si128((const __m128i*)&words[i]);
+		__m128i b = _mm_loadu_si128((const __m128i*)&other.words[i]);
+		if (terminal_set_sse2_nonzero(_mm_and_si128(a, b)))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+#else
+
+inline bool terminal_set::unite(const terminal_set_view& other)
+{
+	uint64_t changed = 0;
+	for (size_t i = 0; i < words.size(); i++)
+	{
+		uint64_t r = words[i] | other.words[i];
+		changed |= r ^ words[i];
+		words[i] = r;
+	}
+	return changed != 0;
+}
+
+inline bool terminal_set::unite_difference(const terminal_set_view& other, const terminal_set_view& excluded)
+{
+	uint64_t changed = 0;
+	for (size_t i = 0; i < words.size(); i++)
+	{
+		uint64_t r = words[i] | (other.words[i] & ~excluded.words[i]);
+		changed |= r ^ words[i];
+		words[i] = r;
+	}
+	return changed != 0;
+}
+
+inline bool terminal_set::subtract(const terminal_set_view& other)
+{
+	uint64_t changed = 0;
+	for (size_t i = 0; i < words.size(); i++)
+	{
+		uint64_t r = words[i] & ~other.words[i];
+		changed |= r ^ words[i];
+		words[i] = r;
+	}
+	return changed != 0;
+}
+
+inline bool terminal_set::intersect(const terminal_set_view& other)
+{
+	uint64_t changed = 0;
+	for (size_t i = 0; i < words.size(); i++)
+	{
+		uint64_t r = words[i] & other.words[i];
+		changed |= r ^ words[i];
+		words[i] = r;
+	}
+	return changed != 0;
+}
+
+inline bool terminal_set_view::intersects(const terminal_set_view& other) const
+{
+	for (size_t i = 0; i < word_count(); i++)
+	{
+		if ((words[i] & other.words[i]) != 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+#endif
@@ -0,0 +1,139 @@
+#include "thread_pool.h"
+
+using namespace std;
+
+thread_pool::thread_pool(size_t threads)
+{
+	if (threads == 0)
+	{
+		threads = thread::hardware_concurrency();
+		if (threads == 0)
+		{
+			threads = 1;
+		}
+	}
+	for (size_t i = 0; i < threads; i++)
+	{
+		queues.push_back(unique_ptr<work_queue>(new work_queue()));
+	}
+	for (size_t i = 1; i < threads; i++)
+	{
+		workers.emplace_back(&thread_pool::worker, this, i);
+	}
+}
+
+thread_pool::~thread_pool()
+{
+	{
+		lock_guard<mutex> guard(stateLock);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (thread& t : workers)
+	{
+		t.join();
+	}
+}
+
+void thread_pool::parallel_for(size_t count, const function<void(size_t, size_t)>& body, size_t min_parallel)
+{
+	if (count == 0)
+	{
+		return;
+	}
+	if (queues.size() == 1 || count < min_parallel)
+	{
+		body(0, count);
+		return;
+	}
+
+	//A few chunks per thread leaves something to steal when the work is uneven.
+	size_t chunk_count = queues.size() * 4;
+	if (chunk_count > count)
+	{
+		chunk_count = count;
+	}
+	size_t chunk_size = (count + chunk_count - 1) / chunk_count;
+	chunk_count = (count + chunk_size - 1) / chunk_size;
+
+	job = &body;
+	pending = chunk_count;
+	for (size_t c = 0; c < chunk_count; c++)
+	{
+		size_t begin = c * chunk_size;
+		size_t end = (begin + chunk_size < count) ? begin + chunk_size : count;
+		work_queue& queue = *queues[c % queues.size()];
+		lock_guard<mutex> guard(queue.lock);
+		queue.chunks.push_back({ begin, end });
+	}
+	{
+		lock_guard<mutex> guard(stateLock);
+		generation++;
+	}
+	wake.notify_all();
+
+	drain(0);
+
+	unique_lock<mutex> guard(stateLock);
+	finished.wait(guard, [this] { return pending == 0; });
+	job = nullptr;
+}
+
+//Own queue from the back, everybody else's from the front.
+bool thread_pool::take(size_t self, chunk& out)
+{
+	{
+		work_queue& own = *queues[self];
+		lock_guard<mutex> guard(own.lock);
+		if (!own.chunks.empty())
+		{
+			out = own.chunks.back();
+			own.chunks.pop_back();
+			return true;
+		}
+	}
+	for (size_t i = 1; i < queues.size(); i++)
+	{
+		work_queue& victim = *queues[(self + i) % queues.size()];
+		lock_guard<mutex> guard(victim.lock);
+		if (!victim.chunks.empty())
+		{
+			out = victim.chunks.front();
+			victim.chunks.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+void thread_pool::drain(size_t self)
+{
+	chunk next;
+	while (take(self, next))
+	{
+		(*job)(next.begin, next.end);
+		if (pending.fetch_sub(1) == 1)
+		{
+			lock_guard<mutex> guard(stateLock);
+			finished.notify_all();
+		}
+	}
+}
+
+void thread_pool::worker(size_t self)
+{
+	uint64_t seen = 0;
+	for (;;)
+	{
+		{
+			unique_lock<mutex> guard(stateLock);
+			wake.wait(guard, [&] { return stopping || generation != seen; });
+			if (stopping)
+			{
+				return;
+			}
+			seen = generation;
+		}
+		drain(self);
+	}
+}
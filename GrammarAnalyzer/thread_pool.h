@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+/*
+	Small work-stealing pool for data parallel loops.
+
+	parallel_for cuts [0, count) into chunks and deals them out round robin to one queue per thread.
+	Each thread works through its own queue from the back and, once it is empty, steals from the front
+	of the others, so uneven chunks (e.g. one huge SCC next to many tiny ones) still balance out.
+	The calling thread takes part as thread 0, so a pool of size 1 has no workers and runs everything inline.
+	parallel_for must not be called from inside a body.
+*/
+class thread_pool
+{
+public:
+	//threads == 0 uses every hardware thread.
+	explicit thread_pool(size_t threads);
+	~thread_pool();
+	thread_pool(const thread_pool&) = delete;
+	thread_pool& operator=(const thread_pool&) = delete;
+
+	size_t size() const { return queues.size(); }
+
+	//Calls body(begin, end) on disjoint ranges covering [0, count) and returns once all of them are done.
+	//Loops shorter than min_parallel aren't worth waking the workers for and run on the calling thread.
+	void parallel_for(size_t count, const std::function<void(size_t, size_t)>& body, size_t min_parallel = 64);
+
+private:
+	struct chunk
+	{
+		size_t begin;
+		size_t end;
+	};
+	struct work_queue
+	{
+		std::mutex lock;
+		std::deque<chunk> chunks;
+	};
+
+	bool take(size_t self, chunk& out);
+	void drain(size_t self);
+	void worker(size_t self);
+
+	std::vector<std::unique_ptr<work_queue>> queues;
+	std::vector<std::thread> workers;
+
+	const std::function<void(size_t, size_t)>* job = nullptr;
+	std::atomic<size_t> pending{ 0 };
+	std::mutex stateLock;
+	std::condition_variable wake;
+	std::condition_variable finished;
+	uint64_t generation = 0;
+	bool stopping = false;
+};
@@ -0,0 +1,52 @@
+#include "trace_log.h"
+
+using namespace std;
+
+namespace
+{
+	const size_t TRACE_BUFFER_SIZE = 64 * 1024;
+}
+
+trace_log::trace_buffer::trace_buffer() : data(TRACE_BUFFER_SIZE)
+{
+	setp(data.data(), data.data() + data.size());
+}
+
+void trace_log::trace_buffer::drain()
+{
+	if (sink != nullptr && pptr() != pbase())
+	{
+		sink->write(pbase(), pptr() - pbase());
+		sink->flush();
+	}
+	setp(data.data(), data.data() + data.size());
+}
+
+trace_log::trace_buffer::int_type trace_log::trace_buffer::overflow(int_type c)
+{
+	drain();
+	if (!traits_type::eq_int_type(c, traits_type::eof()))
+	{
+		*pptr() = traits_type::to_char_type(c);
+		pbump(1);
+	}
+	return traits_type::not_eof(c);
+}
+
+//std::endl and friends end up here. Ignored on purpose, the buffer only goes out when full or on flush().
+int trace_log::trace_buffer::sync()
+{
+	return 0;
+}
+
+void trace_log::open(ostream* sink, trace_level level)
+{
+	buffer.drain();
+	buffer.set_sink(sink);
+	current = sink != nullptr ? level : TRACE_OFF;
+}
+
+void trace_log::flush()
+{
+	buffer.drain();
+}
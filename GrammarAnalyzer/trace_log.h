@@ -0,0 +1,77 @@
+#pragma once
+
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+//How much the analysis writes to its trace sink:
+//	TRACE_OFF		nothing
+//	TRACE_SUMMARY	a few lines per phase (sizes, graph shapes, times)
+//	TRACE_UPDATES	every production and every set update along the way, this is a lot of text
+enum trace_level { TRACE_OFF, TRACE_SUMMARY, TRACE_UPDATES };
+
+//Highest level compiled in. Build with GRAMMAR_TRACE_LEVEL=0 and every trace statement is removed by the compiler,
+//the runtime level then can't turn anything back on.
+#ifndef GRAMMAR_TRACE_LEVEL
+#define GRAMMAR_TRACE_LEVEL 2
+#endif
+constexpr trace_level TRACE_COMPILED_LEVEL = (trace_level)GRAMMAR_TRACE_LEVEL;
+
+/*
+	Buffered trace output. Text collects in a 64 KiB buffer and goes to the sink in large writes, only
+	when the buffer fills and on flush(), so tracing to a console costs no flush per line. The sink is
+	separate from whatever the program writes its results to, usually a file or std::clog.
+
+	Trace statements are guarded by enabled<LEVEL>(), which is a compile time false above
+	TRACE_COMPILED_LEVEL:
+		if (log.enabled<TRACE_UPDATES>()) { log.out() << ...; }
+*/
+class trace_log
+{
+public:
+	trace_log() : stream(&buffer) {}
+	~trace_log() { flush(); }
+	trace_log(const trace_log&) = delete;
+	trace_log& operator=(const trace_log&) = delete;
+
+	//nullptr or TRACE_OFF disables tracing. Anything still buffered goes to the previous sink first.
+	void open(std::ostream* sink, trace_level level);
+	void flush();
+
+	template <trace_level LEVEL>
+	bool enabled() const
+	{
+		if constexpr (LEVEL > TRACE_COMPILED_LEVEL || LEVEL == TRACE_OFF)
+		{
+			return false;
+		}
+		else
+		{
+			return LEVEL <= current;
+		}
+	}
+
+	std::ostream& out() { return stream; }
+
+private:
+	class trace_buffer : public std::streambuf
+	{
+	public:
+		trace_buffer();
+		void set_sink(std::ostream* out) { sink = out; }
+		//Hands everything buffered to the sink and flushes it.
+		void drain();
+
+	protected:
+		int_type overflow(int_type c) override;
+		int sync() override;
+
+	private:
+		std::vector<char> data;
+		std::ostream* sink = nullptr;
+	};
+
+	trace_buffer buffer;
+	std::ostream stream;
+	trace_level current = TRACE_OFF;
+};
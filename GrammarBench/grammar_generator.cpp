@@ -0,0 +1,121 @@
+#include "grammar_generator.h"
+
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+	//splitmix64, tiny and identical everywhere.
+	class random_source
+	{
+	public:
+		explicit random_source(uint64_t seed) : state(seed) {}
+
+		uint64_t next()
+		{
+			uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+			return z ^ (z >> 31);
+		}
+
+		//[0, bound)
+		size_t below(size_t bound) { return (size_t)(next() % bound); }
+		//[low, high]
+		size_t between(size_t low, size_t high) { return low + below(high - low + 1); }
+		bool chance(double p) { return (next() >> 11) * (1.0 / 9007199254740992.0) < p; }
+
+	private:
+		uint64_t state;
+	};
+
+	void append_nonterminal(string& out, size_t n)
+	{
+		out += 'n';
+		out += to_string(n);
+	}
+
+	void append_terminal(string& out, size_t t)
+	{
+		out += 't';
+		out += to_string(t);
+	}
+}
+
+void generate_grammar(const generator_options& options, string& terminals, string& rules)
+{
+	random_source random(options.seed);
+	size_t nonterminal_count = options.nonterminals > 0 ? options.nonterminals : 1;
+	size_t terminal_count = options.terminals > 0 ? options.terminals : 1;
+	size_t block = options.sccSize > 0 ? options.sccSize : 1;
+	size_t max_rhs = options.maxRhs > options.minRhs ? options.maxRhs : options.minRhs;
+
+	terminals.clear();
+	for (size_t t = 0; t < terminal_count; t++)
+	{
+		append_terminal(terminals, t);
+		terminals += '\n';
+	}
+	terminals += "epsilon\n$\n";
+
+	//Every nonterminal has one alternative, the rest are dealt out at random.
+	vector<uint32_t> alternatives(nonterminal_count, 1);
+	for (size_t extra = nonterminal_count; extra < options.productions; extra++)
+	{
+		alternatives[random.below(nonterminal_count)]++;
+	}
+
+	rules.clear();
+	rules.reserve(options.productions * (max_rhs + 2) * 6);
+	rules += "goal ::= n0 $ !\n";
+	for (size_t n = 0; n < nonterminal_count; n++)
+	{
+		size_t block_start = n - n % block;
+		size_t block_end = block_start + block;
+		if (block_end > nonterminal_count)
+		{
+			block_end = nonterminal_count;
+		}
+
+		append_nonterminal(rules, n);
+		rules += " ::=";
+		for (uint32_t a = 0; a < alternatives[n]; a++)
+		{
+			if (a > 0)
+			{
+				rules += " |";
+			}
+			size_t length = random.between(options.minRhs, max_rhs);
+			for (size_t i = 0; i < length; i++)
+			{
+				rules += ' ';
+				bool later_blocks = block_end < nonterminal_count;
+				if (random.chance(options.nonterminalRatio))
+				{
+					if (random.chance(options.recursion) || !later_blocks)
+					{
+						append_nonterminal(rules, block_start + random.below(block_end - block_start));
+					}
+					else
+					{
+						append_nonterminal(rules, block_end + random.below(nonterminal_count - block_end));
+					}
+				}
+				else
+				{
+					append_terminal(rules, random.below(terminal_count));
+				}
+			}
+			if (length == 0)
+			{
+				rules += " epsilon";
+			}
+		}
+		if (random.chance(options.epsilonDensity))
+		{
+			rules += " | epsilon";
+		}
+		rules += " !\n";
+	}
+}
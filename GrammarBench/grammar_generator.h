@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+//Knobs of the synthetic grammars. Nonterminals are n0 .. nN-1, terminals t0 .. tT-1, plus goal ::= n0 $.
+struct generator_options
+{
+	size_t nonterminals = 1000;
+	size_t terminals = 200;
+	size_t productions = 3000;			//in total, not counting epsilon alternatives. Every nonterminal gets at least one
+	size_t minRhs = 1;
+	size_t maxRhs = 6;
+	double epsilonDensity = 0.1;		//chance a nonterminal gets an epsilon alternative
+	double nonterminalRatio = 0.5;		//chance a RHS symbol is a nonterminal rather than a terminal
+	double recursion = 0.2;				//chance a nonterminal reference stays inside its own block
+	size_t sccSize = 8;					//nonterminals per block, references inside a block may form cycles
+	uint64_t seed = 1;
+};
+
+/*
+	Writes a grammar in the "A ::= B | C D | E !" format and its terminals file into rules and terminals.
+
+	Nonterminals are cut into blocks of sccSize. A nonterminal reference either stays inside the
+	block (recursion, any member, so left recursion and cycles happen) or goes to a later block, so the
+	FIRST/FOLLOW graphs are a DAG of SCCs of up to sccSize nodes. The same options and seed give the
+	same grammar on every platform: it uses its own random number generator, not <random>'s distributions.
+*/
+void generate_grammar(const generator_options& options, std::string& terminals, std::string& rules);
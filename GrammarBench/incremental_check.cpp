@@ -0,0 +1,262 @@
+#include "incremental_check.h"
+#include "incremental_analysis.h"
+#include "grammar_analyzer.h"
+
+#include <random>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+	const size_t EDITS = 400;
+	const uint32_t SEED = 12345;
+
+	const char* const slides =
+		"goal ::= expr $ !\n"
+		"expr ::= term expr_p !\n"
+		"expr_p ::= + term expr_p | - term expr_p | epsilon !\n"
+		"term ::= factor term_p !\n"
+		"term_p ::= * factor term_p | / factor term_p | epsilon !\n"
+		"factor ::= ( expr ) | num | name !\n";
+
+	struct rule
+	{
+		string lhs;
+		vector<string> rhs;
+	};
+
+	vector<string_view> views(const vector<string>& names)
+	{
+		return vector<string_view>(names.begin(), names.end());
+	}
+
+	//Same bits, by name, in both sets.
+	bool same_set(const grammar_analyzer& analyzer, terminal_set_view expected, const symbol_table& symbols, terminal_set_view actual)
+	{
+		if (expected.count() != actual.count())
+		{
+			return false;
+		}
+		for (size_t bit : expected)
+		{
+			symbol_id id = symbols.find(analyzer.terminal_name(bit));
+			if (id == NO_SYMBOL || !symbols.isTerminal(id) || !actual.test(symbols.index(id)))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//Runs grammar_analyzer on rules with every terminal incremental knows declared, so both split the
+	//symbols the same way, and compares every set. Every LHS keeps at least one production, a nonterminal
+	//without any would be an undeclared terminal to grammar_analyzer.
+	bool compare(const incremental_analysis& incremental, const vector<rule>& rules, string& error)
+	{
+		const symbol_table& symbols = incremental.symbols();
+		string terminals;
+		for (symbol_id t : symbols.terminals())
+		{
+			terminals += symbols.name(t) + "\n";
+		}
+		string text;
+		for (const rule& r : rules)
+		{
+			text += r.lhs + " ::=";
+			for (const string& name : r.rhs)
+			{
+				text += " " + name;
+			}
+			text += " !\n";
+		}
+
+		grammar_analyzer analyzer;
+		if (!analyzer.parse(terminals, text, error))
+		{
+			return false;
+		}
+		analyzer.compute();
+		if (analyzer.symbols().nonterminals().size() != symbols.nonterminals().size())
+		{
+			error = "nonterminal count differs from the analyzer";
+			return false;
+		}
+		for (symbol_id expected : analyzer.symbols().nonterminals())
+		{
+			const string& name = analyzer.symbols().name(expected);
+			symbol_id id = symbols.find(name);
+			if (id == NO_SYMBOL || !symbols.isNonterminal(id))
+			{
+				error = name + " isn't a nonterminal of incremental_analysis";
+				return false;
+			}
+			if (analyzer.nullable(expected) != incremental.nullable(id) ||
+				!same_set(analyzer, analyzer.first(expected), symbols, incremental.first(id)))
+			{
+				error = "FIRST(" + name + ") differs from the analyzer";
+				return false;
+			}
+			if (!same_set(analyzer, analyzer.follow(expected), symbols, incremental.follow(id)))
+			{
+				error = "FOLLOW(" + name + ") differs from the analyzer";
+				return false;
+			}
+			if (!same_set(analyzer, analyzer.first_plus(expected), symbols, incremental.first_plus(id)))
+			{
+				error = "FIRST+(" + name + ") differs from the analyzer";
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+bool check_incremental_analysis(string& error)
+{
+	grammar_analyzer start;
+	if (!start.parse("", slides, error))
+	{
+		return false;
+	}
+	incremental_analysis incremental;
+	incremental.load(start.symbols(), start.productions());
+
+	vector<rule> rules;
+	for (production_id p : start.productions().all_productions())
+	{
+		production_view production = start.productions().production(p);
+		rule r{ start.symbols().name(production.lhs), {} };
+		for (symbol_id s : production)
+		{
+			r.rhs.push_back(start.symbols().name(s));
+		}
+		rules.push_back(r);
+	}
+	if (!compare(incremental, rules, error))
+	{
+		error = "incremental_analysis: after load, " + error;
+		return false;
+	}
+
+	mt19937 random(SEED);
+	size_t newNames = 0;
+	auto pick = [&](size_t count) { return (size_t)uniform_int_distribution<size_t>(0, count - 1)(random); };
+	//A RHS of up to three known symbols, now and then a name never seen before (an undeclared terminal).
+	auto random_rhs = [&]()
+	{
+		const symbol_table& symbols = incremental.symbols();
+		vector<string> rhs;
+		size_t length = pick(4);
+		for (size_t i = 0; i < length; i++)
+		{
+			if (pick(10) == 0)
+			{
+				rhs.push_back("t" + to_string(newNames++));
+				continue;
+			}
+			symbol_id s = (symbol_id)pick(symbols.size());
+			if (s != symbols.epsilon)
+			{
+				rhs.push_back(symbols.name(s));
+			}
+		}
+		if (rhs.empty())
+		{
+			rhs.push_back("epsilon");
+		}
+		return rhs;
+	};
+	//Productions of lhs in rules, the edits only remove one if another is left.
+	auto alternatives = [&](const string& lhs)
+	{
+		size_t count = 0;
+		for (const rule& r : rules)
+		{
+			count += r.lhs == lhs;
+		}
+		return count;
+	};
+
+	for (size_t edit = 0; edit < EDITS; edit++)
+	{
+		analysis_changes changes;
+		string what;
+		size_t kind = pick(5);
+		if (kind == 0)
+		{
+			string name = "d" + to_string(newNames++);
+			what = "declare_terminal " + name;
+			incremental.declare_terminal(name, changes);
+		}
+		else if (kind == 1)
+		{
+			//A new nonterminal, then a production that uses it.
+			rule added{ "n" + to_string(newNames++), random_rhs() };
+			what = "add_production " + added.lhs;
+			incremental.add_production(added.lhs, views(added.rhs), changes);
+			rules.push_back(added);
+			const rule& user = rules[pick(rules.size() - 1)];
+			rule extended{ user.lhs, user.rhs };
+			if (extended.rhs.size() == 1 && extended.rhs[0] == "epsilon")
+			{
+				extended.rhs.clear();
+			}
+			extended.rhs.push_back(added.lhs);
+			incremental.add_production(extended.lhs, views(extended.rhs), changes);
+			rules.push_back(extended);
+		}
+		else if (kind == 2)
+		{
+			const symbol_table& symbols = incremental.symbols();
+			rule added{ symbols.name(symbols.nonterminals()[pick(symbols.nonterminals().size())]), random_rhs() };
+			what = "add_production " + added.lhs;
+			incremental.add_production(added.lhs, views(added.rhs), changes);
+			rules.push_back(added);
+		}
+		else if (kind == 3)
+		{
+			size_t r = pick(rules.size());
+			what = "remove_production " + rules[r].lhs;
+			if (alternatives(rules[r].lhs) < 2)
+			{
+				continue;
+			}
+			//Takes out the first production that matches, like remove_production does.
+			size_t first = 0;
+			while (rules[first].lhs != rules[r].lhs || rules[first].rhs != rules[r].rhs)
+			{
+				first++;
+			}
+			if (!incremental.remove_production(rules[first].lhs, views(rules[first].rhs), changes))
+			{
+				error = "incremental_analysis: " + what + " failed";
+				return false;
+			}
+			rules.erase(rules.begin() + first);
+		}
+		else
+		{
+			size_t r = pick(rules.size());
+			size_t first = 0;
+			while (rules[first].lhs != rules[r].lhs || rules[first].rhs != rules[r].rhs)
+			{
+				first++;
+			}
+			vector<string> after = random_rhs();
+			what = "replace_production " + rules[first].lhs;
+			if (!incremental.replace_production(rules[first].lhs, views(rules[first].rhs), views(after), changes))
+			{
+				error = "incremental_analysis: " + what + " failed";
+				return false;
+			}
+			rules[first].rhs = after;
+		}
+		if (!compare(incremental, rules, error))
+		{
+			error = "incremental_analysis: edit " + to_string(edit) + " (" + what + "), " + error;
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+
+/*
+	Cross-check of incremental_analysis against grammar_analyzer. Starts both from the grammar of
+	slides_test_input.txt, replays a fixed sequence of random edits (added, removed and replaced productions,
+	new nonterminals, declared and undeclared terminals) through incremental_analysis and after every one
+	runs grammar_analyzer on the grammar as it stands, comparing nullable, FIRST, FOLLOW and FIRST+ of every
+	nonterminal by name. False with error saying which edit and which set differ.
+*/
+bool check_incremental_analysis(std::string& error);
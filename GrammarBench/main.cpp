@@ -0,0 +1,332 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+
+#include "grammar_analyzer.h"
+#include "thread_pool.h"
+#include "grammar_generator.h"
+#include "static_check.h"
+#include "incremental_check.h"
+#include "lookahead_analysis.h"
+#include "lr_table.h"
+#include "lalr_lookahead.h"
+
+using namespace std;
+
+//Benchmark for the GrammarAnalyzer library: generates synthetic grammars of growing size, runs every
+//phase on them and writes the stats of every run (see analysis_stats.h) to a JSON file. With --k-max every
+//run also computes FIRST_k and FOLLOW_k for k = 1 up to it, to show how the cost grows with k. With --lr 1
+//every run also builds the LR(0) automaton and the SLR(1) and LALR(1) tables, whose cost should follow the
+//number of LR(0) transitions. --grammar-file and --terminals-file add a grammar from disk (e.g. the Lua
+//grammar in First_and_Follow_sets) as the first run, --sizes none leaves only that one. Before any run the
+//compile-time analysis of static_analysis.h and a run of random edits through incremental_analysis are
+//checked against the analyzer (see static_check.h and incremental_check.h).
+
+struct bench_options
+{
+	vector<size_t> sizes = { 1000, 10000, 100000, 1000000 };	//productions per grammar
+	size_t alternatives = 3;									//productions per nonterminal
+	size_t repeat = 1;
+	size_t threads = 1;
+	size_t kMax = 0;											//0 means no FIRST_k and FOLLOW_k
+	bool lr = false;											//LR(0), SLR(1) and LALR(1) too
+	string grammarFile;											//a grammar from disk, run before the generated ones
+	string terminalsFile;
+	string output = "bench_results.json";
+	string emit;												//directory to write the generated grammars to
+	generator_options grammar;
+};
+
+bool parse_sizes(const char* text, vector<size_t>& sizes)
+{
+	sizes.clear();
+	if (string(text) == "none")
+	{
+		return true;
+	}
+	stringstream list(text);
+	string item;
+	while (getline(list, item, ','))
+	{
+		char* end;
+		unsigned long long value = strtoull(item.c_str(), &end, 10);
+		if (item.empty() || *end != '\0' || value == 0)
+		{
+			return false;
+		}
+		sizes.push_back((size_t)value);
+	}
+	return !sizes.empty();
+}
+
+bool parse_arguments(int argc, char* argv[], bench_options& opts)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = argv[i];
+		if (i + 1 >= argc)
+		{
+			return false;
+		}
+		const char* value = argv[++i];
+		char* end;
+		double number = strtod(value, &end);
+		bool numeric = *end == '\0' && number >= 0;
+
+		if (arg == "--sizes")
+		{
+			if (!parse_sizes(value, opts.sizes))
+			{
+				return false;
+			}
+			continue;
+		}
+		else if (arg == "--output")
+		{
+			opts.output = value;
+			continue;
+		}
+		else if (arg == "--emit")
+		{
+			opts.emit = value;
+			continue;
+		}
+		else if (arg == "--grammar-file")
+		{
+			opts.grammarFile = value;
+			continue;
+		}
+		else if (arg == "--terminals-file")
+		{
+			opts.terminalsFile = value;
+			continue;
+		}
+		if (!numeric)
+		{
+			return false;
+		}
+
+		if (arg == "--alternatives" && number >= 1) opts.alternatives = (size_t)number;
+		else if (arg == "--repeat" && number >= 1) opts.repeat = (size_t)number;
+		else if (arg == "--threads") opts.threads = (size_t)number;
+		else if (arg == "--k-max") opts.kMax = (size_t)number;
+		else if (arg == "--lr") opts.lr = number != 0;
+		else if (arg == "--terminals" && number >= 1) opts.grammar.terminals = (size_t)number;
+		else if (arg == "--min-rhs") opts.grammar.minRhs = (size_t)number;
+		else if (arg == "--max-rhs") opts.grammar.maxRhs = (size_t)number;
+		else if (arg == "--epsilon" && number <= 1) opts.grammar.epsilonDensity = number;
+		else if (arg == "--nonterminal-ratio" && number <= 1) opts.grammar.nonterminalRatio = number;
+		else if (arg == "--recursion" && number <= 1) opts.grammar.recursion = number;
+		else if (arg == "--scc-size" && number >= 1) opts.grammar.sccSize = (size_t)number;
+		else if (arg == "--seed") opts.grammar.seed = (uint64_t)number;
+		else return false;
+	}
+	return opts.grammarFile.empty() == opts.terminalsFile.empty() && (!opts.sizes.empty() || !opts.grammarFile.empty());
+}
+
+void usage(const char* program)
+{
+	cerr << "usage: " << program << " [--sizes N,N,...|none] [--alternatives N] [--repeat N] [--threads N] [--k-max N] [--lr 0|1]\n"
+		<< "\t[--terminals N] [--min-rhs N] [--max-rhs N] [--epsilon P] [--nonterminal-ratio P]\n"
+		<< "\t[--recursion P] [--scc-size N] [--seed N] [--output FILE] [--emit DIR]\n"
+		<< "\t[--grammar-file FILE --terminals-file FILE]\n";
+}
+
+//One JSON object per k, on one line each.
+void write_lookahead(ostream& out, const grammar_analyzer& analyzer, size_t kMax)
+{
+	out << ",\n      \"lookahead\": [";
+	for (size_t k = 1; k <= kMax; k++)
+	{
+		lookahead_analysis lookahead(k);
+		lookahead.compute(analyzer.symbols(), analyzer.productions());
+		const lookahead_stats& stats = lookahead.stats();
+		out << (k == 1 ? "\n        " : ",\n        ") << "{ \"k\": " << k << ", \"first\": " << stats.first.wall
+			<< ", \"follow\": " << stats.follow.wall << ", \"conflicts\": " << stats.conflicts.wall
+			<< ", \"sequences\": " << stats.sequences << ", \"set_entries\": " << stats.setEntries << ", \"bytes\": " << stats.bytes
+			<< ", \"evaluations\": " << stats.evaluations << ", \"llk_conflicts\": " << stats.llkConflicts << " }";
+		cout << "\tk = " << k << ": " << (stats.first.wall + stats.follow.wall + stats.conflicts.wall) << "s, "
+			<< stats.sequences << " sequences, " << stats.setEntries << " set entries, " << (stats.bytes >> 20) << " MiB, "
+			<< stats.llkConflicts << " LL(" << k << ") conflicts\n";
+	}
+	out << (kMax == 0 ? "]" : "\n      ]");
+}
+
+//The LR(0) automaton, SLR(1) and LALR(1) tables, as one JSON object.
+void write_lr(ostream& out, const grammar_analyzer& analyzer, thread_pool& pool)
+{
+	lr0_automaton automaton;
+	automaton.build(analyzer.symbols(), analyzer.productions());
+	lr_table slr;
+	slr.build_slr(automaton, analyzer);
+	lalr_lookahead lookaheads;
+	lookaheads.compute(automaton, analyzer, &pool);
+	lr_table lalr;
+	lalr.build(automaton, analyzer.symbols(), lookaheads.views());
+
+	const lr0_stats& lr0 = automaton.stats();
+	const lalr_stats& la = lookaheads.stats();
+	double lalrTime = la.relations.wall + la.reads.wall + la.includes.wall + la.lookahead.wall;
+	out << ",\n      \"lr\": { \"states\": " << lr0.states << ", \"transitions\": " << lr0.transitions
+		<< ", \"nonterminal_transitions\": " << lr0.nonterminalTransitions << ", \"reductions\": " << lr0.reductions
+		<< ", \"lr0\": " << lr0.build.wall << ", \"lr0_bytes\": " << lr0.bytes
+		<< ",\n        \"slr_table\": " << slr.stats().build.wall << ", \"slr_shift_reduce\": " << slr.stats().shiftReduce
+		<< ", \"slr_reduce_reduce\": " << slr.stats().reduceReduce
+		<< ",\n        \"lalr_relations\": " << la.relations.wall << ", \"lalr_reads\": " << la.reads.wall
+		<< ", \"lalr_includes\": " << la.includes.wall << ", \"lalr_lookahead\": " << la.lookahead.wall
+		<< ", \"lalr_bytes\": " << la.bytes << ", \"reads_edges\": " << la.readsEdges << ", \"includes_edges\": " << la.includesEdges
+		<< ", \"lookback_edges\": " << la.lookbackEdges << ", \"includes_sccs\": " << la.includesGraph.sccs
+		<< ",\n        \"lalr_table\": " << lalr.stats().build.wall << ", \"lalr_shift_reduce\": " << lalr.stats().shiftReduce
+		<< ", \"lalr_reduce_reduce\": " << lalr.stats().reduceReduce << " }";
+	cout << "\tLR(0) " << lr0.states << " states, " << lr0.transitions << " transitions in " << lr0.build.wall << "s, LALR(1) lookaheads "
+		<< lalrTime << "s (" << (lr0.transitions == 0 ? 0 : lalrTime * 1e9 / lr0.transitions) << " ns per transition), conflict cells SLR(1) "
+		<< (slr.stats().shiftReduce + slr.stats().reduceReduce) << ", LALR(1) " << (lalr.stats().shiftReduce + lalr.stats().reduceReduce) << "\n";
+}
+
+void write_options(ostream& out, const bench_options& opts)
+{
+	const generator_options& g = opts.grammar;
+	out << "  \"threads\": " << opts.threads << ",\n"
+		<< "  \"k_max\": " << opts.kMax << ",\n"
+		<< "  \"lr\": " << (opts.lr ? "true" : "false") << ",\n"
+		<< "  \"generator\": { \"alternatives\": " << opts.alternatives << ", \"terminals\": " << g.terminals
+		<< ", \"min_rhs\": " << g.minRhs << ", \"max_rhs\": " << g.maxRhs << ", \"epsilon\": " << g.epsilonDensity
+		<< ", \"nonterminal_ratio\": " << g.nonterminalRatio << ", \"recursion\": " << g.recursion
+		<< ", \"scc_size\": " << g.sccSize << ", \"seed\": " << g.seed << " },\n";
+}
+
+int main(int argc, char* argv[])
+{
+	bench_options opts;
+	if (!parse_arguments(argc, argv, opts))
+	{
+		usage(argv[0]);
+		return 1;
+	}
+	string error;
+	if (!check_static_analysis(error))
+	{
+		cerr << error << "\n";
+		return 1;
+	}
+	if (!check_incremental_analysis(error))
+	{
+		cerr << error << "\n";
+		return 1;
+	}
+
+	ofstream out(opts.output, ios::trunc);
+	if (!out)
+	{
+		cerr << "can't write " << opts.output << "\n";
+		return 1;
+	}
+	out.precision(9);
+	out << "{\n";
+	write_options(out, opts);
+	out << "  \"runs\": [";
+
+	thread_pool pool(opts.threads);
+	grammar_analyzer analyzer(&pool);
+	string terminals;
+	string rules;
+	bool first_run = true;
+
+	//Every repeat of one grammar, size is what the run is labelled with.
+	auto bench = [&](size_t size, const string& source)
+	{
+		for (size_t r = 0; r < opts.repeat; r++)
+		{
+			if (!analyzer.parse(terminals, rules, error))
+			{
+				cerr << error << "\n";
+				return false;
+			}
+			analyzer.compute();
+			const analysis_stats& stats = analyzer.stats();
+			phase_time total = stats.total();
+
+			out << (first_run ? "\n" : ",\n");
+			first_run = false;
+			out << "    { \"size\": " << size << ", \"source\": \"" << source << "\", \"input_bytes\": " << rules.size()
+				<< ", \"repeat\": " << r << ",\n      \"stats\": ";
+			write_stats_json(out, stats, "      ");
+
+			cout << size << " productions: " << total.wall << "s (load " << stats.load.wall << ", FIRST " << stats.first.wall
+				<< ", FOLLOW " << stats.follow.wall << ", FIRST+ " << stats.firstPlus.wall << "), cpu " << total.cpu
+				<< "s, peak " << (stats.peakMemory >> 20) << " MiB\n";
+			if (opts.kMax != 0)
+			{
+				write_lookahead(out, analyzer, opts.kMax);
+			}
+			if (opts.lr)
+			{
+				write_lr(out, analyzer, pool);
+			}
+			out << " }";
+		}
+		return true;
+	};
+
+	if (!opts.grammarFile.empty())
+	{
+		ifstream grammarIn(opts.grammarFile, ios::binary);
+		ifstream terminalsIn(opts.terminalsFile, ios::binary);
+		if (!grammarIn || !terminalsIn)
+		{
+			cerr << "can't read " << (!grammarIn ? opts.grammarFile : opts.terminalsFile) << "\n";
+			return 1;
+		}
+		stringstream grammarText;
+		stringstream terminalsText;
+		grammarText << grammarIn.rdbuf();
+		terminalsText << terminalsIn.rdbuf();
+		rules = grammarText.str();
+		terminals = terminalsText.str();
+		if (!analyzer.parse(terminals, rules, error))
+		{
+			cerr << error << "\n";
+			return 1;
+		}
+		//The file name goes into the JSON as is, so only the characters that need it are escaped.
+		string source;
+		for (char c : opts.grammarFile)
+		{
+			if (c == '"' || c == '\\')
+			{
+				source += '\\';
+			}
+			source += c;
+		}
+		if (!bench(analyzer.productions().production_count(), source))
+		{
+			return 1;
+		}
+	}
+
+	//Smallest first, the process' peak memory only ever goes up.
+	for (size_t size : opts.sizes)
+	{
+		generator_options grammar = opts.grammar;
+		grammar.productions = size;
+		grammar.nonterminals = (size + opts.alternatives - 1) / opts.alternatives;
+		generate_grammar(grammar, terminals, rules);
+
+		if (!opts.emit.empty())
+		{
+			string base = opts.emit + "/bench_" + to_string(size);
+			ofstream(base + "_terminals.txt", ios::trunc | ios::binary) << terminals;
+			ofstream(base + "_language.txt", ios::trunc | ios::binary) << rules;
+		}
+		if (!bench(size, "generated"))
+		{
+			return 1;
+		}
+	}
+
+	out << "\n  ]\n}\n";
+	return 0;
+}
@@ -0,0 +1,161 @@
+#include "static_check.h"
+#include "static_analysis.h"
+#include "grammar_analyzer.h"
+
+#include <initializer_list>
+
+using namespace std;
+
+namespace
+{
+	//slides_test_input.txt
+	constexpr static_production slides[] =
+	{
+		{ "goal", "expr $" },
+		{ "expr", "term expr_p" },
+		{ "expr_p", "+ term expr_p" },
+		{ "expr_p", "- term expr_p" },
+		{ "expr_p", "epsilon" },
+		{ "term", "factor term_p" },
+		{ "term_p", "* factor term_p" },
+		{ "term_p", "/ factor term_p" },
+		{ "term_p", "epsilon" },
+		{ "factor", "( expr )" },
+		{ "factor", "num" },
+		{ "factor", "name" },
+	};
+	typedef static_analysis<slides> slides_sets;
+
+	constexpr bool holds(const slides_sets::set_type& set, initializer_list<string_view> names)
+	{
+		for (string_view name : names)
+		{
+			size_t bit = slides_sets::terminal(name);
+			if (bit == slides_sets::NO_INDEX || !set.test(bit))
+			{
+				return false;
+			}
+		}
+		return set.count() == names.size();
+	}
+
+	constexpr bool first_is(string_view nonterminal, initializer_list<string_view> names)
+	{
+		return holds(slides_sets::first(slides_sets::nonterminal(nonterminal)), names);
+	}
+
+	constexpr bool follow_is(string_view nonterminal, initializer_list<string_view> names)
+	{
+		return holds(slides_sets::follow(slides_sets::nonterminal(nonterminal)), names);
+	}
+
+	static_assert(slides_sets::nonterminal_count() == 6 && slides_sets::terminal_count() == 10, "slides: symbols");
+	static_assert(first_is("goal", { "(", "num", "name" }), "slides: FIRST(goal)");
+	static_assert(first_is("expr_p", { "+", "-", "epsilon" }), "slides: FIRST(expr_p)");
+	static_assert(first_is("term_p", { "*", "/", "epsilon" }), "slides: FIRST(term_p)");
+	static_assert(first_is("factor", { "(", "num", "name" }), "slides: FIRST(factor)");
+	static_assert(follow_is("goal", { "$" }), "slides: FOLLOW(goal)");
+	static_assert(follow_is("expr", { "$", ")" }), "slides: FOLLOW(expr)");
+	static_assert(follow_is("expr_p", { "$", ")" }), "slides: FOLLOW(expr_p)");
+	static_assert(follow_is("term", { "$", "+", "-", ")" }), "slides: FOLLOW(term)");
+	static_assert(follow_is("term_p", { "$", "+", "-", ")" }), "slides: FOLLOW(term_p)");
+	static_assert(follow_is("factor", { "$", "+", "-", "*", "/", ")" }), "slides: FOLLOW(factor)");
+	static_assert(holds(slides_sets::first_plus(4), { "$", ")" }), "slides: FIRST+(expr_p ::= epsilon)");
+	static_assert(holds(slides_sets::first_plus(8), { "$", "+", "-", ")" }), "slides: FIRST+(term_p ::= epsilon)");
+	static_assert(holds(slides_sets::first_plus(9), { "(" }), "slides: FIRST+(factor ::= ( expr ))");
+	static_assert(slides_sets::ll1(), "slides: LL(1)");
+
+	//Same bits, by name, in both sets. Every terminal the analyzer knows has to be in the static grammar.
+	bool same_set(const grammar_analyzer& analyzer, terminal_set_view runtime, const slides_sets::set_type& expected)
+	{
+		size_t count = 0;
+		for (size_t bit = 0; bit < analyzer.symbols().terminals().size(); bit++)
+		{
+			if (!runtime.test(bit))
+			{
+				continue;
+			}
+			size_t expectedBit = slides_sets::terminal(analyzer.terminal_name(bit));
+			if (expectedBit == slides_sets::NO_INDEX || !expected.test(expectedBit))
+			{
+				return false;
+			}
+			count++;
+		}
+		return count == expected.count();
+	}
+}
+
+bool check_static_analysis(string& error)
+{
+	//The same rules in the loader's format, alternatives of consecutive productions joined.
+	string rules;
+	for (size_t p = 0; p < slides_sets::production_count(); p++)
+	{
+		bool continues = p > 0 && slides[p - 1].lhs == slides[p].lhs;
+		if (!continues)
+		{
+			rules += (p > 0 ? " !\n" : "") + string(slides[p].lhs) + " ::=";
+		}
+		else
+		{
+			rules += " |";
+		}
+		rules += " " + string(slides[p].rhs.empty() ? "epsilon" : slides[p].rhs);
+	}
+	rules += " !\n";
+
+	grammar_analyzer analyzer;
+	if (!analyzer.parse("", rules, error))
+	{
+		return false;
+	}
+	analyzer.compute();
+	const symbol_table& symbols = analyzer.symbols();
+	if (symbols.nonterminals().size() != slides_sets::nonterminal_count())
+	{
+		error = "static_analysis: nonterminal count differs from the analyzer";
+		return false;
+	}
+	for (size_t nt = 0; nt < slides_sets::nonterminal_count(); nt++)
+	{
+		string name(slides_sets::nonterminal_name(nt));
+		symbol_id id = symbols.find(name);
+		if (id == NO_SYMBOL || !symbols.isNonterminal(id))
+		{
+			error = "static_analysis: " + name + " isn't a nonterminal of the analyzer";
+			return false;
+		}
+		if (analyzer.nullable(id) != slides_sets::nullable(nt) || !same_set(analyzer, analyzer.first(id), slides_sets::first(nt)))
+		{
+			error = "static_analysis: FIRST(" + name + ") differs from the analyzer";
+			return false;
+		}
+		if (!same_set(analyzer, analyzer.follow(id), slides_sets::follow(nt)))
+		{
+			error = "static_analysis: FOLLOW(" + name + ") differs from the analyzer";
+			return false;
+		}
+		//Both keep the alternatives of a nonterminal in the order they were written.
+		size_t p = 0;
+		for (production_id alternative : analyzer.productions().productions_of(symbols.index(id)))
+		{
+			while (p < slides_sets::production_count() && slides_sets::lhs(p) != nt)
+			{
+				p++;
+			}
+			if (p == slides_sets::production_count() || !same_set(analyzer, analyzer.production_first_plus(alternative), slides_sets::first_plus(p)))
+			{
+				error = "static_analysis: FIRST+ of an alternative of " + name + " differs from the analyzer";
+				return false;
+			}
+			p++;
+		}
+	}
+	if (analyzer.ll1_conflicts().empty() != slides_sets::ll1())
+	{
+		error = "static_analysis: LL(1) verdict differs from the analyzer";
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+
+/*
+	Cross-check of static_analysis.h against grammar_analyzer. The grammar of slides_test_input.txt is
+	embedded as a constexpr array: static_asserts pin its compile-time FIRST, FOLLOW and FIRST+ to what the
+	analyzer prints for that file, so a broken static_analysis doesn't build, and check_static_analysis
+	runs the analyzer on the same rules and compares every set by name. False with error saying which set
+	differs.
+*/
+bool check_static_analysis(std::string& error);
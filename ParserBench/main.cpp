@@ -0,0 +1,203 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdlib.h>
+
+#include "grammar_analyzer.h"
+#include "ll1_table.h"
+#include "ll1_parser.h"
+#include "stopwatch.h"
+#include "sentence_generator.h"
+
+using namespace std;
+
+//Throughput benchmark for ll1_parser: analyses a grammar (the Lua one by default), builds its LL(1) table,
+//generates random programs the table accepts and parses all of them a few times on one thread.
+
+//Programs the generator may give up on in a row before the table is considered hopeless.
+const size_t MAX_FAILED_PROGRAMS = 1000;
+
+struct bench_options
+{
+	string terminals = "../First_and_Follow_sets/terminals_input.txt";
+	string grammar = "../First_and_Follow_sets/language_input.txt";
+	size_t tokens = 10000000;			//corpus size
+	size_t batch = 4096;				//tokens per ll1_parser::feed call
+	size_t repeat = 5;
+	uint64_t seed = 1;
+	sentence_options program;
+	string output = "parser_bench.json";
+	string emit;						//file to write the first program to, as text
+};
+
+bool parse_arguments(int argc, char* argv[], bench_options& opts)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = argv[i];
+		if (i + 1 >= argc)
+		{
+			return false;
+		}
+		const char* value = argv[++i];
+		if (arg == "--terminals")
+		{
+			opts.terminals = value;
+			continue;
+		}
+		else if (arg == "--grammar")
+		{
+			opts.grammar = value;
+			continue;
+		}
+		else if (arg == "--output")
+		{
+			opts.output = value;
+			continue;
+		}
+		else if (arg == "--emit")
+		{
+			opts.emit = value;
+			continue;
+		}
+
+		char* end;
+		unsigned long long number = strtoull(value, &end, 10);
+		if (*end != '\0' || value[0] == '-')
+		{
+			return false;
+		}
+		if (arg == "--tokens" && number >= 1) opts.tokens = (size_t)number;
+		else if (arg == "--batch" && number >= 1) opts.batch = (size_t)number;
+		else if (arg == "--repeat" && number >= 1) opts.repeat = (size_t)number;
+		else if (arg == "--seed") opts.seed = (uint64_t)number;
+		else if (arg == "--program-tokens" && number >= 1) opts.program.tokens = (size_t)number;
+		else if (arg == "--max-depth" && number >= 1) opts.program.maxDepth = (size_t)number;
+		else if (arg == "--floor") opts.program.floor = (size_t)number;
+		else return false;
+	}
+	return true;
+}
+
+void usage(const char* program)
+{
+	cerr << "usage: " << program << " [--terminals FILE] [--grammar FILE] [--tokens N] [--batch N] [--repeat N]\n"
+		<< "\t[--program-tokens N] [--max-depth N] [--floor N] [--seed N] [--output FILE] [--emit FILE]\n";
+}
+
+//Parses every program of the corpus once, returns false if any of them is rejected.
+bool parse_corpus(ll1_parser& parser, const vector<uint32_t>& tokens, const vector<size_t>& programStart, size_t batch)
+{
+	for (size_t p = 0; p + 1 < programStart.size(); p++)
+	{
+		parser.reset();
+		for (size_t at = programStart[p]; at < programStart[p + 1]; at += batch)
+		{
+			parser.feed(tokens.data() + at, min(batch, programStart[p + 1] - at));
+		}
+		if (parser.finish() != LL1_ACCEPTED)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	bench_options opts;
+	if (!parse_arguments(argc, argv, opts))
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	grammar_analyzer analyzer;
+	string error;
+	if (!analyzer.load(opts.terminals.c_str(), opts.grammar.c_str(), error))
+	{
+		cerr << error << "\n";
+		return 1;
+	}
+	analyzer.compute();
+	ll1_table table;
+	table.build(analyzer);
+	ll1_table_view view = table.view();
+
+	//The corpus: programs back to back, programStart[p] is where program p starts.
+	vector<uint32_t> tokens;
+	vector<size_t> programStart(1, 0);
+	sentence_generator generator(view, opts.seed);
+	stopwatch generation;
+	size_t discarded = 0;
+	size_t failedInARow = 0;
+	while (tokens.size() < opts.tokens)
+	{
+		if (!generator.generate(opts.program, tokens))
+		{
+			discarded++;
+			if (++failedInARow == MAX_FAILED_PROGRAMS)
+			{
+				cerr << "the generator got stuck in " << opts.grammar << "'s table\n";
+				return 1;
+			}
+			continue;
+		}
+		failedInARow = 0;
+		programStart.push_back(tokens.size());
+	}
+	double generationSeconds = generation.seconds();
+	size_t programs = programStart.size() - 1;
+
+	if (!opts.emit.empty())
+	{
+		ofstream program(opts.emit, ios::trunc);
+		for (size_t t = programStart[0]; t < programStart[1]; t++)
+		{
+			program << analyzer.terminal_name(tokens[t]) << (t + 1 < programStart[1] ? " " : "\n");
+		}
+	}
+
+	ll1_parser parser(view);
+	if (!parse_corpus(parser, tokens, programStart, opts.batch))
+	{
+		cerr << "program rejected at token " << parser.position() << "\n";
+		return 1;
+	}
+
+	vector<double> seconds;
+	for (size_t r = 0; r < opts.repeat; r++)
+	{
+		stopwatch timer;
+		parse_corpus(parser, tokens, programStart, opts.batch);
+		seconds.push_back(timer.seconds());
+	}
+	double best = *min_element(seconds.begin(), seconds.end());
+
+	cout << programs << " programs, " << tokens.size() << " tokens (generated in " << generationSeconds << "s, "
+		<< discarded << " programs discarded), "
+		<< view.entryCount << " table cells\n"
+		<< "best of " << opts.repeat << ": " << best << "s, " << tokens.size() / best / 1e6 << " M tokens/s\n";
+
+	ofstream out(opts.output, ios::trunc);
+	if (!out)
+	{
+		cerr << "can't write " << opts.output << "\n";
+		return 1;
+	}
+	out.precision(9);
+	out << "{\n  \"terminals\": " << view.terminalCount << ", \"nonterminals\": " << view.nonterminalCount
+		<< ", \"productions\": " << view.productionCount << ", \"table_cells\": " << view.entryCount
+		<< ", \"ll1_conflicts\": " << analyzer.ll1_conflicts().size() << ",\n"
+		<< "  \"programs\": " << programs << ", \"tokens\": " << tokens.size() << ", \"batch\": " << opts.batch
+		<< ", \"seed\": " << opts.seed << ", \"program_tokens\": " << opts.program.tokens << ", \"max_depth\": " << opts.program.maxDepth
+		<< ",\n  \"generation_seconds\": " << generationSeconds << ", \"discarded_programs\": " << discarded << ",\n  \"seconds\": [";
+	for (size_t r = 0; r < seconds.size(); r++)
+	{
+		out << (r == 0 ? " " : ", ") << seconds[r];
+	}
+	out << " ],\n  \"tokens_per_second\": " << tokens.size() / best << "\n}\n";
+	return 0;
+}
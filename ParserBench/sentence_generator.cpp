@@ -0,0 +1,318 @@
+#include "sentence_generator.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+	//Guards the trial expansions against a left recursive table, which would expand forever.
+	const size_t MAX_EXPANSIONS_PER_TOKEN = 10000;
+	const uint64_t UNREACHABLE = UINT64_MAX / 4;
+	//Times one sentence may go back to its last saved state before it is given up.
+	const size_t MAX_RESTORES = 100;
+}
+
+sentence_generator::sentence_generator(const ll1_table_view& table, uint64_t seed) : table(table), choices(table.nonterminalCount), state(seed)
+{
+	for (uint32_t nt = 0; nt < table.nonterminalCount; nt++)
+	{
+		for (uint32_t terminal = 0; terminal < table.terminalCount; terminal++)
+		{
+			if (table.predict(nt, terminal) != LL1_NO_PRODUCTION)
+			{
+				choices[nt].push_back(terminal);
+			}
+		}
+	}
+
+	//A table with conflicts can hold productions it never gets to the end of. For Lua, var ::= functioncall
+	//var_factor_args var_prime: functioncall ends in fc_prime, whose row continues the call on every token
+	//var_factor_args could start with, so once that production is expanded no token sequence empties the stack.
+	//Such productions are found with two sets per nonterminal, grown together until nothing changes:
+	//the tokens it can start with and the tokens that may follow once it is done. A production is usable if
+	//the table predicts it somewhere, its nonterminals are usable and every symbol can be followed by the next one.
+	uint32_t T = table.terminalCount;
+	vector<char> startTokens((size_t)table.nonterminalCount * T, 0);
+	vector<char> exitTokens((size_t)table.nonterminalCount * T, 0);
+	vector<char> usableNonterminal(table.nonterminalCount, 0);
+	vector<vector<uint32_t>> predictedOn(table.productionCount);
+	for (uint32_t nt = 0; nt < table.nonterminalCount; nt++)
+	{
+		for (uint32_t terminal : choices[nt])
+		{
+			predictedOn[table.predict(nt, terminal)].push_back(terminal);
+		}
+	}
+	auto follows = [&](uint32_t before, uint32_t after)
+	{
+		if (after < T)
+		{
+			return before < T || exitTokens[(size_t)(before - T) * T + after] != 0;
+		}
+		for (uint32_t terminal = 0; terminal < T; terminal++)
+		{
+			if (startTokens[(size_t)(after - T) * T + terminal] && (before < T || exitTokens[(size_t)(before - T) * T + terminal]))
+			{
+				return true;
+			}
+		}
+		return false;
+	};
+	usable.assign(table.productionCount, 0);
+	for (bool changed = true; changed;)
+	{
+		changed = false;
+		for (uint32_t p = 0; p < table.productionCount; p++)
+		{
+			uint32_t from = table.productionStart[p];
+			uint32_t to = table.productionStart[p + 1];
+			if (!usable[p])
+			{
+				bool ok = !predictedOn[p].empty();
+				for (uint32_t k = from; ok && k < to; k++)
+				{
+					ok = (table.rhs[k] < T || usableNonterminal[table.rhs[k] - T]) && (k + 1 == to || follows(table.rhs[k], table.rhs[k + 1]));
+				}
+				if (!ok)
+				{
+					continue;
+				}
+				usable[p] = 1;
+				usableNonterminal[table.productionLhs[p]] = 1;
+				changed = true;
+			}
+			char* lhsStart = &startTokens[(size_t)table.productionLhs[p] * T];
+			char* lhsExit = &exitTokens[(size_t)table.productionLhs[p] * T];
+			for (uint32_t terminal : predictedOn[p])
+			{
+				changed |= !lhsStart[terminal];
+				lhsStart[terminal] = 1;
+			}
+			//Done with an epsilon production on the tokens it is predicted on, after a terminal anything may
+			//follow, otherwise whatever may follow the last nonterminal.
+			uint32_t last = to == from ? LL1_NO_PRODUCTION : table.rhs[to - 1];
+			for (uint32_t terminal = 0; terminal < T; terminal++)
+			{
+				bool exit = last == LL1_NO_PRODUCTION ? table.predict(table.productionLhs[p], terminal) == p
+					: last < T || exitTokens[(size_t)(last - T) * T + terminal];
+				if (exit && !lhsExit[terminal])
+				{
+					lhsExit[terminal] = 1;
+					changed = true;
+				}
+			}
+		}
+	}
+
+	//Shortest number of tokens that empties a stack holding just the symbol. Going by the grammar's productions
+	//would be wrong when the table predicts the shortest one only on a token that starts a long derivation, so
+	//each nonterminal is run through the table on every token of its row once, the stack that leaves is
+	//kept, and the lengths are relaxed over those stacks until nothing changes. Tokens that expand to nothing
+	//are kept apart in vanishOn, see remaining(), and tokens the table can't get through at all, e.g. because
+	//of left recursion, are dropped from choices so they aren't tried over and over.
+	vector<uint32_t> afterSymbols;
+	vector<size_t> afterStart(1, 0);
+	vector<uint32_t> afterOwner;
+	vector<uint32_t> trial;
+	minLength.assign(table.terminalCount + table.nonterminalCount, UNREACHABLE);
+	fill(minLength.begin(), minLength.begin() + table.terminalCount, 1);
+	vanishOn.resize(table.nonterminalCount);
+	for (uint32_t nt = 0; nt < table.nonterminalCount; nt++)
+	{
+		vector<uint32_t> through;
+		for (uint32_t terminal : choices[nt])
+		{
+			trial.assign(1, T + nt);
+			if (consume(trial, terminal))
+			{
+				afterSymbols.insert(afterSymbols.end(), trial.begin(), trial.end());
+				afterStart.push_back(afterSymbols.size());
+				afterOwner.push_back(nt);
+				through.push_back(terminal);
+			}
+			else if (trial.empty())
+			{
+				vanishOn[nt].push_back(terminal);
+				through.push_back(terminal);
+			}
+		}
+		choices[nt].swap(through);
+	}
+	for (bool changed = true; changed;)
+	{
+		changed = false;
+		for (size_t i = 0; i < afterOwner.size(); i++)
+		{
+			uint64_t length = min(1 + remaining(afterSymbols.data() + afterStart[i], afterStart[i + 1] - afterStart[i]), UNREACHABLE);
+			uint64_t& owner = minLength[T + afterOwner[i]];
+			if (length < owner)
+			{
+				owner = length;
+				changed = true;
+			}
+		}
+	}
+}
+
+//A nonterminal that expands to nothing on some token costs nothing, but only if the symbol below it can take
+//one of those tokens; otherwise it has to be closed by consuming tokens like any other. The bottom of the
+//stack is followed by whatever comes after it, which is assumed to fit.
+uint64_t sentence_generator::remaining(const uint32_t* stack, size_t size) const
+{
+	uint64_t length = 0;
+	for (size_t i = 0; i < size; i++)
+	{
+		uint32_t symbol = stack[i];
+		if (symbol >= table.terminalCount && !vanishOn[symbol - table.terminalCount].empty())
+		{
+			bool fits = i == 0;
+			for (size_t k = 0; !fits && k < vanishOn[symbol - table.terminalCount].size(); k++)
+			{
+				uint32_t token = vanishOn[symbol - table.terminalCount][k];
+				uint32_t below = stack[i - 1];
+				fits = below < table.terminalCount ? below == token : table.predict(below - table.terminalCount, token) != LL1_NO_PRODUCTION;
+			}
+			if (fits)
+			{
+				continue;
+			}
+		}
+		length = min(length + minLength[symbol], UNREACHABLE);
+	}
+	return length;
+}
+
+//splitmix64, the same generator as GrammarBench's.
+uint64_t sentence_generator::next()
+{
+	uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+bool sentence_generator::consume(vector<uint32_t>& stack, uint32_t token) const
+{
+	for (size_t expansions = 0; !stack.empty() && expansions < MAX_EXPANSIONS_PER_TOKEN; expansions++)
+	{
+		uint32_t symbol = stack.back();
+		if (symbol < table.terminalCount)
+		{
+			if (symbol != token)
+			{
+				return false;
+			}
+			stack.pop_back();
+			return true;
+		}
+		uint32_t p = table.predict(symbol - table.terminalCount, token);
+		if (p == LL1_NO_PRODUCTION || !usable[p])
+		{
+			return false;
+		}
+		stack.pop_back();
+		for (uint32_t k = table.productionStart[p + 1]; k > table.productionStart[p]; k--)
+		{
+			stack.push_back(table.rhs[k - 1]);
+		}
+	}
+	return false;
+}
+
+bool sentence_generator::generate(const sentence_options& options, vector<uint32_t>& out)
+{
+	size_t start = out.size();
+	if (table.nonterminalCount == 0)
+	{
+		return true;
+	}
+	vector<uint32_t> stack(1, table.terminalCount + table.start);
+	vector<uint32_t> trial;
+	vector<uint32_t> best;
+
+	//The shortest-rest measure is still only an estimate, it looks at one symbol and the one below it, and on
+	//some tables the closing mode goes round in circles with the stack growing. So whenever the stack could be
+	//closed as quickly as at the very start (between two items of the start symbol's list) the state is saved,
+	//and if no new save happens within twice the length of a whole sentence, or the stack gets far deeper
+	//than maxDepth, the generator goes back to the last one and tries other tokens from there.
+	vector<uint32_t> saved = stack;
+	size_t savedSize = start;
+	uint64_t shortest = remaining(stack.data(), stack.size());
+	size_t restores = 0;
+	while (!stack.empty())
+	{
+		if (out.size() - savedSize > 2 * options.tokens + options.maxDepth || stack.size() > 4 * options.maxDepth)
+		{
+			if (++restores > MAX_RESTORES)
+			{
+				out.resize(start);
+				return false;
+			}
+			stack = saved;
+			out.resize(savedSize);
+		}
+		uint32_t symbol = stack.back();
+		if (symbol < table.terminalCount)
+		{
+			out.push_back(symbol);
+			stack.pop_back();
+			continue;
+		}
+
+		//Every token the row of the nonterminal on top allows, tried in turn on a copy of the stack.
+		const vector<uint32_t>& allowed = choices[symbol - table.terminalCount];
+		bool closing = out.size() - start >= options.tokens || stack.size() >= options.maxDepth;
+		if (remaining(stack.data(), stack.size()) <= shortest)
+		{
+			saved = stack;
+			savedSize = out.size();
+		}
+		size_t offset = allowed.empty() ? 0 : (size_t)(next() % allowed.size());
+		uint64_t bestLength = UINT64_MAX;
+		uint32_t bestToken = LL1_NO_PRODUCTION;
+		for (size_t i = 0; i < allowed.size(); i++)
+		{
+			uint32_t token = allowed[(offset + i) % allowed.size()];
+			trial = stack;
+			if (!consume(trial, token))
+			{
+				continue;
+			}
+			uint64_t length = remaining(trial.data(), trial.size());
+			if (length >= UNREACHABLE)
+			{
+				//Something on the stack has no way left to finish.
+				continue;
+			}
+			if (closing)
+			{
+				if (length < bestLength)
+				{
+					bestLength = length;
+					bestToken = token;
+					best.swap(trial);
+				}
+			}
+			else if (trial.size() >= options.floor || bestToken == LL1_NO_PRODUCTION)
+			{
+				//The first acceptable token in the random order wins, one that goes below floor only if there is nothing else.
+				bool acceptable = trial.size() >= options.floor;
+				bestToken = token;
+				best.swap(trial);
+				if (acceptable)
+				{
+					break;
+				}
+			}
+		}
+		if (bestToken == LL1_NO_PRODUCTION)
+		{
+			out.resize(start);
+			return false;
+		}
+		out.push_back(bestToken);
+		stack.swap(best);
+	}
+	return true;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "ll1_table.h"
+
+struct sentence_options
+{
+	size_t tokens = 10000;		//rough length of one sentence, it is closed as soon as possible after this many
+	size_t maxDepth = 48;		//parse stack depth above which the generator steers towards closing constructs
+	size_t floor = 3;			//stack depth it keeps while growing, so the start symbol's list doesn't end early
+};
+
+/*
+	Random sentences of the language an LL(1) table accepts, for benchmarking ll1_parser: every token
+	is picked by running the table exactly like the parser does, so the output always parses, even on
+	a grammar with conflicts such as the Lua one, where the table simply prefers the first alternative.
+
+	Until the sentence is long enough tokens are chosen at random among those that keep the stack at
+	least floor deep; after that, or above maxDepth, the token after which the stack can derive the
+	shortest rest wins, which closes everything that is open. Productions the table can never finish are
+	never entered. Same table, options and seed give the same tokens everywhere.
+*/
+class sentence_generator
+{
+public:
+	sentence_generator(const ll1_table_view& table, uint64_t seed);
+
+	//Appends one sentence, including the $ if the grammar has one. Returns false, with out left as it was, if
+	//the sentence ran into a part of the table it couldn't find a way out of; the next call tries another one.
+	bool generate(const sentence_options& options, std::vector<uint32_t>& out);
+
+private:
+	//Runs the table on token from stack, like ll1_parser::feed. False if the token is rejected or leads to an unusable production.
+	bool consume(std::vector<uint32_t>& stack, uint32_t token) const;
+	//Shortest number of tokens the symbols on stack, bottom first, can still derive.
+	uint64_t remaining(const uint32_t* stack, size_t size) const;
+	uint64_t next();
+
+	ll1_table_view table;
+	std::vector<std::vector<uint32_t>> choices;		//by nonterminal, the terminals its row gets through on
+	std::vector<char> usable;						//by production, whether the table can ever finish it
+	std::vector<uint64_t> minLength;				//by encoded symbol, the shortest nonempty sentence it derives
+	std::vector<std::vector<uint32_t>> vanishOn;	//by nonterminal, the terminals on which it expands to nothing
+	uint64_t state;
+};